@@ -0,0 +1,134 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_APICOMMANDS_HPP_
+#define INCLUDE_APICOMMANDS_HPP_
+
+#include <cstdint>
+#include <string_view>
+#include <algorithm>
+#include <iterator>
+
+enum ApiCommand : uint8_t
+{
+    CommandUnknown,
+    CommandData,
+    CommandGetRunningSchedule,
+    CommandGetPerf,
+    CommandSetTemp,
+    CommandSetOverrideOutput,
+    CommandStart,
+    CommandResume,
+    CommandDiscardResume,
+    CommandStartSimulation,
+    CommandStopSimulation,
+    CommandAutoTune,
+    CommandStartStir,
+    CommandStop,
+    CommandStopStir,
+    CommandGetMashSchedules,
+    CommandSaveMashSchedule,
+    CommandSetMashSchedule,
+    CommandDeleteMashSchedule,
+    CommandGetPIDSettings,
+    CommandSavePIDSettings,
+    CommandGetTempSettings,
+    CommandSaveTempSettings,
+    CommandDetectTempSensors,
+    CommandAddRtdSensor,
+    CommandAddNtcSensor,
+    CommandGetHeaterSettings,
+    CommandSaveHeaterSettings,
+    CommandGetVesselSettings,
+    CommandSaveVesselSettings,
+    CommandStartVessel,
+    CommandStopVessel,
+    CommandGetWifiSettings,
+    CommandSaveWifiSettings,
+    CommandScanWifi,
+    CommandGetSystemSettings,
+    CommandSaveSystemSettings,
+    CommandTestFirebase,
+    CommandReboot,
+    CommandFactoryReset,
+    CommandBootIntoRecovery,
+    CommandGetStatistics,
+    CommandGetSessionData,
+    CommandExportSession,
+    CommandSetStatisticsConfig,
+};
+
+struct ApiCommandEntry
+{
+    std::string_view name;
+    ApiCommand command;
+};
+
+// Sorted on name, so a lookup is a binary search instead of a compare against every command.
+static constexpr ApiCommandEntry apiCommands[] = {
+    {"AddNtcSensor", CommandAddNtcSensor},
+    {"AddRtdSensor", CommandAddRtdSensor},
+    {"AutoTune", CommandAutoTune},
+    {"BootIntoRecovery", CommandBootIntoRecovery},
+    {"Data", CommandData},
+    {"DeleteMashSchedule", CommandDeleteMashSchedule},
+    {"DetectTempSensors", CommandDetectTempSensors},
+    {"DiscardResume", CommandDiscardResume},
+    {"ExportSession", CommandExportSession},
+    {"FactoryReset", CommandFactoryReset},
+    {"GetHeaterSettings", CommandGetHeaterSettings},
+    {"GetMashSchedules", CommandGetMashSchedules},
+    {"GetPIDSettings", CommandGetPIDSettings},
+    {"GetPerf", CommandGetPerf},
+    {"GetRunningSchedule", CommandGetRunningSchedule},
+    {"GetSessionData", CommandGetSessionData},
+    {"GetStatistics", CommandGetStatistics},
+    {"GetSystemSettings", CommandGetSystemSettings},
+    {"GetTempSettings", CommandGetTempSettings},
+    {"GetVesselSettings", CommandGetVesselSettings},
+    {"GetWifiSettings", CommandGetWifiSettings},
+    {"Reboot", CommandReboot},
+    {"Resume", CommandResume},
+    {"SaveHeaterSettings", CommandSaveHeaterSettings},
+    {"SaveMashSchedule", CommandSaveMashSchedule},
+    {"SavePIDSettings", CommandSavePIDSettings},
+    {"SaveSystemSettings", CommandSaveSystemSettings},
+    {"SaveTempSettings", CommandSaveTempSettings},
+    {"SaveVesselSettings", CommandSaveVesselSettings},
+    {"SaveWifiSettings", CommandSaveWifiSettings},
+    {"ScanWifi", CommandScanWifi},
+    {"SetMashSchedule", CommandSetMashSchedule},
+    {"SetOverrideOutput", CommandSetOverrideOutput},
+    {"SetStatisticsConfig", CommandSetStatisticsConfig},
+    {"SetTemp", CommandSetTemp},
+    {"Start", CommandStart},
+    {"StartSimulation", CommandStartSimulation},
+    {"StartStir", CommandStartStir},
+    {"StartVessel", CommandStartVessel},
+    {"Stop", CommandStop},
+    {"StopSimulation", CommandStopSimulation},
+    {"StopStir", CommandStopStir},
+    {"StopVessel", CommandStopVessel},
+    {"TestFirebase", CommandTestFirebase},
+};
+
+static_assert(std::is_sorted(std::begin(apiCommands), std::end(apiCommands), [](const ApiCommandEntry &a, const ApiCommandEntry &b)
+                             { return a.name < b.name; }),
+              "apiCommands must be sorted on name");
+
+inline ApiCommand lookupApiCommand(std::string_view name)
+{
+    auto it = std::lower_bound(std::begin(apiCommands), std::end(apiCommands), name, [](const ApiCommandEntry &entry, std::string_view value)
+                               { return entry.name < value; });
+
+    if (it == std::end(apiCommands) || it->name != name)
+    {
+        return CommandUnknown;
+    }
+
+    return it->command;
+}
+
+#endif /* INCLUDE_APICOMMANDS_HPP_ */
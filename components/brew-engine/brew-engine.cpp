@@ -18,11 +18,17 @@ BrewEngine::BrewEngine(SettingsManager *settingsManager)
 	ESP_LOGI(TAG, "BrewEngine Construct");
 	this->settingsManager = settingsManager;
 	this->statisticsManager = new StatisticsManager(settingsManager);
+	this->sensorsMutex = xSemaphoreCreateRecursiveMutex();
 	mainInstance = this;
 }
 
 void BrewEngine::Init()
 {
+	this->bootStartedAt = esp_timer_get_time();
+
+	this->settingsManager->OnFlashWrite = [this](int64_t durationUs)
+	{ this->perf.record(PerfNvsWrite, durationUs); };
+
 	// read the post important settings first so when van set outputs asap.
 	this->readSystemSettings();
 
@@ -62,9 +68,31 @@ void BrewEngine::Init()
 		gpio_set_level(this->buzzer_PIN, this->gpioLow);
 	}
 
+	int64_t outputsReadyAt = esp_timer_get_time();
+
 	// read other settings like maishschedules and pid
 	this->readSettings();
 
+	int64_t settingsReadyAt = esp_timer_get_time();
+
+	// a checkpoint is only left behind when a schedule was running
+	json jCheckpoint = this->readJsonSetting("checkpoint", json::object());
+	if (!jCheckpoint.empty())
+	{
+		esp_reset_reason_t reason = esp_reset_reason();
+
+		if (reason == ESP_RST_SW || reason == ESP_RST_DEEPSLEEP)
+		{
+			// reboot on request, the user knows the schedule was stopped
+			this->clearCheckpoint();
+		}
+		else
+		{
+			ESP_LOGW(TAG, "Schedule %s was interrupted by a reset (reason %d), resume is available", jCheckpoint.value("schedule", "").c_str(), reason);
+			this->resumeCheckpoint = jCheckpoint;
+		}
+	}
+
 	// Initialize ADC for NTC sensors BEFORE loading temperature sensor settings
 	this->adcInitialized = false;
 	this->adc1_handle = nullptr;
@@ -121,28 +149,90 @@ void BrewEngine::Init()
 
 	this->readTempSensorSettings();
 
+	// vessels claim their sensors and heaters, so after both are known
+	this->readVesselSettings();
+
 	// Initialize NTC sensors loaded from settings
 	this->initNtcTemperatureSensors();
 
 	this->initOneWire();
 
-	this->detectOnewireTemperatureSensors();
+	// bring up the sensors we know from the last run, the full bus search runs in the background
+	this->restoreOnewireTemperatureSensors();
 
 	this->initRtdSensors();
 
 	this->detectRtdTemperatureSensors();
 
-	this->initMqtt();
-
-	this->initFirebase();
+	int64_t sensorsReadyAt = esp_timer_get_time();
 
 	this->statisticsManager->Init();
 
 	this->run = true;
 
+	// one task per bus, so a slow bus (e.g. RTD reinit) doesn't hold back the others
+	xTaskCreate(&this->onewireReadLoop, "onewireread_task", 4096, this, 5, NULL);
+	xTaskCreate(&this->rtdReadLoop, "rtdread_task", 4096, this, 5, NULL);
+	xTaskCreate(&this->ntcReadLoop, "ntcread_task", 4096, this, 5, NULL);
+
 	xTaskCreate(&this->readLoop, "readloop_task", 16384, this, 5, NULL);
+	xTaskCreate(&this->schedulerLoop, "scheduler_task", 4096, this, 5, &this->schedulerHandle);
+
+	int64_t loopsStartedAt = esp_timer_get_time();
+
+	// neither is needed to control the heaters, so they don't hold back the boot
+	xTaskCreate(&this->sensorDetectTask, "sensordetect_task", 4096, this, 4, NULL);
+	xTaskCreate(&this->networkInitTask, "netinit_task", 8192, this, 4, NULL);
 
 	this->server = this->startWebserver();
+
+	if (this->server != NULL)
+	{
+		xTaskCreate(&this->pushLoop, "push_task", 8192, this, 5, NULL);
+	}
+
+	ESP_LOGI(TAG, "Boot timing: outputs %lld ms, settings %lld ms, sensors %lld ms, loops started %lld ms, webserver %lld ms",
+			 (outputsReadyAt - this->bootStartedAt) / 1000, (settingsReadyAt - outputsReadyAt) / 1000, (sensorsReadyAt - settingsReadyAt) / 1000,
+			 (loopsStartedAt - sensorsReadyAt) / 1000, (esp_timer_get_time() - loopsStartedAt) / 1000);
+}
+
+// Full 1-Wire search, finds sensors that were added or replaced since the last run
+void BrewEngine::sensorDetectTask(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	int64_t startedAt = esp_timer_get_time();
+
+	instance->detectOnewireTemperatureSensors();
+
+	ESP_LOGI(TAG, "Boot timing: sensor detection done in %lld ms", (esp_timer_get_time() - startedAt) / 1000);
+
+	vTaskDelete(NULL);
+}
+
+void BrewEngine::networkInitTask(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	int64_t startedAt = esp_timer_get_time();
+
+	instance->initMqtt();
+
+	if (instance->mqttEnabled && instance->run)
+	{
+		xTaskCreate(&instance->mqttTelemetryLoop, "mqtt_task", 4096, instance, 4, NULL);
+	}
+
+	instance->initFirebase();
+
+	if (instance->firebaseQueue != NULL && instance->run)
+	{
+		xTaskCreate(&instance->firebaseUplinkLoop, "firebase_task", 8192, instance, 4, NULL);
+	}
+
+	ESP_LOGI(TAG, "Boot timing: network services ready in %lld ms", (esp_timer_get_time() - startedAt) / 1000);
+
+	vTaskDelete(NULL);
 }
 
 void BrewEngine::initHeaters()
@@ -212,9 +302,22 @@ void BrewEngine::readSystemSettings()
 	configInvertOutputs = true;
 #endif
 	this->invertOutputs = this->settingsManager->Read("invertOutputs", configInvertOutputs);
+	this->outputMode = (OutputMode)this->settingsManager->Read("outputMode", (uint8_t)TimeProportional);
+	if (this->outputMode != TimeProportional && this->outputMode != BurstFire)
+	{
+		this->outputMode = TimeProportional;
+	}
+	this->mainsFrequency = this->settingsManager->Read("mainsFreq", (uint8_t)50);
+	if (this->mainsFrequency != 50 && this->mainsFrequency != 60)
+	{
+		this->mainsFrequency = 50; // burst fire divides by it
+	}
+	this->maxPower = this->settingsManager->Read("maxPower", (uint16_t)0);
 
 	// mqtt
 	this->mqttUri = this->settingsManager->Read("mqttUri", (string)CONFIG_MQTT_URI);
+	this->mqttDeadband = this->settingsManager->Read("mqttDeadband", (uint8_t)2);
+	this->mqttMinInterval = this->settingsManager->Read("mqttMinInt", (uint16_t)5);
 
 	// Firebase (using short key names due to NVS 15-char limit)
 	// Migrate from old long key names if they exist
@@ -258,10 +361,22 @@ void BrewEngine::readSystemSettings()
 	ESP_LOGI(TAG, "Reading System Settings Done");
 }
 
-void BrewEngine::saveSystemSettingsJson(const json &config)
+string BrewEngine::saveSystemSettingsJson(const json &config)
 {
 	ESP_LOGI(TAG, "Saving System Settings");
 
+	// the output timer only knows these modes, refuse the whole save so nothing is half written
+	if (!config["outputMode"].is_null())
+	{
+		if (!config["outputMode"].is_number_unsigned() || (config["outputMode"] != TimeProportional && config["outputMode"] != BurstFire))
+		{
+			return "Incorrect outputMode, TimeProportional (0) or BurstFire (1) expected!";
+		}
+	}
+
+	// all changed settings are written with a single nvs commit
+	this->settingsManager->Begin();
+
 	if (!config["onewirePin"].is_null() && config["onewirePin"].is_number())
 	{
 		this->settingsManager->Write("onewirePin", (uint16_t)config["onewirePin"]);
@@ -287,11 +402,50 @@ void BrewEngine::saveSystemSettingsJson(const json &config)
 		this->settingsManager->Write("invertOutputs", (bool)config["invertOutputs"]);
 		this->invertOutputs = (bool)config["invertOutputs"];
 	}
+	if (!config["outputMode"].is_null())
+	{
+		this->settingsManager->Write("outputMode", (uint8_t)config["outputMode"]);
+		this->outputMode = (OutputMode)config["outputMode"];
+	}
+	if (!config["mainsFrequency"].is_null() && config["mainsFrequency"].is_number())
+	{
+		uint8_t frequency = config["mainsFrequency"];
+		// only 50 and 60Hz grids exist
+		if (frequency == 50 || frequency == 60)
+		{
+			this->settingsManager->Write("mainsFreq", frequency);
+			this->mainsFrequency = frequency;
+		}
+	}
+	if (!config["maxPower"].is_null() && config["maxPower"].is_number_unsigned())
+	{
+		this->settingsManager->Write("maxPower", (uint16_t)config["maxPower"]);
+		this->maxPower = (uint16_t)config["maxPower"];
+	}
 	if (!config["mqttUri"].is_null() && config["mqttUri"].is_string())
 	{
 		this->settingsManager->Write("mqttUri", (string)config["mqttUri"]);
 		this->mqttUri = config["mqttUri"];
 	}
+	if (!config["mqttDeadband"].is_null() && config["mqttDeadband"].is_number())
+	{
+		// api is in degrees, we store tenths
+		float deadband = config["mqttDeadband"];
+		if (deadband >= 0 && deadband <= 25)
+		{
+			this->mqttDeadband = (uint8_t)lroundf(deadband * 10);
+			this->settingsManager->Write("mqttDeadband", this->mqttDeadband);
+		}
+	}
+	if (!config["mqttMinInterval"].is_null() && config["mqttMinInterval"].is_number())
+	{
+		uint16_t interval = config["mqttMinInterval"];
+		if (interval <= MQTT_HEARTBEAT_S)
+		{
+			this->settingsManager->Write("mqttMinInt", interval);
+			this->mqttMinInterval = interval;
+		}
+	}
 	
 	// Firebase configuration (using short key names due to NVS 15-char limit)
 	if (!config["firebaseUrl"].is_null() && config["firebaseUrl"].is_string())
@@ -445,17 +599,55 @@ void BrewEngine::saveSystemSettingsJson(const json &config)
 		this->spi_cs_pin = (gpio_num_t)config["spiCsPin"];
 	}
 
+	this->settingsManager->Commit();
+
 	ESP_LOGI(TAG, "Saving System Settings Done");
+
+	return "";
+}
+
+// Json settings are stored as msgpack, older firmware and manual imports stored them as json text.
+// Text values are converted once, so the next boot reads the binary form.
+json BrewEngine::readJsonSetting(const string &name, const json &defaultValue)
+{
+	string text;
+
+	if (this->settingsManager->IsText(name))
+	{
+		text = this->settingsManager->Read(name, string(""));
+	}
+	else
+	{
+		vector<uint8_t> serialized = this->settingsManager->Read(name, json::to_msgpack(defaultValue));
+
+		json value = json::from_msgpack(serialized, true, false);
+		if (!value.is_discarded())
+		{
+			return value;
+		}
+
+		// long strings end up as blob including the terminator
+		text = string(serialized.begin(), find(serialized.begin(), serialized.end(), '\0'));
+	}
+
+	json value = json::parse(text, nullptr, false);
+	if (value.is_discarded())
+	{
+		ESP_LOGE(TAG, "Setting %s is not valid, using default", name.c_str());
+		return defaultValue;
+	}
+
+	ESP_LOGI(TAG, "Migrating setting %s from text to msgpack", name.c_str());
+	this->settingsManager->Write(name, json::to_msgpack(value));
+
+	return value;
 }
 
 void BrewEngine::readSettings()
 {
 	ESP_LOGI(TAG, "Reading Settings");
 
-	vector<uint8_t> empty = json::to_msgpack(json::array({}));
-	vector<uint8_t> serialized = this->settingsManager->Read("mashschedules", empty);
-
-	json jSchedules = json::from_msgpack(serialized);
+	json jSchedules = this->readJsonSetting("mashschedules", json::array({}));
 
 	if (jSchedules.empty())
 	{
@@ -469,13 +661,25 @@ void BrewEngine::readSettings()
 		{
 			json jSchedule = el.value();
 
-			auto schedule = new MashSchedule();
-			schedule->from_json(jSchedule);
+			if (this->mashSchedules.size() >= MAX_MASH_SCHEDULES)
+			{
+				ESP_LOGW(TAG, "Only %d schedules supported, skipping the rest!", MAX_MASH_SCHEDULES);
+				break;
+			}
+
+			auto schedule = this->schedulePool.create();
+
+			if (!schedule->from_json(jSchedule, this->stepPool, this->notificationPool))
+			{
+				ESP_LOGW(TAG, "Schedule %s doesn't fit, steps or notifications are missing!", schedule->name.c_str());
+			}
 
 			this->mashSchedules.insert_or_assign(schedule->name, schedule);
 		}
 	}
 
+	this->readThermalModel();
+
 	// we save and load pid doubles as unit16 becease nvs doesnt' have double support, and we are happy with only 1 decimal
 	uint16_t pint = this->settingsManager->Read("kP", (uint16_t)(this->mashkP * 10));
 	uint16_t iint = this->settingsManager->Read("kI", (uint16_t)(this->mashkI * 10));
@@ -499,25 +703,38 @@ void BrewEngine::readSettings()
 	this->boostModeUntil = this->settingsManager->Read("boostModeUntil", (uint8_t)this->boostModeUntil);
 }
 
-void BrewEngine::setMashSchedule(const json &jSchedule)
+// Returns an error message when the schedule doesn't fit in the pools, the old schedule is then kept
+string BrewEngine::setMashSchedule(const json &jSchedule)
 {
 	json newSteps = jSchedule["steps"];
 
-	auto newMash = new MashSchedule();
-	newMash->name = jSchedule["name"].get<string>();
-	newMash->boil = jSchedule["boil"].get<bool>();
+	string name = jSchedule["name"].get<string>();
+
+	auto existing = this->mashSchedules.find(name);
+	if (existing == this->mashSchedules.end() && this->mashSchedules.size() >= MAX_MASH_SCHEDULES)
+	{
+		return "Only " + to_string(MAX_MASH_SCHEDULES) + " schedules can be saved!";
+	}
 
-	for (auto const &step : newMash->steps)
+	auto newMash = this->schedulePool.create();
+	if (newMash == nullptr)
 	{
-		delete step;
+		return "Only " + to_string(MAX_MASH_SCHEDULES) + " schedules can be saved!";
 	}
-	newMash->steps.clear();
+
+	newMash->name = name;
+	newMash->boil = jSchedule["boil"].get<bool>();
 
 	for (auto &el : newSteps.items())
 	{
 		auto jStep = el.value();
 
-		auto newStep = new MashStep();
+		auto newStep = this->stepPool.create();
+		if (newStep == nullptr)
+		{
+			this->releaseMashSchedule(newMash);
+			return "Not enough room for the steps, only " + to_string(MAX_MASH_STEPS) + " steps over all schedules!";
+		}
 		newStep->from_json(jStep);
 		newMash->steps.push_back(newStep);
 	}
@@ -525,24 +742,46 @@ void BrewEngine::setMashSchedule(const json &jSchedule)
 	newMash->sort_steps();
 
 	json newNotifications = jSchedule["notifications"];
-	for (auto const &notification : newMash->notifications)
+
+	// a run copies them, it has room for this many
+	if (newNotifications.size() > MAX_SCHEDULE_NOTIFICATIONS)
 	{
-		delete notification;
+		this->releaseMashSchedule(newMash);
+		return "Only " + to_string(MAX_SCHEDULE_NOTIFICATIONS) + " notifications per schedule!";
 	}
-	newMash->notifications.clear();
 
 	for (auto &el : newNotifications.items())
 	{
 		auto jNotification = el.value();
 
-		auto newNotification = new Notification();
+		auto newNotification = this->notificationPool.create();
+		if (newNotification == nullptr)
+		{
+			this->releaseMashSchedule(newMash);
+			return "Not enough room for the notifications, only " + to_string(MAX_NOTIFICATIONS) + " notifications over all schedules!";
+		}
 		newNotification->from_json(jNotification);
 		newMash->notifications.push_back(newNotification);
 	}
 
 	newMash->sort_notifications();
 
+	MashSchedule *oldMash = (existing != this->mashSchedules.end()) ? existing->second : nullptr;
+
 	this->mashSchedules.insert_or_assign(newMash->name, newMash);
+
+	if (oldMash != nullptr)
+	{
+		this->releaseMashSchedule(oldMash);
+	}
+
+	return "";
+}
+
+void BrewEngine::releaseMashSchedule(MashSchedule *schedule)
+{
+	schedule->clear(this->stepPool, this->notificationPool);
+	this->schedulePool.destroy(schedule);
 }
 
 void BrewEngine::saveMashSchedules()
@@ -568,10 +807,32 @@ void BrewEngine::saveMashSchedules()
 	ESP_LOGI(TAG, "Saving Mash Schedules Done, %d bytes", serialized.size());
 }
 
+void BrewEngine::readThermalModel()
+{
+	this->thermalModel.from_json(this->readJsonSetting("thermalmodel", json::object()));
+
+	if (this->thermalModel.samples == 0)
+	{
+		// start from room temperature
+		this->thermalModel.ambient = (this->temperatureScale == Celsius) ? 20 : 68;
+	}
+
+	ESP_LOGI(TAG, "Thermal model: gain %.5f loss %.6f samples %lu", this->thermalModel.gain, this->thermalModel.loss, this->thermalModel.samples);
+}
+
+void BrewEngine::saveThermalModel()
+{
+	vector<uint8_t> serialized = json::to_msgpack(this->thermalModel.to_json());
+
+	this->settingsManager->Write("thermalmodel", serialized);
+}
+
 void BrewEngine::savePIDSettings()
 {
 	ESP_LOGI(TAG, "Saving PID Settings");
 
+	this->settingsManager->Begin();
+
 	uint16_t pint = static_cast<uint16_t>(this->mashkP * 10);
 	uint16_t iint = static_cast<uint16_t>(this->mashkI * 10);
 	uint16_t dint = static_cast<uint16_t>(this->mashkD * 10);
@@ -593,16 +854,19 @@ void BrewEngine::savePIDSettings()
 
 	this->settingsManager->Write("boostModeUntil", this->boostModeUntil);
 
+	this->settingsManager->Commit();
+
 	ESP_LOGI(TAG, "Saving PID Settings Done");
 }
 
+// only used on a first boot, the pools are still empty so everything fits
 void BrewEngine::addDefaultMash()
 {
-	auto defaultMash = new MashSchedule();
+	auto defaultMash = this->schedulePool.create();
 	defaultMash->name = "Default";
 	defaultMash->boil = false;
 
-	auto defaultMash_s1 = new MashStep();
+	auto defaultMash_s1 = this->stepPool.create();
 	defaultMash_s1->index = 0;
 	defaultMash_s1->name = "Beta Amylase";
 	defaultMash_s1->temperature = (this->temperatureScale == Celsius) ? 64 : 150;
@@ -612,7 +876,7 @@ void BrewEngine::addDefaultMash()
 	defaultMash_s1->time = 45;
 	defaultMash->steps.push_back(defaultMash_s1);
 
-	auto defaultMash_s2 = new MashStep();
+	auto defaultMash_s2 = this->stepPool.create();
 	defaultMash_s2->index = 1;
 	defaultMash_s2->name = "Alpha Amylase";
 	defaultMash_s2->temperature = (this->temperatureScale == Celsius) ? 72 : 160;
@@ -622,7 +886,7 @@ void BrewEngine::addDefaultMash()
 	defaultMash_s2->time = 20;
 	defaultMash->steps.push_back(defaultMash_s2);
 
-	auto defaultMash_s3 = new MashStep();
+	auto defaultMash_s3 = this->stepPool.create();
 	defaultMash_s3->index = 2;
 	defaultMash_s3->name = "Mash Out";
 	defaultMash_s3->temperature = (this->temperatureScale == Celsius) ? 78 : 170;
@@ -632,14 +896,14 @@ void BrewEngine::addDefaultMash()
 	defaultMash_s3->time = 5;
 	defaultMash->steps.push_back(defaultMash_s3);
 
-	auto defaultMash_n1 = new Notification();
+	auto defaultMash_n1 = this->notificationPool.create();
 	defaultMash_n1->name = "Add Grains";
 	defaultMash_n1->message = "Please add Grains";
 	defaultMash_n1->timeFromStart = 5;
 	defaultMash_n1->buzzer = true;
 	defaultMash->notifications.push_back(defaultMash_n1);
 
-	auto defaultMash_n2 = new Notification();
+	auto defaultMash_n2 = this->notificationPool.create();
 	defaultMash_n2->name = "Start Lautering";
 	defaultMash_n2->message = "Please Start Lautering/Sparging";
 	defaultMash_n2->timeFromStart = 85;
@@ -648,11 +912,11 @@ void BrewEngine::addDefaultMash()
 
 	this->mashSchedules.insert_or_assign(defaultMash->name, defaultMash);
 
-	auto ryeMash = new MashSchedule();
+	auto ryeMash = this->schedulePool.create();
 	ryeMash->name = "Rye Mash";
 	ryeMash->boil = false;
 
-	auto ryeMash_s1 = new MashStep();
+	auto ryeMash_s1 = this->stepPool.create();
 	ryeMash_s1->index = 0;
 	ryeMash_s1->name = "Beta Glucanase";
 	ryeMash_s1->temperature = (this->temperatureScale == Celsius) ? 43 : 110;
@@ -662,7 +926,7 @@ void BrewEngine::addDefaultMash()
 	ryeMash_s1->time = 20;
 	ryeMash->steps.push_back(ryeMash_s1);
 
-	auto ryeMash_s2 = new MashStep();
+	auto ryeMash_s2 = this->stepPool.create();
 	ryeMash_s2->index = 1;
 	ryeMash_s2->name = "Beta Amylase";
 	ryeMash_s2->temperature = (this->temperatureScale == Celsius) ? 64 : 150;
@@ -672,7 +936,7 @@ void BrewEngine::addDefaultMash()
 	ryeMash_s2->time = 45;
 	ryeMash->steps.push_back(ryeMash_s2);
 
-	auto ryeMash_s3 = new MashStep();
+	auto ryeMash_s3 = this->stepPool.create();
 	ryeMash_s3->index = 2;
 	ryeMash_s3->name = "Alpha Amylase";
 	ryeMash_s3->temperature = (this->temperatureScale == Celsius) ? 72 : 160;
@@ -682,7 +946,7 @@ void BrewEngine::addDefaultMash()
 	ryeMash_s3->time = 20;
 	ryeMash->steps.push_back(ryeMash_s3);
 
-	auto ryeMash_s4 = new MashStep();
+	auto ryeMash_s4 = this->stepPool.create();
 	ryeMash_s4->index = 3;
 	ryeMash_s4->name = "Mash Out";
 	ryeMash_s4->temperature = (this->temperatureScale == Celsius) ? 78 : 170;
@@ -692,14 +956,14 @@ void BrewEngine::addDefaultMash()
 	ryeMash_s4->time = 5;
 	ryeMash->steps.push_back(ryeMash_s4);
 
-	auto ryeMash_n1 = new Notification();
+	auto ryeMash_n1 = this->notificationPool.create();
 	ryeMash_n1->name = "Add Grains";
 	ryeMash_n1->message = "Please add Grains";
 	ryeMash_n1->timeFromStart = 5;
 	ryeMash_n1->buzzer = true;
 	ryeMash->notifications.push_back(ryeMash_n1);
 
-	auto ryeMash_n2 = new Notification();
+	auto ryeMash_n2 = this->notificationPool.create();
 	ryeMash_n2->name = "Start Lautering";
 	ryeMash_n2->message = "Please Start Lautering/Sparging";
 	ryeMash_n2->timeFromStart = 110;
@@ -708,11 +972,11 @@ void BrewEngine::addDefaultMash()
 
 	this->mashSchedules.insert_or_assign(ryeMash->name, ryeMash);
 
-	auto boil = new MashSchedule();
+	auto boil = this->schedulePool.create();
 	boil->name = "Boil 70 Min";
 	boil->boil = true;
 
-	auto boil_s1 = new MashStep();
+	auto boil_s1 = this->stepPool.create();
 	boil_s1->index = 0;
 	boil_s1->name = "Boil";
 	boil_s1->temperature = (this->temperatureScale == Celsius) ? 101 : 214;
@@ -721,14 +985,14 @@ void BrewEngine::addDefaultMash()
 	boil_s1->time = 70;
 	boil->steps.push_back(boil_s1);
 
-	auto boil_n1 = new Notification();
+	auto boil_n1 = this->notificationPool.create();
 	boil_n1->name = "Bittering Hops";
 	boil_n1->message = "Please add Bittering Hops";
 	boil_n1->timeFromStart = 0;
 	boil_n1->buzzer = true;
 	boil->notifications.push_back(boil_n1);
 
-	auto boil_n2 = new Notification();
+	auto boil_n2 = this->notificationPool.create();
 	boil_n2->name = "Aroma Hops";
 	boil_n2->message = "Please add Aroma Hops";
 	boil_n2->timeFromStart = 55;
@@ -740,7 +1004,7 @@ void BrewEngine::addDefaultMash()
 
 void BrewEngine::addDefaultHeaters()
 {
-	auto defaultHeater1 = new Heater();
+	auto defaultHeater1 = this->heaterPool.create();
 	defaultHeater1->id = 1;
 	defaultHeater1->name = "Heater 1";
 	defaultHeater1->pinNr = (gpio_num_t)CONFIG_HEAT1;
@@ -751,7 +1015,7 @@ void BrewEngine::addDefaultHeaters()
 
 	this->heaters.push_back(defaultHeater1);
 
-	auto defaultHeater2 = new Heater();
+	auto defaultHeater2 = this->heaterPool.create();
 	defaultHeater2->id = 2;
 	defaultHeater2->name = "Heater 2";
 	defaultHeater2->pinNr = (gpio_num_t)CONFIG_HEAT2;
@@ -764,10 +1028,7 @@ void BrewEngine::addDefaultHeaters()
 
 void BrewEngine::readHeaterSettings()
 {
-	vector<uint8_t> empty = json::to_msgpack(json::array({}));
-	vector<uint8_t> serialized = this->settingsManager->Read("heaters", empty);
-
-	json jHeaters = json::from_msgpack(serialized);
+	json jHeaters = this->readJsonSetting("heaters", json::array({}));
 
 	if (jHeaters.empty())
 	{
@@ -781,7 +1042,12 @@ void BrewEngine::readHeaterSettings()
 		{
 			auto jHeater = el.value();
 
-			auto heater = new Heater();
+			auto heater = this->heaterPool.create();
+			if (heater == nullptr)
+			{
+				ESP_LOGE(TAG, "Only %d heaters supported!", MAX_HEATERS);
+				break;
+			}
 			heater->from_json(jHeater);
 
 			ESP_LOGI(TAG, "Heater From Settings ID:%d", heater->id);
@@ -811,7 +1077,7 @@ void BrewEngine::saveHeaterSettings(const json &jHeaters)
 	// clear
 	for (auto const &heater : this->heaters)
 	{
-		delete heater;
+		this->heaterPool.destroy(heater);
 	}
 	this->heaters.clear();
 
@@ -822,16 +1088,16 @@ void BrewEngine::saveHeaterSettings(const json &jHeaters)
 	{
 		newId++;
 
-		if (newId > 10)
+		if (newId > MAX_HEATERS)
 		{
-			ESP_LOGE(TAG, "Only 10 heaters supported!");
+			ESP_LOGE(TAG, "Only %d heaters supported!", MAX_HEATERS);
 			continue;
 		}
 
 		auto jHeater = el.value();
 		jHeater["id"] = newId;
 
-		auto heater = new Heater();
+		auto heater = this->heaterPool.create();
 		heater->from_json(jHeater);
 		heater->id = newId;
 
@@ -850,21 +1116,131 @@ void BrewEngine::saveHeaterSettings(const json &jHeaters)
 	// re-init so they can be used
 	this->initHeaters();
 
+	// new heater objects, the vessels need to claim theirs again
+	this->assignVessels();
+
 	ESP_LOGI(TAG, "Saving Heater Settings Done");
 }
 
-void BrewEngine::readTempSensorSettings()
+void BrewEngine::readVesselSettings()
+{
+	json jVessels = this->readJsonSetting("vessels", json::array({}));
+
+	for (auto &el : jVessels.items())
+	{
+		auto vessel = new Vessel();
+		vessel->from_json(el.value());
+
+		ESP_LOGI(TAG, "Vessel From Settings ID:%d %s", vessel->id, vessel->name.c_str());
+
+		this->vessels.push_back(vessel);
+	}
+
+	this->assignVessels();
+}
+
+void BrewEngine::saveVesselSettings(const json &jVessels)
+{
+	ESP_LOGI(TAG, "Saving Vessel Settings");
+
+	if (!jVessels.is_array())
+	{
+		ESP_LOGW(TAG, "Vessel settings must be an array!");
+		return;
+	}
+
+	for (auto const &vessel : this->vessels)
+	{
+		delete vessel;
+	}
+	this->vessels.clear();
+
+	json jSaved = json::array({});
+	uint8_t newId = 0;
+
+	for (auto &el : jVessels.items())
+	{
+		newId++;
+
+		if (newId > MAX_VESSELS)
+		{
+			ESP_LOGE(TAG, "Only %d vessels supported!", MAX_VESSELS);
+			break;
+		}
+
+		auto jVessel = el.value();
+		jVessel["id"] = newId;
+
+		auto vessel = new Vessel();
+		vessel->from_json(jVessel);
+
+		this->vessels.push_back(vessel);
+		jSaved.push_back(vessel->to_json());
+	}
+
+	vector<uint8_t> serialized = json::to_msgpack(jSaved);
+	this->settingsManager->Write("vessels", serialized);
+
+	this->assignVessels();
+
+	ESP_LOGI(TAG, "Saving Vessel Settings Done");
+}
+
+// Marks the sensors and heaters with the vessel that claims them, everything else stays with the main kettle
+void BrewEngine::assignVessels()
 {
-	vector<uint8_t> empty = json::to_msgpack(json::array({}));
-	vector<uint8_t> serialized = this->settingsManager->Read("tempsensors", empty);
+	xSemaphoreTakeRecursive(this->sensorsMutex, portMAX_DELAY);
+
+	for (auto &heater : this->heaters)
+	{
+		heater->vessel = 0;
+	}
+
+	for (auto const &[key, sensor] : this->sensors)
+	{
+		sensor->vessel = 0;
+	}
+
+	for (auto const &vessel : this->vessels)
+	{
+		for (auto const &heaterId : vessel->heaters)
+		{
+			for (auto &heater : this->heaters)
+			{
+				if (heater->id == heaterId)
+				{
+					heater->vessel = vessel->id;
+				}
+			}
+		}
+
+		for (auto const &sensorId : vessel->sensors)
+		{
+			auto it = this->sensors.find(sensorId);
+			if (it != this->sensors.end())
+			{
+				it->second->vessel = vessel->id;
+			}
+		}
+	}
+
+	xSemaphoreGiveRecursive(this->sensorsMutex);
+}
 
-	json jTempSensors = json::from_msgpack(serialized);
+void BrewEngine::readTempSensorSettings()
+{
+	json jTempSensors = this->readJsonSetting("tempsensors", json::array({}));
 
 	for (auto &el : jTempSensors.items())
 	{
 		auto jSensor = el.value();
 
-		auto sensor = new TemperatureSensor();
+		auto sensor = this->sensorPool.create();
+		if (sensor == nullptr)
+		{
+			ESP_LOGE(TAG, "Only %d temperature sensors supported!", MAX_TEMP_SENSORS);
+			break;
+		}
 		sensor->from_json(jSensor);
 
 		uint64_t sensorId = sensor->id;
@@ -885,9 +1261,8 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		return;
 	}
 
-	// we need to temp stop our temp read loop while we change the sensor data
-	this->skipTempLoop = true;
-	vTaskDelay(pdMS_TO_TICKS(2000));
+	// the bus tasks wait while we change the sensors and their handles
+	xSemaphoreTakeRecursive(this->sensorsMutex, portMAX_DELAY);
 
 	// First pass: collect CS pin changes for RTD sensors and analog pin changes for NTC sensors
 	struct CsPinChange {
@@ -1033,11 +1408,23 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 				}
 			}
 			
+			// filters don't depend on the pins, so they apply right away, the bus task never sees a half copied filter
+			SensorFilter filter = TemperatureSensor::filterFromJson(jSensor);
+			portENTER_CRITICAL(&this->filterLock);
+			sensor->filter = filter;
+			portEXIT_CRITICAL(&this->filterLock);
+			sensor->weight = TemperatureSensor::weightFromJson(jSensor);
+			if (sensor->sensorType == SENSOR_NTC && jSensor["oversample"].is_number_integer() &&
+				jSensor["oversample"] >= 1 && jSensor["oversample"] <= 64)
+			{
+				sensor->oversample = (uint8_t)jSensor["oversample"];
+			}
+
 			// Update other sensor properties (skip if CS pin change or analog pin change is queued)
 			if (!hasCsPinChange && !hasAnalogPinChange)
 			{
-				sensor->name = jSensor["name"];
-				sensor->color = jSensor["color"];
+				sensor->name = jSensor["name"].get<string>();
+				sensor->color = jSensor["color"].get<string>();
 
 				if (!jSensor["useForControl"].is_null() && jSensor["useForControl"].is_boolean())
 				{
@@ -1047,12 +1434,6 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 				if (!jSensor["show"].is_null() && jSensor["show"].is_boolean())
 				{
 					sensor->show = jSensor["show"];
-
-					if (!sensor->show)
-					{
-						// when show is disabled we also remove it from current, so it doesn't showup anymore
-						this->currentTemperatures.erase(sensorId);
-					}
 				}
 
 				if (!jSensor["compensateAbsolute"].is_null() && jSensor["compensateAbsolute"].is_number())
@@ -1064,6 +1445,17 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 				{
 					sensor->compensateRelative = (float)jSensor["compensateRelative"];
 				}
+
+				if (sensor->sensorType == SENSOR_DS18B20 && jSensor["resolution"].is_number_integer() &&
+					jSensor["resolution"] >= 9 && jSensor["resolution"] <= 12 && jSensor["resolution"] != sensor->resolution)
+				{
+					sensor->resolution = (uint8_t)jSensor["resolution"];
+
+					if (sensor->ds18b20Handle)
+					{
+						ds18b20_set_resolution(sensor->ds18b20Handle, (ds18b20_resolution_t)(sensor->resolution - 9));
+					}
+				}
 			}
 		}
 	}
@@ -1084,7 +1476,7 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 				{
 					spi_bus_remove_device((*rtdIt)->spi);
 				}
-				delete *rtdIt;
+				this->rtdPool.destroy(*rtdIt);
 				this->rtdSensors.erase(rtdIt);
 				this->rtdSensorCount--;
 				break;
@@ -1096,8 +1488,9 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		memset(&sensor->max31865Handle, 0, sizeof(max31865_t));
 		
 		// Try to initialize with new CS pin
-		max31865_t *rtd_sensor = new max31865_t;
-		esp_err_t ret = max31865_init_desc(rtd_sensor, SPI2_HOST, change.newCsPin);
+		// the pool is sized for MAX_RTD_SENSORS, when it is full the init fails like a missing board
+		max31865_t *rtd_sensor = this->rtdPool.create();
+		esp_err_t ret = (rtd_sensor != nullptr) ? max31865_init_desc(rtd_sensor, SPI2_HOST, change.newCsPin) : ESP_ERR_NO_MEM;
 		
 		bool hardwareSuccess = false;
 		if (ret == ESP_OK)
@@ -1117,13 +1510,13 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 			else
 			{
 				ESP_LOGE(TAG, "Failed to configure RTD sensor on new CS pin %d: %s", change.newCsPin, esp_err_to_name(ret));
-				delete rtd_sensor;
+				this->rtdPool.destroy(rtd_sensor);
 			}
 		}
 		else
 		{
 			ESP_LOGE(TAG, "Failed to initialize RTD sensor on new CS pin %d: %s", change.newCsPin, esp_err_to_name(ret));
-			delete rtd_sensor;
+			this->rtdPool.destroy(rtd_sensor);
 		}
 		
 		if (!hardwareSuccess)
@@ -1135,8 +1528,8 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		
 		// Update sensor properties
 		auto jSensor = change.sensorData;
-		sensor->name = jSensor["name"];
-		sensor->color = jSensor["color"];
+		sensor->name = jSensor["name"].get<string>();
+		sensor->color = jSensor["color"].get<string>();
 
 		if (!jSensor["useForControl"].is_null() && jSensor["useForControl"].is_boolean())
 		{
@@ -1146,12 +1539,6 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		if (!jSensor["show"].is_null() && jSensor["show"].is_boolean())
 		{
 			sensor->show = jSensor["show"];
-
-			if (!sensor->show)
-			{
-				// when show is disabled we also remove it from current, so it doesn't showup anymore
-				this->currentTemperatures.erase(sensor->id);
-			}
 		}
 
 		if (!jSensor["compensateAbsolute"].is_null() && jSensor["compensateAbsolute"].is_number())
@@ -1166,7 +1553,6 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		
 		// Update sensor mappings
 		this->sensors.erase(change.oldSensorId);
-		this->currentTemperatures.erase(change.oldSensorId);
 		this->sensors.insert_or_assign(sensor->id, sensor);
 	}
 	
@@ -1194,8 +1580,8 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		}
 		
 		// Update other sensor properties
-		sensor->name = jSensor["name"];
-		sensor->color = jSensor["color"];
+		sensor->name = jSensor["name"].get<string>();
+		sensor->color = jSensor["color"].get<string>();
 
 		if (!jSensor["useForControl"].is_null() && jSensor["useForControl"].is_boolean())
 		{
@@ -1205,12 +1591,6 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		if (!jSensor["show"].is_null() && jSensor["show"].is_boolean())
 		{
 			sensor->show = jSensor["show"];
-
-			if (!sensor->show)
-			{
-				// when show is disabled we also remove it from current, so it doesn't showup anymore
-				this->currentTemperatures.erase(sensor->id);
-			}
 		}
 
 		if (!jSensor["compensateAbsolute"].is_null() && jSensor["compensateAbsolute"].is_number())
@@ -1225,7 +1605,6 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		
 		// Update sensor mappings
 		this->sensors.erase(change.oldSensorId);
-		this->currentTemperatures.erase(change.oldSensorId);
 		this->sensors.insert_or_assign(sensor->id, sensor);
 		
 		ESP_LOGI(TAG, "NTC sensor %s successfully moved to analog pin %d", sensor->name.c_str(), change.newAnalogPin);
@@ -1277,7 +1656,6 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 		{
 			ESP_LOGI(TAG, "Erasing Sensor %llu", sensorId);
 			sensorsToDelete.push_back(sensorId);
-			this->currentTemperatures.erase(sensorId);
 		}
 	}
 
@@ -1301,7 +1679,7 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 						{
 							spi_bus_remove_device((*rtdIt)->spi);
 						}
-						delete *rtdIt;
+						this->rtdPool.destroy(*rtdIt);
 						this->rtdSensors.erase(rtdIt);
 						this->rtdSensorCount--;
 						break;
@@ -1309,7 +1687,11 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 				}
 			}
 		}
-		this->sensors.erase(sensorId);
+		if (sensorIt != this->sensors.end())
+		{
+			this->sensorPool.destroy(sensorIt->second);
+			this->sensors.erase(sensorIt);
+		}
 	}
 
 	// // Convert sensors to json and save to nvram
@@ -1326,8 +1708,10 @@ void BrewEngine::saveTempSensorSettings(const json &jTempSensors)
 
 	this->settingsManager->Write("tempsensors", serialized);
 
-	// continue our temp loop
-	this->skipTempLoop = false;
+	// pin changes give sensors a new id, the vessels claim them again
+	this->assignVessels();
+
+	xSemaphoreGiveRecursive(this->sensorsMutex);
 
 	ESP_LOGI(TAG, "Saving Temp Sensor Settings Done");
 }
@@ -1364,6 +1748,8 @@ void BrewEngine::initMqtt()
 	// we create a topic and just post all out data to runningLog, more complex configuration can follow in the future
 	this->mqttTopic = "esp-brew-engine/" + this->Hostname + "/history";
 	this->mqttTopicLog = "esp-brew-engine/" + this->Hostname + "/log";
+	this->mqttTopicTelemetry = "esp-brew-engine/" + this->Hostname + "/telemetry/";
+	this->mqttTopicDiagnostics = "esp-brew-engine/" + this->Hostname + "/diagnostics";
 	this->mqttEnabled = true;
 
 	ESP_LOGI(TAG, "initMqtt: Done");
@@ -1423,6 +1809,9 @@ void BrewEngine::initFirebase()
 	
 	// Initialize last send time to allow immediate first send
 	this->lastFirebaseSend = system_clock::now() - seconds(this->firebaseSendInterval);
+
+	// the network part runs in its own task (started in init), the read loop only queues samples
+	this->firebaseQueue = xQueueCreate(FIREBASE_QUEUE_LENGTH, sizeof(FirebaseSample));
 	
 	ESP_LOGI(TAG, "initFirebase: Done - URL: %s, Session ID: %lu", this->firebaseUrl.c_str(), this->currentSessionId);
 }
@@ -2043,130 +2432,213 @@ esp_err_t BrewEngine::http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
-esp_err_t BrewEngine::writeTemperatureToFirebase(float temperature, float targetTemperature, uint8_t pidOutput, const string &status)
+esp_http_client_handle_t BrewEngine::createFirebaseClient()
 {
-    if (!this->firebaseEnabled || !this->firebaseDatabaseEnabled)
-    {
-        return ESP_FAIL;
-    }
+    // the url is set per request, the token changes over time
+    esp_http_client_config_t config = {};
+    config.url = this->firebaseUrl.c_str();
+    config.method = HTTP_METHOD_PATCH;
+    config.crt_bundle_attach = esp_crt_bundle_attach;
+    config.buffer_size = 2048;
+    config.buffer_size_tx = 2048;
+    config.timeout_ms = 10000;
+    config.keep_alive_enable = true; // reuse the tls connection for the next batch
+
+    return esp_http_client_init(&config);
+}
+
+// Writes the batch with one PATCH on /temperatures.json, every sample keeps its own timestamp key
+esp_err_t BrewEngine::patchFirebaseTemperatures(esp_http_client_handle_t client, const FirebaseSample *batch, size_t count)
+{
+    PerfTimer timer(this->perf, PerfFirebaseSend);
 
-    char url[2200];  // Increased buffer size for safety
-    time_t now = time(NULL);
-    
-    // Validate Firebase URL is configured
     if (this->firebaseUrl.empty()) {
         ESP_LOGE(TAG, "Firebase URL not configured");
         return ESP_ERR_INVALID_STATE;
     }
-    
+
+    if (strncmp(this->firebaseUrl.c_str(), "https://", 8) != 0 && strncmp(this->firebaseUrl.c_str(), "http://", 7) != 0) {
+        ESP_LOGE(TAG, "Invalid URL format - must start with http:// or https://");
+        return ESP_ERR_INVALID_ARG;
+    }
+
     // Ensure we have valid authentication
     esp_err_t auth_result = ensureFirebaseAuthenticated();
     if (auth_result != ESP_OK) {
         ESP_LOGE(TAG, "Cannot write temperature: Firebase authentication failed");
         return auth_result;
     }
-    
-    // Construct URL with authentication token
-    ESP_LOGI(TAG, "Firebase URL for URL construction: len=%d, first char code=%d, content: '%s'", 
-             this->firebaseUrl.length(), this->firebaseUrl.empty() ? -1 : (int)this->firebaseUrl[0], this->firebaseUrl.c_str());
-    
-    int url_len = snprintf(url, sizeof(url), "%s/temperatures/%lld.json?auth=%s", 
-                          this->firebaseUrl.c_str(), (long long)now, this->firebaseIdToken.c_str());
-    
-    // Validate URL was constructed properly
-    if (url_len >= sizeof(url)) {
-        ESP_LOGE(TAG, "URL too long: %d bytes (max %d)", url_len, (int)sizeof(url));
-        return ESP_ERR_INVALID_SIZE;
-    }
-    
-    if (url_len <= 0) {
-        ESP_LOGE(TAG, "Failed to construct URL");
-        return ESP_ERR_INVALID_ARG;
+
+    string url = this->firebaseUrl + "/temperatures.json?auth=" + this->firebaseIdToken;
+
+    json jBatch = json::object();
+    for (size_t i = 0; i < count; i++)
+    {
+        const FirebaseSample &sample = batch[i];
+        jBatch[to_string(sample.timestamp)] = {
+            {"temperature", sample.temperature},
+            {"targetTemperature", sample.targetTemperature},
+            {"pidOutput", sample.pidOutput},
+            {"timestamp", sample.timestamp},
+            {"status", sample.status},
+            {"hostname", this->Hostname},
+            {"sessionId", this->currentSessionId},
+        };
     }
-    
-    ESP_LOGI(TAG, "Firebase URL (%d bytes): %s", url_len, url);
-    ESP_LOGI(TAG, "URL starts with https: %s", strncmp(url, "https://", 8) == 0 ? "YES" : "NO");
-    
-    cJSON *json = cJSON_CreateObject();
-    cJSON *temp_value = cJSON_CreateNumber(temperature);
-    cJSON *target_value = cJSON_CreateNumber(targetTemperature);
-    cJSON *pid_value = cJSON_CreateNumber(pidOutput);
-    cJSON *timestamp = cJSON_CreateNumber(now);
-    cJSON *status_value = cJSON_CreateString(status.c_str());
-    cJSON *hostname = cJSON_CreateString(this->Hostname.c_str());
-    cJSON *session_id = cJSON_CreateNumber(this->currentSessionId);
-    
-    cJSON_AddItemToObject(json, "temperature", temp_value);
-    cJSON_AddItemToObject(json, "targetTemperature", target_value);
-    cJSON_AddItemToObject(json, "pidOutput", pid_value);
-    cJSON_AddItemToObject(json, "timestamp", timestamp);
-    cJSON_AddItemToObject(json, "status", status_value);
-    cJSON_AddItemToObject(json, "hostname", hostname);
-    cJSON_AddItemToObject(json, "sessionId", session_id);
-    
-    char *json_string = cJSON_Print(json);
-    if (json_string == NULL) {
-        ESP_LOGE(TAG, "Failed to serialize JSON - out of memory");
-        cJSON_Delete(json);
-        return ESP_ERR_NO_MEM;
+    string payload = jBatch.dump();
+
+    esp_http_client_set_url(client, url.c_str());
+    esp_http_client_set_method(client, HTTP_METHOD_PATCH);
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    esp_http_client_set_post_field(client, payload.c_str(), payload.length());
+
+    esp_err_t err = esp_http_client_perform(client);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to write temperatures: %s", esp_err_to_name(err));
+        return err;
     }
-    
-    ESP_LOGI(TAG, "JSON payload size: %d bytes", strlen(json_string));
-    
-    esp_http_client_config_t config = {};
-    config.url = url;
-    config.method = HTTP_METHOD_PUT;
-    config.crt_bundle_attach = esp_crt_bundle_attach;
-    config.buffer_size = 4096;
-    config.buffer_size_tx = 4096;
-    config.timeout_ms = 10000;  // 10 second timeout
-    
-    // Validate URL format before creating client
-    ESP_LOGI(TAG, "About to validate URL: %s", url);
-    ESP_LOGI(TAG, "URL validation - starts with https: %s", strncmp(url, "https://", 8) == 0 ? "YES" : "NO");
-    if (strncmp(url, "https://", 8) != 0 && strncmp(url, "http://", 7) != 0) {
-        ESP_LOGE(TAG, "Invalid URL format - must start with http:// or https://");
-        ESP_LOGE(TAG, "URL first 10 chars: '%.10s'", url);
-        free(json_string);
-        cJSON_Delete(json);
-        return ESP_ERR_INVALID_ARG;
+
+    int status_code = esp_http_client_get_status_code(client);
+    if (status_code == 401) {
+        // token was revoked or expired early, authenticate again on the next try
+        this->firebaseTokenExpiresAt = 0;
+        return ESP_ERR_INVALID_STATE;
     }
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client - check URL format and memory");
-        ESP_LOGE(TAG, "URL being used: %s", url);
-        free(json_string);
-        cJSON_Delete(json);
-        return ESP_ERR_NO_MEM;
+    if (status_code < 200 || status_code >= 300) {
+        ESP_LOGW(TAG, "Firebase write failed with status %d", status_code);
+        return ESP_FAIL;
     }
-    
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_err_t set_field_err = esp_http_client_set_post_field(client, json_string, strlen(json_string));
-    if (set_field_err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set POST field: %s", esp_err_to_name(set_field_err));
-        esp_http_client_cleanup(client);
-        free(json_string);
-        cJSON_Delete(json);
-        return set_field_err;
+
+    ESP_LOGD(TAG, "%zu temperatures written to Firebase", count);
+    return ESP_OK;
+}
+
+// Synchronous single write, only used for the connection test
+esp_err_t BrewEngine::writeTemperatureToFirebase(float temperature, float targetTemperature, uint8_t pidOutput, const string &status)
+{
+    if (!this->firebaseEnabled || !this->firebaseDatabaseEnabled)
+    {
+        return ESP_FAIL;
     }
-    
-    esp_err_t err = esp_http_client_perform(client);
-    
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "Temperature written to Firebase. Status: %d", status_code);
-    } else {
-        ESP_LOGE(TAG, "Failed to write temperature: %s", esp_err_to_name(err));
+
+    FirebaseSample sample = {};
+    sample.timestamp = time(NULL);
+    sample.temperature = temperature;
+    sample.targetTemperature = targetTemperature;
+    sample.pidOutput = pidOutput;
+    snprintf(sample.status, sizeof(sample.status), "%s", status.c_str());
+
+    esp_http_client_handle_t client = this->createFirebaseClient();
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        return ESP_ERR_NO_MEM;
     }
-    
+
+    esp_err_t err = this->patchFirebaseTemperatures(client, &sample, 1);
     esp_http_client_cleanup(client);
-    free(json_string);
-    cJSON_Delete(json);
-    
+
     return err;
 }
 
+// Never blocks, when the uplink can't keep up the oldest sample is dropped
+void BrewEngine::queueFirebaseSample(float temperature, float targetTemperature, uint8_t pidOutput, const string &status)
+{
+    if (this->firebaseQueue == NULL)
+    {
+        return;
+    }
+
+    FirebaseSample sample = {};
+    sample.timestamp = time(NULL);
+    sample.temperature = temperature;
+    sample.targetTemperature = targetTemperature;
+    sample.pidOutput = pidOutput;
+    snprintf(sample.status, sizeof(sample.status), "%s", status.c_str());
+
+    if (xQueueSend(this->firebaseQueue, &sample, 0) != pdTRUE)
+    {
+        FirebaseSample dropped;
+        xQueueReceive(this->firebaseQueue, &dropped, 0);
+        xQueueSend(this->firebaseQueue, &sample, 0);
+    }
+}
+
+// Collects the queued samples in batches and sends them over one kept alive connection, retries with backoff when offline
+void BrewEngine::firebaseUplinkLoop(void *arg)
+{
+    BrewEngine *instance = (BrewEngine *)arg;
+
+    FirebaseSample batch[FIREBASE_BATCH_SIZE];
+    size_t count = 0;
+    uint32_t backoff = 0;
+    esp_http_client_handle_t client = NULL;
+
+    while (instance->run)
+    {
+        // fill the batch, wait at most until the oldest sample reaches the batch window
+        while (count < FIREBASE_BATCH_SIZE)
+        {
+            TickType_t wait = pdMS_TO_TICKS(1000);
+            if (count > 0)
+            {
+                time_t age = time(NULL) - batch[0].timestamp;
+                if (age >= FIREBASE_BATCH_WINDOW_S)
+                {
+                    break;
+                }
+                wait = pdMS_TO_TICKS((FIREBASE_BATCH_WINDOW_S - age) * 1000);
+            }
+
+            if (xQueueReceive(instance->firebaseQueue, &batch[count], wait) != pdTRUE)
+            {
+                if (count > 0 || !instance->run)
+                {
+                    break;
+                }
+                continue;
+            }
+            count++;
+        }
+
+        if (count == 0)
+        {
+            continue;
+        }
+
+        if (client == NULL)
+        {
+            client = instance->createFirebaseClient();
+        }
+
+        esp_err_t err = (client != NULL) ? instance->patchFirebaseTemperatures(client, batch, count) : ESP_ERR_NO_MEM;
+
+        if (err == ESP_OK)
+        {
+            count = 0;
+            backoff = 0;
+            continue;
+        }
+
+        // start over with a fresh connection, keep the batch for the next try
+        if (client != NULL)
+        {
+            esp_http_client_cleanup(client);
+            client = NULL;
+        }
+
+        backoff = (backoff == 0) ? 5 : std::min<uint32_t>(backoff * 2, FIREBASE_BACKOFF_MAX_S);
+        ESP_LOGW(TAG, "Firebase uplink failed, %zu samples kept, retry in %lus", count, (unsigned long)backoff);
+        vTaskDelay(pdMS_TO_TICKS(backoff * 1000));
+    }
+
+    if (client != NULL)
+    {
+        esp_http_client_cleanup(client);
+    }
+
+    vTaskDelete(NULL);
+}
+
 esp_err_t BrewEngine::queryLatestTemperatureFromFirebase(float *temperature, time_t *timestamp)
 {
     if (!this->firebaseEnabled)
@@ -2379,12 +2851,45 @@ void BrewEngine::initOneWire()
 	ESP_LOGI(TAG, "initOneWire: Done");
 }
 
+// Creates the DS18B20 handles straight from the saved rom ids, without a bus search.
+// Sensors that are gone just fail their reads until the background detection marks them.
+void BrewEngine::restoreOnewireTemperatureSensors()
+{
+	int restored = 0;
+
+	for (auto &[sensorId, sensor] : this->sensors)
+	{
+		if (sensor->sensorType != SENSOR_DS18B20 || sensor->ds18b20Handle != nullptr)
+		{
+			continue;
+		}
+
+		onewire_device_t device = {};
+		device.bus = this->obh;
+		device.address = sensorId;
+
+		ds18b20_config_t ds_cfg = {};
+
+		if (ds18b20_new_device(&device, &ds_cfg, &sensor->ds18b20Handle) == ESP_OK)
+		{
+			ds18b20_set_resolution(sensor->ds18b20Handle, (ds18b20_resolution_t)(sensor->resolution - 9));
+			sensor->connected = true;
+			restored++;
+		}
+		else
+		{
+			sensor->ds18b20Handle = nullptr;
+		}
+	}
+
+	ESP_LOGI(TAG, "Restored %d DS18B20 sensor(s) from settings", restored);
+}
+
 void BrewEngine::detectOnewireTemperatureSensors()
 {
 
-	// we need to temp stop our temp read loop while we change the sensor data
-	this->skipTempLoop = true;
-	vTaskDelay(pdMS_TO_TICKS(2000));
+	// the search shares the bus with the onewire task, it waits until we are done
+	xSemaphoreTakeRecursive(this->sensorsMutex, portMAX_DELAY);
 
 	// sensors are already loaded via json settings, but we need to add handles and status
 	onewire_device_iter_handle_t iter = NULL;
@@ -2395,7 +2900,7 @@ void BrewEngine::detectOnewireTemperatureSensors()
 	if (iter_result != ESP_OK) {
 		ESP_LOGE(TAG, "Failed to create OneWire device iterator: %s", esp_err_to_name(iter_result));
 		ESP_LOGI(TAG, "OneWire sensors not available, continuing without them");
-		this->skipTempLoop = false;
+		xSemaphoreGiveRecursive(this->sensorsMutex);
 		return;
 	}
 	ESP_LOGI(TAG, "Device iterator created, start searching...");
@@ -2442,7 +2947,12 @@ void BrewEngine::detectOnewireTemperatureSensors()
 					ESP_LOGI(TAG, "New Sensor");
 
 					// doesn't exist yet, we need to add it
-					auto sensor = new TemperatureSensor();
+					auto sensor = this->sensorPool.create();
+					if (sensor == nullptr)
+					{
+						ESP_LOGW(TAG, "Only %d temperature sensors supported, stop searching...", MAX_TEMP_SENSORS);
+						break;
+					}
 					sensor->id = sensorId;
 					sensor->name = to_string(sensorId);
 					sensor->color = "#ffffff";
@@ -2453,19 +2963,26 @@ void BrewEngine::detectOnewireTemperatureSensors()
 					sensor->compensateRelative = 1;
 					sensor->sensorType = SENSOR_DS18B20;
 					sensor->ds18b20Handle = newHandle;
+					sensor->resolution = 12;
 					this->sensors.insert_or_assign(sensor->id, sensor);
 				}
 				else
 				{
 					ESP_LOGI(TAG, "Existing Sensor");
-					// just set connected and handle
+					// just set connected and handle, a handle restored at boot is kept
 					TemperatureSensor *sensor = it->second;
+					if (sensor->ds18b20Handle != nullptr)
+					{
+						ds18b20_del_device(newHandle);
+						newHandle = sensor->ds18b20Handle;
+					}
 					sensor->ds18b20Handle = newHandle;
 					sensor->connected = true;
 				}
 
-				// set resolution for all DS18B20s
-				ds18b20_set_resolution(newHandle, DS18B20_RESOLUTION_12B);
+				// apply the configured resolution, new sensors default to 12 bit
+				TemperatureSensor *sensor = this->sensors.at(sensorId);
+				ds18b20_set_resolution(newHandle, (ds18b20_resolution_t)(sensor->resolution - 9));
 			}
 			else
 			{
@@ -2484,7 +3001,51 @@ void BrewEngine::detectOnewireTemperatureSensors()
 	}
 	ESP_LOGI(TAG, "Searching done, %d DS18B20 device(s) found", this->sensors.size());
 
-	this->skipTempLoop = false;
+	xSemaphoreGiveRecursive(this->sensorsMutex);
+}
+
+// Starts a conversion on all DS18B20s at once (Skip ROM + Convert T), returns the time in ms to wait before reading
+uint16_t BrewEngine::startOnewireConversion()
+{
+	uint8_t maxResolution = 0;
+
+	for (auto const &[key, sensor] : this->sensors)
+	{
+		if (sensor->sensorType == SENSOR_DS18B20 && sensor->connected && sensor->ds18b20Handle && sensor->resolution > maxResolution)
+		{
+			maxResolution = sensor->resolution;
+		}
+	}
+
+	if (maxResolution == 0)
+	{
+		return 0;
+	}
+
+	esp_err_t err = onewire_bus_reset(this->obh);
+	if (err == ESP_OK)
+	{
+		uint8_t tx_buffer[2] = {ONEWIRE_CMD_SKIP_ROM, DS18B20_CMD_CONVERT_T};
+		err = onewire_bus_write_bytes(this->obh, tx_buffer, sizeof(tx_buffer));
+	}
+
+	if (err != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error triggering conversion on 1-Wire bus: %s, disabling DS18B20 sensors!", esp_err_to_name(err));
+
+		for (auto &[key, sensor] : this->sensors)
+		{
+			if (sensor->sensorType == SENSOR_DS18B20 && sensor->connected)
+			{
+				sensor->connected = false;
+				sensor->lastTemp = 0;
+			}
+		}
+		return 0;
+	}
+
+	// conversion time doubles per extra bit, 94ms at 9 bit up to 750ms at 12 bit
+	return 94 << (maxResolution - 9);
 }
 
 void BrewEngine::initRtdSensors()
@@ -2548,9 +3109,8 @@ void BrewEngine::detectRtdTemperatureSensors()
 		return;
 	}
 
-	// we need to temp stop our temp read loop while we change the sensor data
-	this->skipTempLoop = true;
-	vTaskDelay(pdMS_TO_TICKS(2000));
+	// the rtd task waits while we replace the handles
+	xSemaphoreTakeRecursive(this->sensorsMutex, portMAX_DELAY);
 
 	// Clean up any existing RTD hardware handles before re-initializing
 	this->cleanupRtdSensors();
@@ -2570,7 +3130,7 @@ void BrewEngine::detectRtdTemperatureSensors()
 			}
 		}
 		
-		this->skipTempLoop = false;
+		xSemaphoreGiveRecursive(this->sensorsMutex);
 		return;
 	}
 
@@ -2600,8 +3160,8 @@ void BrewEngine::detectRtdTemperatureSensors()
 		}
 
 		// Initialize MAX31865 device (SPI bus should already be initialized)
-		max31865_t *rtd_sensor = new max31865_t;
-		esp_err_t ret = max31865_init_desc(rtd_sensor, SPI2_HOST, csPin);
+		max31865_t *rtd_sensor = this->rtdPool.create();
+		esp_err_t ret = (rtd_sensor != nullptr) ? max31865_init_desc(rtd_sensor, SPI2_HOST, csPin) : ESP_ERR_NO_MEM;
 		
 		if (ret == ESP_OK)
 		{
@@ -2636,21 +3196,21 @@ void BrewEngine::detectRtdTemperatureSensors()
 			else
 			{
 				ESP_LOGE(TAG, "Failed to configure RTD sensor %s: %s", sensor->name.c_str(), esp_err_to_name(ret));
-				delete rtd_sensor;
+				this->rtdPool.destroy(rtd_sensor);
 				sensor->connected = false;
 			}
 		}
 		else
 		{
 			ESP_LOGE(TAG, "Failed to initialize RTD sensor %s on CS pin %d: %s", sensor->name.c_str(), csPin, esp_err_to_name(ret));
-			delete rtd_sensor;
+			this->rtdPool.destroy(rtd_sensor);
 			sensor->connected = false;
 		}
 	}
 
 	this->rtdSensorCount = rtdSensorsInitialized;
 	ESP_LOGI(TAG, "RTD detection done, %d RTD sensor(s) initialized", this->rtdSensorCount);
-	this->skipTempLoop = false;
+	xSemaphoreGiveRecursive(this->sensorsMutex);
 }
 
 void BrewEngine::cleanupRtdSensors()
@@ -2667,7 +3227,7 @@ void BrewEngine::cleanupRtdSensors()
 			{
 				spi_bus_remove_device(rtd_sensor->spi);
 			}
-			delete rtd_sensor;
+			this->rtdPool.destroy(rtd_sensor);
 		}
 	}
 	
@@ -2707,7 +3267,7 @@ bool BrewEngine::reinitializeRtdSensor(TemperatureSensor *sensor)
 			{
 				// Remove device from SPI bus
 				spi_bus_remove_device((*it)->spi);
-				delete *it;
+				this->rtdPool.destroy(*it);
 				this->rtdSensors.erase(it);
 				this->rtdSensorCount--;
 				break;
@@ -2716,8 +3276,8 @@ bool BrewEngine::reinitializeRtdSensor(TemperatureSensor *sensor)
 	}
 
 	// Try to re-initialize the MAX31865 device
-	max31865_t *rtd_sensor = new max31865_t;
-	esp_err_t ret = max31865_init_desc(rtd_sensor, SPI2_HOST, csPin);
+	max31865_t *rtd_sensor = this->rtdPool.create();
+	esp_err_t ret = (rtd_sensor != nullptr) ? max31865_init_desc(rtd_sensor, SPI2_HOST, csPin) : ESP_ERR_NO_MEM;
 	
 	if (ret == ESP_OK)
 	{
@@ -2753,13 +3313,13 @@ bool BrewEngine::reinitializeRtdSensor(TemperatureSensor *sensor)
 		else
 		{
 			ESP_LOGE(TAG, "Failed to configure re-initialized RTD sensor %s: %s", sensor->name.c_str(), esp_err_to_name(ret));
-			delete rtd_sensor;
+			this->rtdPool.destroy(rtd_sensor);
 		}
 	}
 	else
 	{
 		ESP_LOGE(TAG, "Failed to re-initialize RTD sensor %s on CS pin %d: %s", sensor->name.c_str(), csPin, esp_err_to_name(ret));
-		delete rtd_sensor;
+		this->rtdPool.destroy(rtd_sensor);
 	}
 	
 	return false;
@@ -2839,11 +3399,27 @@ void BrewEngine::initNtcTemperatureSensors()
 	ESP_LOGI(TAG, "NTC sensor initialization completed, %d NTC sensor(s) found", ntcSensorCount);
 }
 
-void BrewEngine::start()
+// Returns true when resume continued the schedule of the checkpoint, false for a fresh start
+bool BrewEngine::start(bool resume)
 {
+	bool resumed = false;
+
 	// don't start if we are already running
 	if (!this->controlRun)
 	{
+		json jCheckpoint;
+		if (resume && !this->resumeCheckpoint.empty())
+		{
+			jCheckpoint = this->resumeCheckpoint;
+			this->selectedMashScheduleName = jCheckpoint.value("schedule", "");
+		}
+
+		// whatever this run is, the interrupted one isn't offered anymore, a simulation leaves it for the real kettle
+		if (!this->simulation)
+		{
+			this->clearCheckpoint();
+		}
+
 		this->controlRun = true;
 		this->inOverTime = false;
 		this->boostStatus = Off;
@@ -2854,17 +3430,27 @@ void BrewEngine::start()
 		// sensorTempLogs removed - will use database instead
 
 		// also clear old steps
-		for (auto const &step : this->executionSteps)
-		{
-			delete step.second;
-		}
 		this->executionSteps.clear();
 
 		if (this->selectedMashScheduleName.empty() == false)
 		{
-			this->loadSchedule();
 			this->currentMashStep = 1; // 0 is current temp, so we can start at 1
-			xTaskCreate(&this->controlLoop, "controlloop_task", 4096, this, 5, NULL);
+
+			if (!jCheckpoint.empty())
+			{
+				resumed = this->restoreCheckpoint(jCheckpoint);
+			}
+
+			if (!resumed)
+			{
+				this->loadSchedule(this->temperature);
+			}
+
+			this->resetPidNextStep = false;
+			this->boostUntil = 0;
+			this->boostPrevTemperature = this->temperature;
+			this->scheduleRun = true;
+			this->wakeScheduler();
 		}
 		else
 		{
@@ -2882,13 +3468,15 @@ void BrewEngine::start()
 
 		xTaskCreate(&this->pidLoop, "pidloop_task", 8192, this, 5, NULL);
 
-		xTaskCreate(&this->outputLoop, "outputloop_task", 4096, this, 5, NULL);
+		this->startOutputTimer();
 
 		this->statusText = "Running";
 	}
+
+	return resumed;
 }
 
-void BrewEngine::loadSchedule()
+void BrewEngine::loadSchedule(float startTemperature)
 {
 	auto pos = this->mashSchedules.find(this->selectedMashScheduleName);
 
@@ -2900,32 +3488,30 @@ void BrewEngine::loadSchedule()
 	auto schedule = pos->second;
 
 	system_clock::time_point prevTime = std::chrono::system_clock::now();
+	system_clock::time_point startTime = prevTime;
 
-	for (auto const &step : this->executionSteps)
+	// the capacity is kept between runs, so a reload or restart normally doesn't allocate
+	this->executionSteps.clear();
+	size_t maxSteps = 1;
+	for (auto const &step : schedule->steps)
 	{
-		delete step.second;
+		int stepTime = (step->stepTime == 0) ? 1 : step->stepTime;
+		maxSteps += 2 + ((step->stepTime > 0 || step->extendStepTimeIfNeeded) ? (stepTime * 60) / this->stepInterval : 0);
 	}
-	this->executionSteps.clear();
+	this->executionSteps.reserve(maxSteps);
 
 	this->currentExecutionStep = 0;
 	this->boilRun = schedule->boil;
-	int stepIndex = 0;
 
-	float prevTemp = this->temperature;
+	float prevTemp = startTemperature;
 	// insert the current as starting point
-	auto execStep0 = new ExecutionStep();
-	execStep0->time = prevTime;
-	execStep0->temperature = prevTemp;
-	execStep0->extendIfNeeded = false;
-	this->executionSteps.insert(std::make_pair(stepIndex, execStep0));
+	this->executionSteps.emplace_back(prevTime, prevTemp);
 
 	string iso_string = this->to_iso_8601(prevTime);
-	ESP_LOGI(TAG, "Time:%s, Temp:%f Extend:%d", iso_string.c_str(), prevTemp, execStep0->extendIfNeeded);
+	ESP_LOGI(TAG, "Time:%s, Temp:%f Extend:%d", iso_string.c_str(), prevTemp, false);
 
 	int extendNotifications = 0;
 
-	stepIndex++;
-
 	for (auto const &step : schedule->steps)
 	{
 		// a step can actualy be 2 different executions, 1 step time that needs substeps calcualted, and one fixed
@@ -2974,26 +3560,10 @@ void BrewEngine::loadSchedule()
 
 				float subStepTemp = prevTemp + (tempDiffPerStep * ((float)j + 1));
 
-				// insert the current as starting point
-				auto execStep = new ExecutionStep();
-				execStep->time = executionStepTime;
-				execStep->temperature = subStepTemp;
-				execStep->extendIfNeeded = false;
-
-				if (step->allowBoost && this->boostModeUntil > 0)
-				{
-					execStep->allowBoost = true;
-				}
-				else
-				{
-					execStep->allowBoost = false;
-				}
+				bool allowBoost = step->allowBoost && this->boostModeUntil > 0;
 
 				// set extend if needed on last step if configured
-				if (j == (subStepsInStep - 1) && step->extendStepTimeIfNeeded)
-				{
-					execStep->extendIfNeeded = true;
-				}
+				bool extendIfNeeded = j == (subStepsInStep - 1) && step->extendStepTimeIfNeeded;
 
 				float diff = abs(subStepTemp - prevStepTemp);
 				// ESP_LOGI(TAG, "Diff:%f, subStepTemp:%f prevStepTemp:%f", diff, subStepTemp, prevStepTemp);
@@ -3001,14 +3571,13 @@ void BrewEngine::loadSchedule()
 				// only insert if difference or if last step more then 1 degree
 				if (diff > 1 || (j == subStepsInStep - 1))
 				{
-					this->executionSteps.insert(std::make_pair(stepIndex, execStep));
-					prevStepTemp = execStep->temperature;
-					stepIndex++;
+					this->executionSteps.emplace_back(executionStepTime, subStepTemp, extendIfNeeded, allowBoost);
+					prevStepTemp = subStepTemp;
 
 					// Convert the time_point to an ISO 8601 string
 					string iso_string = this->to_iso_8601(executionStepTime);
 
-					ESP_LOGI(TAG, "Time:%s, Temp:%f Extend:%d", iso_string.c_str(), subStepTemp, execStep->extendIfNeeded);
+					ESP_LOGI(TAG, "Time:%s, Temp:%f Extend:%d", iso_string.c_str(), subStepTemp, extendIfNeeded);
 				}
 			}
 
@@ -3021,19 +3590,12 @@ void BrewEngine::loadSchedule()
 			auto stepEndTime = prevTime + seconds(10);
 
 			// go directly to temp
-			auto execStep = new ExecutionStep();
-			execStep->time = stepEndTime;
-			execStep->temperature = (float)step->temperature;
-			execStep->extendIfNeeded = step->extendStepTimeIfNeeded;
-
-			this->executionSteps.insert(std::make_pair(stepIndex, execStep));
-
-			stepIndex++;
+			this->executionSteps.emplace_back(stepEndTime, (float)step->temperature, step->extendStepTimeIfNeeded);
 
 			// Convert the time_point to an ISO 8601 string
 			string iso_string = this->to_iso_8601(prevTime);
 
-			ESP_LOGI(TAG, "Time:%s, Temp:%f Extend:%d", iso_string.c_str(), (float)step->temperature, execStep->extendIfNeeded);
+			ESP_LOGI(TAG, "Time:%s, Temp:%f Extend:%d", iso_string.c_str(), (float)step->temperature, step->extendStepTimeIfNeeded);
 
 			prevTime = stepEndTime;
 			prevTemp = (float)step->temperature;
@@ -3042,13 +3604,7 @@ void BrewEngine::loadSchedule()
 		// for the hold time we just need add one point
 		auto holdEndTime = prevTime + minutes(step->time);
 
-		auto holdStep = new ExecutionStep();
-		holdStep->time = holdEndTime;
-		holdStep->temperature = (float)step->temperature;
-		holdStep->extendIfNeeded = false;
-
-		this->executionSteps.insert(std::make_pair(stepIndex, holdStep));
-		stepIndex++;
+		this->executionSteps.emplace_back(holdEndTime, (float)step->temperature);
 
 		prevTime = holdEndTime;
 		prevTemp = step->temperature; // is normaly the same but this could change in futrure
@@ -3060,16 +3616,22 @@ void BrewEngine::loadSchedule()
 	// also add notifications
 	for (auto const &notification : this->notifications)
 	{
-		delete notification;
+		this->runningNotificationPool.destroy(notification);
 	}
 	this->notifications.clear();
 
 	for (auto const &notification : schedule->notifications)
 	{
-		auto notificationTime = execStep0->time + minutes(notification->timeFromStart) + seconds(extendNotifications);
+		auto notificationTime = startTime + minutes(notification->timeFromStart) + seconds(extendNotifications);
 
 		// copy notification to new map
-		auto newNotification = new Notification();
+		// schedules never have more than fit, see setMashSchedule
+		auto newNotification = this->runningNotificationPool.create();
+		if (newNotification == nullptr)
+		{
+			ESP_LOGW(TAG, "Only %d notifications per schedule supported, skipping the rest!", MAX_SCHEDULE_NOTIFICATIONS);
+			break;
+		}
 		newNotification->name = notification->name;
 		newNotification->message = notification->message;
 		newNotification->timeFromStart = notification->timeFromStart + (extendNotifications / 60); // in minutes
@@ -3078,64 +3640,169 @@ void BrewEngine::loadSchedule()
 		this->notifications.push_back(newNotification);
 	}
 
-	// increate version so client can follow changes
+	// increate version so client can follow changes, a new plan can't be described as a difference
 	this->runningVersion++;
+	this->scheduleEdits.reset(this->runningVersion);
 }
 
 void BrewEngine::recalculateScheduleAfterOverTime()
 {
 	ESP_LOGI(TAG, "Recalculate Schedule after OverTime");
 
-	int currentStepIndex = this->currentMashStep;
+	size_t currentStepIndex = this->currentMashStep;
 
-	auto currentPos = this->executionSteps.find(currentStepIndex);
-
-	if (currentPos == this->executionSteps.end())
+	if (currentStepIndex >= this->executionSteps.size())
 	{
 		ESP_LOGE(TAG, "Steps not availible anymore");
 		this->stop();
 		return;
 	}
 
-	auto currentStep = currentPos->second;
-	system_clock::time_point plannedEnd = currentStep->time;
+	system_clock::time_point plannedEnd = this->executionSteps[currentStepIndex].time;
 
 	system_clock::time_point now = std::chrono::system_clock::now();
 	auto extraSeconds = chrono::duration_cast<chrono::seconds>(now - plannedEnd).count();
 
-	for (auto it = currentPos; it != this->executionSteps.end(); ++it)
-	{
-		auto step = it->second;
-		auto newTime = step->time + seconds(extraSeconds);
+	// the time strings are only built when someone reads them
+	bool logTimes = esp_log_level_get(TAG) >= ESP_LOG_DEBUG;
 
-		string iso_string = this->to_iso_8601(step->time);
-		string iso_string2 = this->to_iso_8601(newTime);
+	// only the remaining steps move, in place
+	for (size_t i = currentStepIndex; i < this->executionSteps.size(); i++)
+	{
+		ExecutionStep &step = this->executionSteps[i];
+		auto newTime = step.time + seconds(extraSeconds);
 
-		ESP_LOGI(TAG, "Time Changend From: %s, To:%s ", iso_string.c_str(), iso_string2.c_str());
+		if (logTimes)
+		{
+			ESP_LOGD(TAG, "Time Changend From: %s, To:%s ", this->to_iso_8601(step.time).c_str(), this->to_iso_8601(newTime).c_str());
+		}
 
-		step->time = newTime;
+		step.time = newTime;
 	}
 
+	ESP_LOGI(TAG, "Moved %d steps by %lld seconds", (int)(this->executionSteps.size() - currentStepIndex), (long long)extraSeconds);
+
 	// also increase notifications
 	for (auto &notification : this->notifications)
 	{
 		auto newTime = notification->timePoint + seconds(extraSeconds);
 
-		string iso_string = this->to_iso_8601(notification->timePoint);
-		string iso_string2 = this->to_iso_8601(newTime);
-
-		ESP_LOGI(TAG, "Notification Time Changend From: %s, To:%s ", iso_string.c_str(), iso_string2.c_str());
+		if (logTimes)
+		{
+			ESP_LOGD(TAG, "Notification Time Changend From: %s, To:%s ", this->to_iso_8601(notification->timePoint).c_str(), this->to_iso_8601(newTime).c_str());
+		}
 
 		notification->timePoint = newTime;
 	}
 
+	ESP_LOGI(TAG, "Moved %d notifications by %lld seconds", (int)this->notifications.size(), (long long)extraSeconds);
+
 	// increate version so client can follow changes
 	this->runningVersion++;
+	this->scheduleEdits.add(this->runningVersion, currentStepIndex, extraSeconds);
+}
+
+// Written on every step change, lets start() re-enter the schedule after an unexpected reset.
+// The planned time of the current step is the anchor, it already contains all overtime shifts.
+void BrewEngine::saveCheckpoint()
+{
+	// a simulated run must never resume on the real kettle
+	if (this->simulation || this->selectedMashScheduleName.empty() || this->currentMashStep >= this->executionSteps.size())
+	{
+		return;
+	}
+
+	json jCheckpoint = {
+		{"schedule", this->selectedMashScheduleName},
+		{"step", this->currentMashStep},
+		{"stepTime", system_clock::to_time_t(this->executionSteps[this->currentMashStep].time)},
+		{"startTemp", this->executionSteps[0].temperature},
+		{"overTime", this->inOverTime},
+		{"override", nullptr},
+		{"sessionId", this->statisticsManager->GetCurrentSessionId()},
+		{"savedAt", time(nullptr)},
+	};
+
+	if (this->overrideTargetTemperature.has_value())
+	{
+		jCheckpoint["override"] = this->overrideTargetTemperature.value();
+	}
+
+	this->settingsManager->Write("checkpoint", json::to_msgpack(jCheckpoint));
+}
+
+void BrewEngine::clearCheckpoint()
+{
+	this->resumeCheckpoint = json();
+	this->settingsManager->Erase("checkpoint");
+}
+
+// Rebuilds the schedule of the checkpoint and moves it back to its original wall-clock times
+bool BrewEngine::restoreCheckpoint(const json &jCheckpoint)
+{
+	time_t now = time(nullptr);
+	time_t savedAt = jCheckpoint.value("savedAt", (time_t)0);
+
+	if (now - savedAt > CHECKPOINT_MAX_AGE_S || now < savedAt)
+	{
+		// also when our clock isn't synced yet, we can't place the schedule in time
+		ESP_LOGW(TAG, "Checkpoint is too old or time is not set, starting schedule from the beginning");
+		return false;
+	}
+
+	this->loadSchedule(jCheckpoint.value("startTemp", this->temperature));
+
+	uint16_t step = jCheckpoint.value("step", (uint16_t)1);
+	if (step >= this->executionSteps.size())
+	{
+		ESP_LOGW(TAG, "Checkpoint step %d doesn't exist in schedule %s", step, this->selectedMashScheduleName.c_str());
+		this->loadSchedule(this->temperature);
+		return false;
+	}
+
+	auto shift = system_clock::from_time_t(jCheckpoint.value("stepTime", (time_t)0)) - this->executionSteps[step].time;
+	for (auto &executionStep : this->executionSteps)
+	{
+		executionStep.time += shift;
+	}
+
+	system_clock::time_point interruptedAt = system_clock::from_time_t(savedAt);
+	for (auto &notification : this->notifications)
+	{
+		notification->timePoint += shift;
+		// these were already given before the reset
+		notification->done = notification->timePoint < interruptedAt;
+	}
+
+	this->currentMashStep = step;
+	this->inOverTime = jCheckpoint.value("overTime", false);
+
+	this->runningVersion++;
+	this->scheduleEdits.reset(this->runningVersion);
+
+	if (jCheckpoint.contains("override") && jCheckpoint["override"].is_number())
+	{
+		this->overrideTargetTemperature = (float)jCheckpoint["override"];
+	}
+
+	// the time we were down counts as overtime of the current step
+	if (!this->inOverTime && this->executionSteps[step].time < system_clock::now())
+	{
+		this->recalculateScheduleAfterOverTime();
+	}
+
+	ESP_LOGI(TAG, "Resumed schedule %s at step %d", this->selectedMashScheduleName.c_str(), step);
+	this->logRemote("Resumed after reset");
+
+	return true;
 }
 
 void BrewEngine::stop()
 {
+	this->clearCheckpoint();
 	this->controlRun = false;
+	this->scheduleRun = false;
+	this->targetSlope = 0;
 	this->boostStatus = Off;
 	this->inOverTime = false;
 	this->statusText = "Idle";
@@ -3168,8 +3835,7 @@ void BrewEngine::startStir(const json &stirConfig)
 	}
 
 	this->stirRun = true;
-
-	xTaskCreate(&this->stirLoop, "stirloop_task", 4096, this, 10, &this->stirLoopHandle);
+	this->wakeScheduler();
 
 	this->stirStatusText = "Running";
 }
@@ -3186,453 +3852,99 @@ void BrewEngine::stopStir()
 
 	// stop at once
 	gpio_set_level(this->stir_PIN, this->gpioLow);
+	this->wakeScheduler();
 
 	this->stirStatusText = "Idle";
 }
 
-void BrewEngine::stirLoop(void *arg)
+void BrewEngine::readLoop(void *arg)
 {
 	BrewEngine *instance = (BrewEngine *)arg;
 
-	while (instance->run && instance->stirRun)
-	{
-		if (instance->stirIntervalStart == 0 && instance->stirIntervalStop == instance->stirTimeSpan)
-		{
-			// always on, just set high and wait for end
-			gpio_set_level(instance->stir_PIN, instance->gpioHigh);
-		}
-		else
-		{
-			system_clock::time_point now = std::chrono::system_clock::now();
+	int it = 0;
+	time_t lastTempLog = 0;
 
-			auto startStirTime = instance->stirStartCycle + minutes(instance->stirIntervalStart);
-			auto stopStirTime = instance->stirStartCycle + minutes(instance->stirIntervalStop);
+	while (instance->run)
+	{
+		vTaskDelay(pdMS_TO_TICKS(500));
 
-			auto cycleEnd = instance->stirStartCycle + minutes(instance->stirTimeSpan);
+		// the bus tasks publish their (filtered) samples, we only combine them here, weighted
+		int nrOfSensors = 0;
+		float sum = 0.0;
+		float weightSum = 0.0;
+		int64_t nowUs = esp_timer_get_time();
 
-			if (now >= startStirTime && now <= stopStirTime)
-			{
-				gpio_set_level(instance->stir_PIN, instance->gpioHigh);
-			}
-			else
-			{
-				gpio_set_level(instance->stir_PIN, instance->gpioLow);
-			}
-
-			// string iso_string1 = instance->to_iso_8601(now);
-			// string iso_string2 = instance->to_iso_8601(startStirTime);
-			// string iso_string3 = instance->to_iso_8601(stopStirTime);
-			// string iso_string4 = instance->to_iso_8601(cycleEnd);
-
-			// ESP_LOGI(TAG, "Stir Cycle Now: %s Start:%s Stop:%s CycleEnd: %s", iso_string1.c_str(), iso_string2.c_str(), iso_string3.c_str(), iso_string4.c_str());
-
-			// start next cycle
-			if (now >= cycleEnd)
-			{
-				instance->stirStartCycle = cycleEnd;
-			}
-		}
-
-		vTaskDelay(pdMS_TO_TICKS(1000));
-	}
-
-	vTaskDelete(NULL);
-}
-
-void BrewEngine::readLoop(void *arg)
-{
-	BrewEngine *instance = (BrewEngine *)arg;
-
-	int it = 0;
-
-	while (instance->run)
-	{
-		vTaskDelay(pdMS_TO_TICKS(500));
-
-		// When we are changing temp settings we temporarily need to skip our temp loop
-		if (instance->skipTempLoop)
-		{
-			continue;
-		}
-
-		int nrOfSensors = 0;
-		float sum = 0.0;
-
-		for (auto &[key, sensor] : instance->sensors)
+		for (size_t slot = 0; slot < instance->samples.size(); slot++)
 		{
-			float temperature;
-			string stringId = std::to_string(key);
-
-			// Skip disconnected sensors, except for RTD and NTC sensors which we want to retry
-			if (!sensor->connected && 
-				sensor->sensorType != SENSOR_PT100 && 
-				sensor->sensorType != SENSOR_PT1000 && 
-				sensor->sensorType != SENSOR_NTC)
+			TemperatureSample sample;
+			if (!instance->samples.read(slot, sample))
 			{
 				continue;
 			}
 
-			esp_err_t err = ESP_OK;
-
-			// Read temperature based on sensor type
-			if (sensor->sensorType == SENSOR_DS18B20)
-			{
-				// DS18B20 reading
-				if (!sensor->ds18b20Handle)
-				{
-					continue;
-				}
-
-				err = ds18b20_trigger_temperature_conversion(sensor->ds18b20Handle);
-				if (err != ESP_OK)
-				{
-					ESP_LOGW(TAG, "Error triggering conversion for DS18B20 [%s], disabling sensor!", stringId.c_str());
-					sensor->connected = false;
-					sensor->lastTemp = 0;
-					instance->currentTemperatures.erase(key);
-					continue;
-				}
-
-				err = ds18b20_get_temperature(sensor->ds18b20Handle, &temperature);
-				if (err != ESP_OK)
-				{
-					ESP_LOGW(TAG, "Error reading temperature from DS18B20 [%s], disabling sensor!", stringId.c_str());
-					sensor->connected = false;
-					sensor->lastTemp = 0;
-					instance->currentTemperatures.erase(key);
-					continue;
-				}
-			}
-			else if (sensor->sensorType == SENSOR_PT100 || sensor->sensorType == SENSOR_PT1000)
-			{
-				// RTD reading - always attempt to read, even if previously disconnected
-				// But first check if the SPI handle is valid
-				if (sensor->max31865Handle.spi == nullptr)
-				{
-					// Invalid SPI handle, mark as disconnected and skip
-					sensor->connected = false;
-					sensor->lastTemp = -999.0;
-					sensor->consecutiveFailures++;
-					if (sensor->show)
-					{
-						instance->currentTemperatures.insert_or_assign(key, -999.0);
-					}
-					
-					// Try to reinitialize after 3 consecutive failures for invalid handles
-					if (sensor->consecutiveFailures >= 3)
-					{
-						ESP_LOGI(TAG, "Attempting to reinitialize RTD sensor %s (invalid handle)", sensor->name.c_str());
-						if (instance->reinitializeRtdSensor(sensor))
-						{
-							sensor->consecutiveFailures = 0;
-							ESP_LOGI(TAG, "RTD sensor %s reinitialized successfully", sensor->name.c_str());
-						}
-						else
-						{
-							sensor->consecutiveFailures = 0; // Reset counter to avoid spam
-						}
-					}
-					continue;
-				}
-				
-				float rtd_resistance;
-				err = max31865_measure(&sensor->max31865Handle, &rtd_resistance, &temperature);
-				if (err != ESP_OK)
-				{
-					// Track consecutive failures for retry logic
-					sensor->consecutiveFailures++;
-					
-					if (err == ESP_ERR_NOT_FOUND)
-					{
-						// Probe disconnected - show disconnected status but keep trying
-						if (sensor->connected)
-						{
-							ESP_LOGW(TAG, "RTD probe [%s] disconnected", stringId.c_str());
-						}
-						sensor->lastTemp = -999.0; // Invalid temperature to show disconnected
-						sensor->connected = false;  // Mark as disconnected
-						if (sensor->show)
-						{
-							instance->currentTemperatures.insert_or_assign(key, -999.0);
-						}
-						
-						// Try to reinitialize after 5 consecutive failures (5 seconds)
-						if (sensor->consecutiveFailures >= 5)
-						{
-							ESP_LOGI(TAG, "Attempting to reinitialize RTD sensor %s after %d failures", sensor->name.c_str(), sensor->consecutiveFailures);
-							if (instance->reinitializeRtdSensor(sensor))
-							{
-								sensor->consecutiveFailures = 0;
-								ESP_LOGI(TAG, "RTD sensor %s reinitialized successfully", sensor->name.c_str());
-							}
-							else
-							{
-								sensor->consecutiveFailures = 0; // Reset counter to avoid spam
-							}
-						}
-						
-						continue; // Skip this sensor for control calculations
-					}
-					else
-					{
-						// Other errors - keep trying but mark as disconnected
-						if (sensor->connected)
-						{
-							ESP_LOGW(TAG, "Error reading temperature from RTD [%s]: %s", stringId.c_str(), esp_err_to_name(err));
-						}
-						sensor->lastTemp = -999.0; // Invalid temperature
-						sensor->connected = false;  // Mark as disconnected
-						if (sensor->show)
-						{
-							instance->currentTemperatures.insert_or_assign(key, -999.0);
-						}
-						
-						// Try to reinitialize after 5 consecutive failures for other errors
-						if (sensor->consecutiveFailures >= 5)
-						{
-							ESP_LOGI(TAG, "Attempting to reinitialize RTD sensor %s after %d failures", sensor->name.c_str(), sensor->consecutiveFailures);
-							if (instance->reinitializeRtdSensor(sensor))
-							{
-								sensor->consecutiveFailures = 0;
-								ESP_LOGI(TAG, "RTD sensor %s reinitialized successfully", sensor->name.c_str());
-							}
-							else
-							{
-								sensor->consecutiveFailures = 0; // Reset counter to avoid spam
-							}
-						}
-						
-						continue; // Skip this sensor for control calculations
-					}
-				}
-				else
-				{
-					// Successful reading - mark sensor as connected (recovery case)
-					if (!sensor->connected)
-					{
-						ESP_LOGI(TAG, "RTD probe [%s] reconnected", stringId.c_str());
-						sensor->connected = true;
-					}
-					// Reset failure counter on successful read
-					sensor->consecutiveFailures = 0;
-				}
-			}
-			else if (sensor->sensorType == SENSOR_NTC)
-			{
-				// NTC sensor reading via ADC
-				if (!instance->adcInitialized)
-				{
-					ESP_LOGW(TAG, "ADC not initialized for NTC sensor [%s], skipping", stringId.c_str());
-					sensor->connected = false;
-					sensor->lastTemp = -999.0;
-					if (sensor->show)
-					{
-						instance->currentTemperatures.insert_or_assign(key, -999.0);
-					}
-					continue;
-				}
-
-				// Get ADC channel from GPIO pin (ESP32-S3 mapping)
-				adc_channel_t adc_channel;
-				switch (sensor->analogPin)
-				{
-					case 1: adc_channel = ADC_CHANNEL_0; break;
-					case 2: adc_channel = ADC_CHANNEL_1; break;
-					case 3: adc_channel = ADC_CHANNEL_2; break;
-					case 4: adc_channel = ADC_CHANNEL_3; break;
-					case 5: adc_channel = ADC_CHANNEL_4; break;
-					case 6: adc_channel = ADC_CHANNEL_5; break;
-					case 7: adc_channel = ADC_CHANNEL_6; break;
-					case 8: adc_channel = ADC_CHANNEL_7; break;
-					case 9: adc_channel = ADC_CHANNEL_8; break;
-					case 10: adc_channel = ADC_CHANNEL_9; break;
-					default:
-						ESP_LOGW(TAG, "Invalid analog pin %d for NTC sensor [%s] (supported: 1-10)", sensor->analogPin, stringId.c_str());
-						sensor->connected = false;
-						sensor->lastTemp = -999.0;
-						if (sensor->show)
-						{
-							instance->currentTemperatures.insert_or_assign(key, -999.0);
-						}
-						continue;
-				}
-
-				// Read ADC value
-				int adc_reading;
-				esp_err_t read_err = adc_oneshot_read(instance->adc1_handle, adc_channel, &adc_reading);
-				if (read_err != ESP_OK)
-				{
-					ESP_LOGW(TAG, "Error reading ADC for NTC sensor [%s]: %s", stringId.c_str(), esp_err_to_name(read_err));
-					sensor->connected = false;
-					sensor->lastTemp = -999.0;
-					if (sensor->show)
-					{
-						instance->currentTemperatures.insert_or_assign(key, -999.0);
-					}
-					continue;
-				}
-
-				// Convert ADC reading to voltage
-				int voltage_mv = 0;
-				if (instance->adc1_cali_handle != nullptr)
-				{
-					esp_err_t cali_err = adc_cali_raw_to_voltage(instance->adc1_cali_handle, adc_reading, &voltage_mv);
-					if (cali_err != ESP_OK)
-					{
-						ESP_LOGW(TAG, "ADC calibration failed for NTC sensor [%s], using raw conversion", stringId.c_str());
-						// Fallback: approximate conversion for 12-bit ADC with 3.3V reference
-						voltage_mv = (adc_reading * 3300) / 4095;
-					}
-				}
-				else
-				{
-					// Fallback: approximate conversion for 12-bit ADC with 3.3V reference
-					voltage_mv = (adc_reading * 3300) / 4095;
-				}
-				
-				// Calculate NTC resistance using voltage divider
-				// Voltage divider: 3.3V -> NTC -> analogPin -> dividerResistor -> GND
-				// V_adc = V_supply * (R_divider / (R_ntc + R_divider))
-				// Solving for R_ntc: R_ntc = ((V_supply - V_adc) * R_divider) / V_adc
-				float v_supply = 3300.0f; // 3.3V in mV
-				float v_adc = (float)voltage_mv;
-				
-				// Check for voltage ranges that indicate disconnection or short circuit
-				if (v_adc <= 10.0f) // Very low voltage - possible short circuit
-				{
-					ESP_LOGW(TAG, "NTC sensor [%s] voltage too low (%.1fmV), possible short circuit", stringId.c_str(), v_adc);
-					sensor->connected = false;
-					sensor->lastTemp = -999.0;
-					if (sensor->show)
-					{
-						instance->currentTemperatures.insert_or_assign(key, -999.0);
-					}
-					continue;
-				}
-				
-				if (v_adc >= v_supply * 0.95f) // Very high voltage - possible open circuit (disconnected)
-				{
-					ESP_LOGW(TAG, "NTC sensor [%s] voltage too high (%.1fmV), possible open circuit or disconnection", stringId.c_str(), v_adc);
-					sensor->connected = false;
-					sensor->lastTemp = -999.0;
-					if (sensor->show)
-					{
-						instance->currentTemperatures.insert_or_assign(key, -999.0);
-					}
-					continue;
-				}
-				
-				float ntc_resistance = ((v_supply - v_adc) * sensor->dividerResistor) / v_adc;
-				
-				// Calculate temperature using simplified Steinhart-Hart equation
-				// For NTC thermistors: 1/T = 1/T0 + (1/B) * ln(R/R0)
-				// Where T0 = 298.15K (25°C), R0 = ntcResistance (at 25°C), B = 3950 (typical value)
-				float T0 = 298.15f; // 25°C in Kelvin
-				float B = 3950.0f;  // Beta coefficient (typical value for NTC thermistors)
-				float R0 = sensor->ntcResistance;
-				
-				if (ntc_resistance <= 0)
-				{
-					ESP_LOGW(TAG, "Invalid NTC resistance calculated for sensor [%s]: %.1f ohms", stringId.c_str(), ntc_resistance);
-					sensor->connected = false;
-					sensor->lastTemp = -999.0;
-					if (sensor->show)
-					{
-						instance->currentTemperatures.insert_or_assign(key, -999.0);
-					}
-					continue;
-				}
-				
-				// Calculate temperature in Kelvin
-				float temp_kelvin = 1.0f / ((1.0f / T0) + (1.0f / B) * logf(ntc_resistance / R0));
-				
-				// Convert to Celsius
-				temperature = temp_kelvin - 273.15f;
-				
-				// Sanity check - temperature should be reasonable for brewing applications
-				// Allow wider range to permit sensor recovery and different applications
-				if (temperature < -40.0f || temperature > 150.0f)
-				{
-					ESP_LOGW(TAG, "NTC sensor [%s] reading out of range: %.1f°C (R=%.1f ohms, V=%.1fmV)", 
-							stringId.c_str(), temperature, ntc_resistance, v_adc);
-					sensor->connected = false;
-					sensor->lastTemp = -999.0;
-					if (sensor->show)
-					{
-						instance->currentTemperatures.insert_or_assign(key, -999.0);
-					}
-					continue;
-				}
-				
-				// Mark sensor as connected
-				if (!sensor->connected)
-				{
-					ESP_LOGI(TAG, "NTC sensor [%s] connected", stringId.c_str());
-				}
-				sensor->connected = true;
-				sensor->consecutiveFailures = 0;
-				
-				ESP_LOGD(TAG, "NTC sensor [%s]: ADC=%d, V=%.1fmV, R=%.1f ohms, T=%.1f°C", 
-						stringId.c_str(), adc_reading, v_adc, ntc_resistance, temperature);
-			}
-			else
+			// sensors of the other vessels have their own control loop
+			if (sample.vessel != 0)
 			{
-				ESP_LOGW(TAG, "Unknown sensor type for [%s], skipping", stringId.c_str());
 				continue;
 			}
 
-			// conversion needed
-			if (instance->temperatureScale == Fahrenheit)
-			{
-				temperature = (temperature * 1.8) + 32;
-			}
-
-			ESP_LOGD(TAG, "temperature read from [%s]: %.2f°", stringId.c_str(), temperature);
-
-			// apply compensation
-			if (sensor->compensateAbsolute != 0)
-			{
-				temperature = temperature + sensor->compensateAbsolute;
-			}
-			if (sensor->compensateRelative != 0 && sensor->compensateRelative != 1)
+			// in simulation the real sensors are still shown, but only the simulated kettle controls
+			if (instance->simulation && slot != SIM_SLOT)
 			{
-				temperature = temperature * sensor->compensateRelative;
+				continue;
 			}
 
-			if (sensor->useForControl)
+			// stale samples (bus task stuck in a reinit) are not trusted for control
+			if (sample.valid && sample.useForControl && (nowUs - sample.timestamp) < SAMPLE_MAX_AGE_US)
 			{
-				sum += temperature;
+				sum += sample.temperature * sample.weight;
+				weightSum += sample.weight;
 				nrOfSensors++;
 			}
+		}
 
-			sensor->lastTemp = temperature;
-
-			// we also add our temps to a map individualy, might be nice to see bottom and top temp in gui
-			if (sensor->show)
+		// without a reading we keep the last temperature for display, the pid loop turns the heaters off
+		if (nrOfSensors == 0 || weightSum <= 0)
+		{
+			if (instance->temperatureValid)
 			{
-				instance->currentTemperatures.insert_or_assign(key, sensor->lastTemp);
-				
-				// Store individual sensor temperature for persistent logging during control run
-				if (instance->controlRun)
-				{
-					// Individual sensor logging removed - will use database instead
-				}
+				ESP_LOGW(TAG, "No control sensor gives a temperature, heaters are off until one does");
 			}
+			instance->temperatureValid = false;
+			continue;
 		}
 
-		float avg = sum / nrOfSensors;
+		float avg = sum / weightSum;
 
 		ESP_LOGD(TAG, "Avg Temperature: %.2f°", avg);
 
+		if (!instance->firstSampleLogged)
+		{
+			instance->firstSampleLogged = true;
+			ESP_LOGI(TAG, "Boot timing: first control sample after %lld ms", (nowUs - instance->bootStartedAt) / 1000);
+		}
+
 		instance->temperature = avg;
+		instance->temperatureValid = true;
 
 		// when controlrun is true we need to keep out data
 		if (instance->controlRun)
 		{
 			time_t current_raw_time = time(0);
 			
-			// Temperature logging removed - will use database instead
-			
+			// running history for the web, the full session goes to the statistics
+			if (current_raw_time - lastTempLog >= TEMPLOG_INTERVAL_S)
+			{
+				lastTempLog = current_raw_time;
+				instance->tempLog.add(current_raw_time, avg);
+			}
+
+			// a simulated run is only shown on the web, it never reaches the statistics or firebase
+			if (instance->simulation)
+			{
+				continue;
+			}
+
 			// Add statistics data point every 6 cycles to reduce overhead
 			it++;
 			if (it > 5)
@@ -3642,19 +3954,6 @@ void BrewEngine::readLoop(void *arg)
 				ESP_LOGD(TAG, "Logging: %.1f°", avg);
 			}
 
-			if (instance->mqttEnabled)
-			{
-				string iso_datetime = to_iso_8601(std::chrono::system_clock::now());
-				json jPayload;
-				jPayload["time"] = iso_datetime;
-				jPayload["temp"] = instance->temperature;
-				jPayload["target"] = instance->targetTemperature;
-				jPayload["output"] = instance->pidOutput;
-				string payload = jPayload.dump();
-
-				esp_mqtt_client_publish(instance->mqttClient, instance->mqttTopic.c_str(), payload.c_str(), 0, 1, 1);
-			}
-
 			// Send to Firebase (with interval check)
 			if (instance->firebaseEnabled)
 			{
@@ -3664,8 +3963,7 @@ void BrewEngine::readLoop(void *arg)
 				if (timeSinceLastSend >= instance->firebaseSendInterval)
 				{
 					instance->lastFirebaseSend = now;
-					instance->writeTemperatureToFirebase(instance->temperature, instance->targetTemperature, 
-						instance->pidOutput, instance->statusText);
+					instance->queueFirebaseSample(instance->temperature, instance->targetTemperature, instance->pidOutput, instance->statusText);
 				}
 			}
 		}
@@ -3674,1420 +3972,3627 @@ void BrewEngine::readLoop(void *arg)
 	vTaskDelete(NULL);
 }
 
-void BrewEngine::pidLoop(void *arg)
+// Publishes temp, target, output and the sensor temperatures on their own topic, only when they moved more than the deadband
+// (or the heartbeat expired). Messages are enqueued for the mqtt task, so we never wait on the network here.
+void BrewEngine::mqttTelemetryLoop(void *arg)
 {
 	BrewEngine *instance = (BrewEngine *)arg;
 
-	double kP, kI, kD;
-	if (instance->boilRun)
+	struct PublishedValue
 	{
-		kP = instance->boilkP;
-		kI = instance->boilkI;
-		kD = instance->boilkD;
-	}
-	else
+		float value;
+		int64_t time;
+	};
+	map<string, PublishedValue> published;
+	int64_t lastDiagnostics = 0;
+
+	while (instance->run)
 	{
-		kP = instance->mashkP;
-		kI = instance->mashkI;
-		kD = instance->mashkD;
-	}
+		vTaskDelay(pdMS_TO_TICKS(MQTT_TELEMETRY_INTERVAL_MS));
+
+		// simulated temperatures must not end up in the broker's history of the real kettle
+		if (instance->simulation)
+		{
+			continue;
+		}
 
-	PIDController pid(kP, kI, kD);
-	pid.setMin(0);
-	pid.setMax(100);
-	pid.debug = false;
+		PerfTimer timer(instance->perf, PerfMqttSend);
 
-	uint totalWattage = 0;
+		int64_t now = esp_timer_get_time() / 1000000;
+		bool changed = false;
 
-	// we calculate the total wattage we have availible, depens on heaters and on mash or boil
-	for (auto &heater : instance->heaters)
-	{
+		auto publish = [&](const string &field, float value, float deadband) {
+			auto pos = published.find(field);
+			if (pos != published.end())
+			{
+				int64_t age = now - pos->second.time;
+				bool moved = fabsf(value - pos->second.value) >= deadband;
+
+				if (!(moved && age >= instance->mqttMinInterval) && age < MQTT_HEARTBEAT_S)
+				{
+					return;
+				}
+			}
+
+			char payload[16];
+			int length = snprintf(payload, sizeof(payload), "%.1f", value);
+			string topic = instance->mqttTopicTelemetry + field;
+
+			// qos 0 is only queued when stored, retained so a new subscriber gets the current value
+			esp_mqtt_client_enqueue(instance->mqttClient, topic.c_str(), payload, length, 0, 1, true);
+
+			published[field] = {value, now};
+			changed = true;
+		};
 
-		if (instance->boilRun && heater->useForBoil)
+		float deadband = (float)instance->mqttDeadband / 10;
+
+		if (instance->temperatureValid && !isnan(instance->temperature))
 		{
-			totalWattage += heater->watt;
-			heater->enabled = true;
+			publish("temp", instance->temperature, deadband);
 		}
-		else if (!instance->boilRun && heater->useForMash)
+		publish("target", instance->targetTemperature, deadband);
+		publish("output", instance->pidOutput, 1);
+
+		for (size_t slot = 0; slot < instance->samples.size(); slot++)
 		{
-			totalWattage += heater->watt;
-			heater->enabled = true;
+			TemperatureSample sample;
+			if (!instance->samples.read(slot, sample) || !sample.valid)
+			{
+				continue;
+			}
+
+			publish("sensor/" + to_string(sample.sensorId), sample.temperature, deadband);
 		}
-		else
+
+		// the combined history message follows the same suppression
+		if (changed && instance->controlRun)
 		{
-			heater->enabled = false;
+			json jPayload;
+			jPayload["time"] = to_iso_8601(std::chrono::system_clock::now());
+			jPayload["temp"] = instance->temperature;
+			jPayload["target"] = instance->targetTemperature;
+			jPayload["output"] = instance->pidOutput;
+			string payload = jPayload.dump();
+
+			esp_mqtt_client_enqueue(instance->mqttClient, instance->mqttTopic.c_str(), payload.c_str(), payload.length(), 0, 0, true);
 		}
-	}
 
-	while (instance->run && instance->controlRun)
-	{
-		// Output is %
-		int outputPercent = (int)pid.getOutput((double)instance->temperature, (double)instance->targetTemperature);
-		instance->pidOutput = outputPercent;
-		ESP_LOGI(TAG, "Pid Output: %d Target: %f", instance->pidOutput, instance->targetTemperature);
+		if (now - lastDiagnostics >= MQTT_DIAGNOSTICS_INTERVAL_S)
+		{
+			lastDiagnostics = now;
+			string payload = instance->getPerf().dump();
 
-		// Manual override and boost
-		if (instance->manualOverrideOutput.has_value())
+			esp_mqtt_client_enqueue(instance->mqttClient, instance->mqttTopicDiagnostics.c_str(), payload.c_str(), payload.length(), 0, 0, true);
+		}
+	}
+
+	vTaskDelete(NULL);
+}
+
+// Applies scale and compensation and publishes the reading in the given slot
+void BrewEngine::publishTemperature(size_t slot, TemperatureSensor *sensor, float temperature, bool valid)
+{
+	if (valid)
+	{
+		// conversion needed
+		if (this->temperatureScale == Fahrenheit)
 		{
-			// Here we don't override the pidOutput display since we want the user to see the pid values even when overriding
-			outputPercent = instance->manualOverrideOutput.value();
+			temperature = (temperature * 1.8) + 32;
 		}
-		else if (instance->boostStatus == Boost)
+
+		ESP_LOGD(TAG, "temperature read from [%llu]: %.2f°", sensor->id, temperature);
+
+		// apply compensation
+		if (sensor->compensateAbsolute != 0)
 		{
-			outputPercent = 100;
-			instance->pidOutput = 100;
+			temperature = temperature + sensor->compensateAbsolute;
 		}
-		else if (instance->boostStatus == Rest)
+		if (sensor->compensateRelative != 0 && sensor->compensateRelative != 1)
 		{
-			outputPercent = 0;
-			instance->pidOutput = 0;
+			temperature = temperature * sensor->compensateRelative;
 		}
 
-		// set all to 0
-		for (auto &heater : instance->heaters)
+		// after a gap the old filter state says nothing about the kettle anymore
+		int64_t now = esp_timer_get_time();
+
+		portENTER_CRITICAL(&this->filterLock);
+		if (now - sensor->lastValidAt > SAMPLE_MAX_AGE_US)
 		{
-			heater->burnTime = 0;
+			sensor->filter.reset();
 		}
+		temperature = sensor->filter.apply(temperature);
+		portEXIT_CRITICAL(&this->filterLock);
+
+		sensor->lastValidAt = now;
+	}
+
+	sensor->lastTemp = temperature;
+
+	TemperatureSample sample;
+	sample.sensorId = sensor->id;
+	sample.temperature = temperature;
+	sample.timestamp = esp_timer_get_time();
+	sample.valid = valid;
+	sample.show = sensor->show;
+	sample.useForControl = sensor->useForControl;
+	sample.weight = sensor->weight;
+	sample.vessel = sensor->vessel;
+
+	this->samples.publish(slot, sample);
+}
+
+void BrewEngine::clearSamples(size_t from, size_t to)
+{
+	for (size_t slot = from; slot < to; slot++)
+	{
+		this->samples.clear(slot);
+	}
+}
+
+void BrewEngine::onewireReadLoop(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	while (instance->run)
+	{
+		// held from the conversion to the last read, a search or settings change in between would break the conversion
+		xSemaphoreTakeRecursive(instance->sensorsMutex, portMAX_DELAY);
 
-		// calc the wattage we need
-		int outputWatt = (totalWattage / 100) * outputPercent;
+		// all DS18B20s convert in parallel, so the wait is the same for 1 or 10 sensors
+		uint16_t conversionTime = instance->startOnewireConversion();
+		vTaskDelay(pdMS_TO_TICKS(conversionTime));
 
-		// we need to calculate our burn time per output
-		for (auto &heater : instance->heaters)
+		size_t slot = ONEWIRE_SLOT_BASE;
+
+		for (auto &[key, sensor] : instance->sensors)
 		{
-			if (!heater->enabled)
+			if (sensor->sensorType != SENSOR_DS18B20 || !sensor->connected || !sensor->ds18b20Handle)
 			{
 				continue;
 			}
 
-			if (outputWatt < 0)
+			if (slot >= ONEWIRE_SLOT_BASE + ONEWIRE_MAX_DS18B20)
 			{
 				break;
 			}
 
-			// we can complete it with this heater
-			if (heater->watt > outputWatt)
-			{
-				heater->burnTime = (int)(((double)outputWatt / (double)heater->watt) * 100);
-				ESP_LOGD(TAG, "Pid Calc Heater %s: OutputWatt: %d Burn: %d", heater->name.c_str(), outputWatt, heater->burnTime);
-				break;
-			}
-			else
+			float temperature;
+
+			// conversion was already started for the whole bus, we only need to read the scratchpad
+			int64_t readStartedAt = esp_timer_get_time();
+			esp_err_t err = ds18b20_get_temperature(sensor->ds18b20Handle, &temperature);
+			instance->perf.record(PerfOnewireRead, esp_timer_get_time() - readStartedAt);
+			if (err != ESP_OK)
 			{
-				// we can't complete it, take out part and continue
-				outputWatt -= heater->watt;
-				heater->burnTime = 100;
-				ESP_LOGD(TAG, "Pid Calc Heater %s: OutputWatt: %d Burn: 100", heater->name.c_str(), outputWatt);
+				ESP_LOGW(TAG, "Error reading temperature from DS18B20 [%llu], disabling sensor!", key);
+				sensor->connected = false;
+				sensor->lastTemp = 0;
+				continue;
 			}
+
+			instance->publishTemperature(slot++, sensor, temperature, true);
 		}
 
-		// we keep going for the desired pidlooptime and set the burn by percent
-		for (int i = 0; i < instance->pidLoopTime; i++)
+		// sensors that dropped out no longer have a slot
+		instance->clearSamples(slot, ONEWIRE_SLOT_BASE + ONEWIRE_MAX_DS18B20);
+
+		xSemaphoreGiveRecursive(instance->sensorsMutex);
+
+		// the rest of the cycle without the lock, so topology changes get their turn
+		vTaskDelay(pdMS_TO_TICKS(std::max(500 - conversionTime, 50)));
+	}
+
+	vTaskDelete(NULL);
+}
+
+void BrewEngine::rtdReadLoop(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	while (instance->run)
+	{
+		vTaskDelay(pdMS_TO_TICKS(500));
+
+		// topology changes wait until we've read all sensors, we wait for theirs
+		xSemaphoreTakeRecursive(instance->sensorsMutex, portMAX_DELAY);
+
+		size_t slot = RTD_SLOT_BASE;
+
+		for (auto &[key, sensor] : instance->sensors)
 		{
-			if (!instance->run || !instance->controlRun)
+			if (sensor->sensorType != SENSOR_PT100 && sensor->sensorType != SENSOR_PT1000)
+			{
+				continue;
+			}
+
+			if (slot >= RTD_SLOT_BASE + MAX_RTD_SENSORS)
 			{
 				break;
 			}
 
-			for (auto &heater : instance->heaters)
+			string stringId = std::to_string(key);
+			float temperature;
+
+			// RTD reading - always attempt to read, even if previously disconnected
+			// But first check if the SPI handle is valid
+			if (sensor->max31865Handle.spi == nullptr)
 			{
-				if (!heater->enabled)
+				// Invalid SPI handle, mark as disconnected and skip
+				sensor->connected = false;
+				sensor->consecutiveFailures++;
+				instance->publishTemperature(slot++, sensor, -999.0, false);
+				
+				// Try to reinitialize after 3 consecutive failures for invalid handles
+				if (sensor->consecutiveFailures >= 3)
 				{
-					continue;
+					ESP_LOGI(TAG, "Attempting to reinitialize RTD sensor %s (invalid handle)", sensor->name.c_str());
+					if (instance->reinitializeRtdSensor(sensor))
+					{
+						sensor->consecutiveFailures = 0;
+						ESP_LOGI(TAG, "RTD sensor %s reinitialized successfully", sensor->name.c_str());
+					}
+					else
+					{
+						sensor->consecutiveFailures = 0; // Reset counter to avoid spam
+					}
 				}
-
-				int burnUntil = 0;
-
-				if (heater->burnTime > 0)
+				continue;
+			}
+			
+			float rtd_resistance;
+			int64_t readStartedAt = esp_timer_get_time();
+			esp_err_t err = max31865_measure(&sensor->max31865Handle, &rtd_resistance, &temperature);
+			instance->perf.record(PerfRtdRead, esp_timer_get_time() - readStartedAt);
+			if (err != ESP_OK)
+			{
+				// Track consecutive failures for retry logic
+				sensor->consecutiveFailures++;
+				
+				if (err == ESP_ERR_NOT_FOUND)
 				{
-					burnUntil = ((double)heater->burnTime / 100) * (double)instance->pidLoopTime; // convert % back to seconds
+					// Probe disconnected - show disconnected status but keep trying
+					if (sensor->connected)
+					{
+						ESP_LOGW(TAG, "RTD probe [%s] disconnected", stringId.c_str());
+					}
 				}
-
-				if (burnUntil > i) // on
+				else
 				{
-					if (heater->burn != true) // only when not current, we don't want to spam the logs
+					// Other errors - keep trying but mark as disconnected
+					if (sensor->connected)
 					{
-						heater->burn = true;
-						ESP_LOGD(TAG, "Heater %s: On", heater->name.c_str());
+						ESP_LOGW(TAG, "Error reading temperature from RTD [%s]: %s", stringId.c_str(), esp_err_to_name(err));
 					}
 				}
-				else // off
+
+				sensor->connected = false;  // Mark as disconnected
+				instance->publishTemperature(slot++, sensor, -999.0, false); // Invalid temperature to show disconnected
+				
+				// Try to reinitialize after 5 consecutive failures
+				if (sensor->consecutiveFailures >= 5)
 				{
-					if (heater->burn != false) // only when not current, we don't want to spam the logs
+					ESP_LOGI(TAG, "Attempting to reinitialize RTD sensor %s after %d failures", sensor->name.c_str(), sensor->consecutiveFailures);
+					if (instance->reinitializeRtdSensor(sensor))
+					{
+						sensor->consecutiveFailures = 0;
+						ESP_LOGI(TAG, "RTD sensor %s reinitialized successfully", sensor->name.c_str());
+					}
+					else
 					{
-						heater->burn = false;
-						ESP_LOGD(TAG, "Heater %s: Off", heater->name.c_str());
+						sensor->consecutiveFailures = 0; // Reset counter to avoid spam
 					}
 				}
+				
+				continue; // Skip this sensor for control calculations
 			}
 
-			// when our target changes we also update our pid target
-			if (instance->resetPitTime)
+			// Successful reading - mark sensor as connected (recovery case)
+			if (!sensor->connected)
 			{
-				ESP_LOGI(TAG, "Reset Pid Timer");
-				instance->resetPitTime = false;
-				break;
+				ESP_LOGI(TAG, "RTD probe [%s] reconnected", stringId.c_str());
+				sensor->connected = true;
 			}
+			// Reset failure counter on successful read
+			sensor->consecutiveFailures = 0;
 
-			vTaskDelay(pdMS_TO_TICKS(1000));
+			instance->publishTemperature(slot++, sensor, temperature, true);
 		}
-	}
 
-	instance->pidOutput = 0;
+		instance->clearSamples(slot, RTD_SLOT_BASE + MAX_RTD_SENSORS);
+
+		xSemaphoreGiveRecursive(instance->sensorsMutex);
+	}
 
 	vTaskDelete(NULL);
 }
 
-void BrewEngine::outputLoop(void *arg)
+void BrewEngine::ntcReadLoop(void *arg)
 {
 	BrewEngine *instance = (BrewEngine *)arg;
 
-	for (auto const &heater : instance->heaters)
+	while (instance->run)
 	{
-		gpio_set_level(heater->pinNr, instance->gpioLow);
-	}
+		vTaskDelay(pdMS_TO_TICKS(500));
 
-	while (instance->run && instance->controlRun)
-	{
-		vTaskDelay(pdMS_TO_TICKS(1000));
+		// topology changes wait until we've read all sensors, we wait for theirs
+		xSemaphoreTakeRecursive(instance->sensorsMutex, portMAX_DELAY);
 
-		for (auto const &heater : instance->heaters)
+		size_t slot = NTC_SLOT_BASE;
+
+		for (auto &[key, sensor] : instance->sensors)
 		{
-			if (heater->burn)
+			if (sensor->sensorType != SENSOR_NTC)
 			{
-				ESP_LOGD(TAG, "Output %s: On", heater->name.c_str());
-				gpio_set_level(heater->pinNr, instance->gpioHigh);
+				continue;
 			}
-			else
+
+			if (slot >= NTC_SLOT_BASE + MAX_NTC_SENSORS)
 			{
-				ESP_LOGD(TAG, "Output %s: Off", heater->name.c_str());
-				gpio_set_level(heater->pinNr, instance->gpioLow);
+				break;
 			}
-		}
-	}
-
-	// set outputs off and quit thread
-	for (auto const &heater : instance->heaters)
-	{
-		gpio_set_level(heater->pinNr, instance->gpioLow);
-	}
-
-	vTaskDelete(NULL);
-}
-
-void BrewEngine::controlLoop(void *arg)
-{
-	BrewEngine *instance = (BrewEngine *)arg;
-
-	// the pid needs to reset one step later so the next temp is set, oherwise it has a delay
-	bool resetPIDNextStep = false;
-
-	// For boost mode to see if temp starts to drop
-	float prevTemperature = instance->temperature;
-	uint boostUntil = 0;
-
-	while (instance->run && instance->controlRun)
-	{
-
-		system_clock::time_point now = std::chrono::system_clock::now();
 
-		if (instance->executionSteps.size() >= instance->currentMashStep)
-		{ // there are more steps
-			int nextStepIndex = instance->currentMashStep;
-
-			auto nextStep = instance->executionSteps.at(nextStepIndex);
-
-			system_clock::time_point nextAction = nextStep->time;
-
-			bool gotoNextStep = false;
+			string stringId = std::to_string(key);
+			float temperature;
 
-			// set target when not overriden
-			if (instance->overrideTargetTemperature.has_value())
+			// NTC sensor reading via ADC
+			if (!instance->adcInitialized)
 			{
-				instance->targetTemperature = instance->overrideTargetTemperature.value();
+				ESP_LOGW(TAG, "ADC not initialized for NTC sensor [%s], skipping", stringId.c_str());
+				sensor->connected = false;
+				instance->publishTemperature(slot++, sensor, -999.0, false);
+				continue;
 			}
-			else
+
+			// Get ADC channel from GPIO pin (ESP32-S3 mapping)
+			adc_channel_t adc_channel;
+			switch (sensor->analogPin)
 			{
-				instance->targetTemperature = nextStep->temperature;
+				case 1: adc_channel = ADC_CHANNEL_0; break;
+				case 2: adc_channel = ADC_CHANNEL_1; break;
+				case 3: adc_channel = ADC_CHANNEL_2; break;
+				case 4: adc_channel = ADC_CHANNEL_3; break;
+				case 5: adc_channel = ADC_CHANNEL_4; break;
+				case 6: adc_channel = ADC_CHANNEL_5; break;
+				case 7: adc_channel = ADC_CHANNEL_6; break;
+				case 8: adc_channel = ADC_CHANNEL_7; break;
+				case 9: adc_channel = ADC_CHANNEL_8; break;
+				case 10: adc_channel = ADC_CHANNEL_9; break;
+				default:
+					ESP_LOGW(TAG, "Invalid analog pin %d for NTC sensor [%s] (supported: 1-10)", sensor->analogPin, stringId.c_str());
+					sensor->connected = false;
+					instance->publishTemperature(slot++, sensor, -999.0, false);
+					continue;
 			}
 
-			uint secondsToGo = 0;
-			// if its smaller 0 is ok!
-			if (nextAction > now)
+			// Read ADC value, a burst of oneshot reads averages out the adc noise
+			int adc_reading = 0;
+			int64_t readStartedAt = esp_timer_get_time();
+			esp_err_t read_err = ESP_OK;
+			int adc_sum = 0;
+			uint8_t oversample = std::max((uint8_t)1, sensor->oversample);
+			for (uint8_t i = 0; i < oversample && read_err == ESP_OK; i++)
+			{
+				read_err = adc_oneshot_read(instance->adc1_handle, adc_channel, &adc_reading);
+				adc_sum += adc_reading;
+			}
+			float raw = (float)adc_sum / oversample;
+			if (read_err != ESP_OK)
 			{
-				secondsToGo = chrono::duration_cast<chrono::seconds>(nextAction - now).count();
+				instance->perf.record(PerfNtcRead, esp_timer_get_time() - readStartedAt);
+				ESP_LOGW(TAG, "Error reading ADC for NTC sensor [%s]: %s", stringId.c_str(), esp_err_to_name(read_err));
+				sensor->connected = false;
+				instance->publishTemperature(slot++, sensor, -999.0, false);
+				continue;
 			}
 
-			// Boost mode logic
-			if (nextStep->allowBoost)
+			// calibration, divider and Beta equation are precomputed per adc code, rebuilt when the sensor settings change
+			std::unique_ptr<NtcTable> &table = instance->ntcTables[slot - NTC_SLOT_BASE];
+			bool calibrated = instance->adc1_cali_handle != nullptr;
+			if (!table || !table->matches(sensor->ntcResistance, sensor->dividerResistor, calibrated))
 			{
-				if (boostUntil == 0)
+				if (!table)
 				{
-					boostUntil = (uint)((nextStep->temperature / 100) * (float)instance->boostModeUntil);
+					table = std::make_unique<NtcTable>();
 				}
 
-				if (instance->boostStatus == Off && instance->temperature < boostUntil)
-				{
-
-					ESP_LOGI(TAG, "Boost Start Until: %d", boostUntil);
-					instance->logRemote("Boost Start");
-					instance->boostStatus = Boost;
-				}
-				else if (instance->boostStatus == Boost && instance->temperature >= boostUntil)
-				{
-					// When in boost mode we wait unit boost temp is reched, pid is locked to 100% in boost mode
-					ESP_LOGI(TAG, "Boost Rest Start");
-					instance->logRemote("Boost Rest Start");
-					instance->boostStatus = Rest;
-				}
-				else if (instance->boostStatus == Rest && instance->temperature < prevTemperature)
-				{
-					// When in boost rest mode, we wait until temperature drops pid is locked to 0%
-					ESP_LOGI(TAG, "Boost Rest End");
-					instance->logRemote("Boost Rest End");
-					instance->boostStatus = Off;
+				adc_cali_handle_t caliHandle = instance->adc1_cali_handle;
+				table->build(sensor->ntcResistance, sensor->dividerResistor, calibrated, [caliHandle](int code) {
+					int voltage_mv = 0;
+					if (caliHandle != nullptr && adc_cali_raw_to_voltage(caliHandle, code, &voltage_mv) == ESP_OK)
+					{
+						return (float)voltage_mv;
+					}
+					// Fallback: approximate conversion for 12-bit ADC with 3.3V reference
+					return code * NTC_SUPPLY_MV / NTC_ADC_MAX;
+				});
 
-					// Reset pid
-					instance->resetPitTime = true;
-				}
+				ESP_LOGI(TAG, "NTC table for [%s] built, max interpolation error %.3f°C", stringId.c_str(), table->maxError);
 			}
 
-			if (secondsToGo < 1)
-			{ // change temp and increment Currentstep
-
-				// string iso_string = instance->to_iso_8601(nextStep->time);
-				// ESP_LOGI(TAG, "Control Time:%s, TempCur:%f, TempTarget:%d, Extend:%d, Overtime: %d", iso_string.c_str(), instance->temperature, nextStep->temperature, nextStep->extendIfNeeded, instance->inOverTime);
-
-				if (nextStep->extendIfNeeded == true && instance->inOverTime == false && (nextStep->temperature - instance->temperature) >= instance->tempMargin)
-				{
-					// temp must be reached, we keep going but need to triger a recaluclation event when done
-					ESP_LOGI(TAG, "OverTime Start");
-					instance->logRemote("OverTime Start");
-					instance->inOverTime = true;
-				}
-				else if (instance->inOverTime == true && (nextStep->temperature - instance->temperature) <= instance->tempMargin)
-				{
-					// we reached out temp after overtime, we need to recalc the rest and start going again
-					ESP_LOGI(TAG, "OverTime Done");
-					instance->logRemote("OverTime Done");
-					instance->inOverTime = false;
-					instance->recalculateScheduleAfterOverTime();
-					gotoNextStep = true;
-				}
-				else if (instance->inOverTime == false)
-				{
-					ESP_LOGI(TAG, "Going to next Step");
-					gotoNextStep = true;
-					// also reset override on step change
-					instance->overrideTargetTemperature = std::nullopt;
-				}
+			NtcResult result = table->lookup(raw, temperature);
+			instance->perf.record(PerfNtcRead, esp_timer_get_time() - readStartedAt);
 
-				// else when in overtime just keep going until we reach temp
+			if (result == NtcShort)
+			{
+				ESP_LOGW(TAG, "NTC sensor [%s] voltage too low (ADC=%.0f), possible short circuit", stringId.c_str(), raw);
+				sensor->connected = false;
+				instance->publishTemperature(slot++, sensor, -999.0, false);
+				continue;
 			}
 
-			// the pid needs to reset one step later so the next temp is set, oherwise it has a delay
-			if (resetPIDNextStep)
+			if (result == NtcOpen)
 			{
-				resetPIDNextStep = false;
-				instance->resetPitTime = true;
+				ESP_LOGW(TAG, "NTC sensor [%s] voltage too high (ADC=%.0f), possible open circuit or disconnection", stringId.c_str(), raw);
+				sensor->connected = false;
+				instance->publishTemperature(slot++, sensor, -999.0, false);
+				continue;
 			}
 
-			if (gotoNextStep)
+			// Sanity check - temperature should be reasonable for brewing applications
+			// Allow wider range to permit sensor recovery and different applications
+			if (result == NtcOutOfRange)
 			{
-				instance->currentMashStep++;
-
-				// Also reset boost
-				instance->boostStatus = Off;
-
-				resetPIDNextStep = true;
+				ESP_LOGW(TAG, "NTC sensor [%s] reading out of range (ADC=%.0f)", stringId.c_str(), raw);
+				sensor->connected = false;
+				instance->publishTemperature(slot++, sensor, -999.0, false);
+				continue;
 			}
 
-			// notifications, but only when not in overtime
-			if (!instance->inOverTime && !instance->notifications.empty())
+			// Mark sensor as connected
+			if (!sensor->connected)
 			{
-				// filter out items that are not done
-				auto isNotDone = [](Notification *notification)
-				{ return notification->done == false; };
-
-				auto notDone = instance->notifications | views::filter(isNotDone);
-
-				if (!notDone.empty())
-				{
-					// they are sorted so we just have to check the first one
-					auto first = notDone.front();
-
-					if (now > first->timePoint)
-					{
-						ESP_LOGI(TAG, "Notify %s", first->name.c_str());
+				ESP_LOGI(TAG, "NTC sensor [%s] connected", stringId.c_str());
+			}
+			sensor->connected = true;
+			sensor->consecutiveFailures = 0;
 
-						string buzzerName = "buzzer" + first->name;
-						xTaskCreate(&instance->buzzer, buzzerName.c_str(), 1024, instance, 10, NULL);
+			ESP_LOGD(TAG, "NTC sensor [%s]: ADC=%.1f, T=%.1f°C", stringId.c_str(), raw, temperature);
 
-						first->done = true;
-					}
-				}
-			}
-		}
-		else
-		{
-			// last step need to stop
-			ESP_LOGI(TAG, "Program Finished");
-			instance->stop();
+			instance->publishTemperature(slot++, sensor, temperature, true);
 		}
 
-		// For boost mode to see if temp starts to drop
-		prevTemperature = instance->temperature;
+		instance->clearSamples(slot, NTC_SLOT_BASE + MAX_NTC_SENSORS);
 
-		vTaskDelay(pdMS_TO_TICKS(1000));
+		xSemaphoreGiveRecursive(instance->sensorsMutex);
 	}
 
 	vTaskDelete(NULL);
 }
 
-string BrewEngine::bootIntoRecovery()
+void BrewEngine::pidLoop(void *arg)
 {
-	// recovery is our factory
-	esp_partition_subtype_t t = ESP_PARTITION_SUBTYPE_APP_FACTORY;
-	const esp_partition_t *factory_partition = esp_partition_find_first(ESP_PARTITION_TYPE_APP, t, NULL);
+	BrewEngine *instance = (BrewEngine *)arg;
 
-	if (factory_partition == NULL)
+	double kP, kI, kD;
+	if (instance->boilRun)
 	{
-		ESP_LOGE(TAG, "Factory Partition not found!");
-		return "Error: Factory Partition not found!";
+		kP = instance->boilkP;
+		kI = instance->boilkI;
+		kD = instance->boilkD;
 	}
-
-	if (esp_ota_set_boot_partition(factory_partition) == ESP_OK)
+	else
 	{
-		return "Device is booting into recovery hold on!";
+		kP = instance->mashkP;
+		kI = instance->mashkI;
+		kD = instance->mashkD;
 	}
 
-	return "Error: Unable to chage boot Partition!";
-}
+	uint totalWattage = instance->enableHeaters();
 
-void BrewEngine::reboot(void *arg)
-{
-	vTaskDelay(2000 / portTICK_PERIOD_MS);
-	esp_restart();
-}
+	KettleController controller(kP, kI, kD, instance->pidLoopTime, totalWattage, instance->boilRun, instance->thermalModel);
 
-void BrewEngine::buzzer(void *arg)
-{
-	BrewEngine *instance = (BrewEngine *)arg;
+	int64_t lastRun = esp_timer_get_time();
+	int outputPercent = 0;
+
+	bool firstRun = true;
 
-	if (instance->buzzer_PIN > 0)
+	while (instance->run && instance->controlRun)
 	{
-		auto buzzerMs = instance->buzzerTime * 1000;
-		gpio_set_level(instance->buzzer_PIN, instance->gpioHigh);
-		vTaskDelay(buzzerMs / portTICK_PERIOD_MS);
-		gpio_set_level(instance->buzzer_PIN, instance->gpioLow);
-	}
+		int64_t now = esp_timer_get_time();
+		double dt = (double)(now - lastRun) / 1000000;
 
-	vTaskDelete(NULL);
-}
+		if (!firstRun)
+		{
+			instance->perf.record(PerfPidLate, (now - lastRun) - PID_SAMPLE_TIME_MS * 1000);
+		}
+		firstRun = false;
+		lastRun = now;
 
-string BrewEngine::processCommand(const string &payLoad)
-{
-	ESP_LOGD(TAG, "payLoad %s", payLoad.c_str());
+		// fail safe, the pid and the model never see a temperature that isn't measured
+		if (!instance->temperatureValid)
+		{
+			instance->pidOutput = 0;
+			outputPercent = 0;
+			instance->setHeaterOutput(0, totalWattage);
+			controller.applied(0);
+			controller.pause();
 
-	json jCommand = json::parse(payLoad);
-	string command = jCommand["command"];
-	json data = jCommand["data"];
+			vTaskDelay(pdMS_TO_TICKS(PID_SAMPLE_TIME_MS));
+			continue;
+		}
 
-	ESP_LOGD(TAG, "processCommand %s", command.c_str());
-	ESP_LOGD(TAG, "data %s", data.dump().c_str());
+		bool overridden = instance->manualOverrideOutput.has_value() || instance->boostStatus != Off;
 
-	json resultData = {};
-	string message = "";
-	bool success = true;
-
-	if (command == "Data")
-	{
-		time_t lastLogDateTime = time(0);
-
-		json jTempLog = json::array({});
-		if (!this->tempLog.empty())
+		if (!overridden && !controller.inControl())
 		{
-			auto lastLog = this->tempLog.rend();
-			lastLogDateTime = lastLog->first;
-
-			// If we have a last date we only need to send the log increment
-			if (!data["lastDate"].is_null() && data["lastDate"].is_number())
-			{
-				time_t lastClientDate = (time_t)data["lastDate"];
-				ESP_LOGD(TAG, "lastClientDate %s", ctime(&lastClientDate));
-
-				// most efficient seems to loop reverse and add until date is reached
-				for (auto iter = this->tempLog.rbegin(); iter != this->tempLog.rend(); ++iter)
-				{
-					if (iter->first > lastClientDate)
-					{
-						json jTempLogItem;
-						jTempLogItem["time"] = iter->first;
-						// Handle both old format (integers) and new format (tenths)
-						// New format values are typically > 100 (e.g., 270 for 27.0°C)
-						// Old format values are typically < 100 (e.g., 27 for 27°C)
-						double tempValue;
-						if (iter->second > 100 || iter->second < 0) {
-							// New format: stored as tenths of degrees
-							tempValue = (double)(iter->second) / 10.0;
-						} else {
-							// Old format: stored as whole degrees
-							tempValue = (double)(iter->second);
-						}
-						jTempLogItem["temp"] = tempValue;
-						jTempLog.push_back(jTempLogItem);
-					}
-					else
-					{
-						break;
-					}
-				}
-			}
-			else
-			{
-				for (auto iter = this->tempLog.rbegin(); iter != this->tempLog.rend(); ++iter)
-				{
-					json jTempLogItem;
-					jTempLogItem["time"] = iter->first;
-					// Handle both old format (integers) and new format (tenths)
-					// New format values are typically > 100 (e.g., 270 for 27.0°C)
-					// Old format values are typically < 100 (e.g., 27 for 27°C)
-					double tempValue;
-					if (iter->second > 100 || iter->second < 0) {
-						// New format: stored as tenths of degrees
-						tempValue = (double)(iter->second) / 10.0;
-					} else {
-						// Old format: stored as whole degrees
-						tempValue = (double)(iter->second);
-					}
-					jTempLogItem["temp"] = tempValue;
-					jTempLog.push_back(jTempLogItem);
-				}
-			}
+			ESP_LOGI(TAG, "Pid takes over at %d%%", outputPercent);
 		}
 
-		// currenttemps is an array of current temps, they are not necessarily all used for control
-		json jCurrentTemps = json::array({});
-		for (auto const &[key, val] : this->currentTemperatures)
+		// Output is %
+		int pidPercent = controller.compute((double)instance->temperature, (double)instance->targetTemperature, instance->targetSlope, dt, overridden);
+		if (pidPercent != instance->pidOutput)
 		{
-			json jCurrentTemp;
-			jCurrentTemp["sensor"] = to_string(key);			   // js doesn't support unint64
-			jCurrentTemp["temp"] = (double)((int)(val * 10)) / 10; // round float to 1 digit for display
-			jCurrentTemps.push_back(jCurrentTemp);
+			ESP_LOGI(TAG, "Pid Output: %d Target: %f", pidPercent, instance->targetTemperature);
 		}
+		instance->pidOutput = pidPercent;
+		outputPercent = pidPercent;
 
-		// Get system resource usage
-		uint32_t freeHeap = esp_get_free_heap_size();
-		uint32_t totalHeap = heap_caps_get_total_size(MALLOC_CAP_DEFAULT);
-		uint32_t usedHeap = totalHeap - freeHeap;
-		float memoryUsagePercent = ((float)usedHeap / (float)totalHeap) * 100.0f;
-		
-		// Simple CPU usage estimation based on system activity
-		// Uses memory allocation patterns and task switching as indicators
-		static uint32_t lastCpuCheck = 0;
-		static uint32_t lastFreeHeap = 0;
-		static uint32_t lastMinFreeHeap = 0;
-		static float cpuUsagePercent = 15.0f; // Start with baseline 15%
-		
-		uint32_t currentTime = esp_timer_get_time() / 1000; // Convert to milliseconds
-		
-		// Update CPU usage estimation every 2000ms
-		if (currentTime - lastCpuCheck >= 2000) {
-			uint32_t currentFreeHeap = esp_get_free_heap_size();
-			uint32_t currentMinFreeHeap = esp_get_minimum_free_heap_size();
-			
-			if (lastCpuCheck > 0) {
-				// Method 1: Heap activity indicates CPU usage
-				uint32_t heapActivity = 0;
-				if (currentFreeHeap != lastFreeHeap) {
-					heapActivity = abs((int32_t)(currentFreeHeap - lastFreeHeap));
-				}
-				
-				// Method 2: Minimum free heap changes indicate memory pressure
-				uint32_t memPressure = 0;
-				if (currentMinFreeHeap != lastMinFreeHeap) {
-					memPressure = abs((int32_t)(currentMinFreeHeap - lastMinFreeHeap));
-				}
-				
-				// Calculate CPU usage based on system activity
-				float activityFactor = (float)(heapActivity + memPressure * 2) / 1024.0f;
-				cpuUsagePercent = 15.0f + (activityFactor * 5.0f); // Base 15% + activity
-				
-				// Add some variation based on temperature sensor activity
-				if (this->currentTemperatures.size() > 0) {
-					cpuUsagePercent += (float)this->currentTemperatures.size() * 2.0f;
-				}
-				
-				// Add load based on PID controller activity
-				if (this->pidOutput > 0) {
-					cpuUsagePercent += (this->pidOutput / 100.0f) * 10.0f;
-				}
-				
-				// Clamp between realistic values
-				if (cpuUsagePercent < 5.0f) cpuUsagePercent = 5.0f;
-				if (cpuUsagePercent > 85.0f) cpuUsagePercent = 85.0f;
-			}
-			
-			lastCpuCheck = currentTime;
-			lastFreeHeap = currentFreeHeap;
-			lastMinFreeHeap = currentMinFreeHeap;
-		}
-
-		// sensorTempLogs removed - will fetch from database instead to save memory
-		resultData = {
-			{"temp", (double)((int)(this->temperature * 10)) / 10}, // round float to 1 digit for display
-			{"temps", jCurrentTemps},
-			{"targetTemp", (double)((int)(this->targetTemperature * 10)) / 10}, // round float to 1 digit for display,
-			{"manualOverrideTargetTemp", nullptr},
-			{"output", this->pidOutput},
-			{"manualOverrideOutput", nullptr},
-			{"status", this->statusText},
-			{"stirStatus", this->stirStatusText},
-			{"lastLogDateTime", lastLogDateTime},
-			{"tempLog", json::array({})}, // Empty array for backward compatibility
-			{"sensorTempLogs", json::array({})}, // Empty array - will fetch from database instead
-			{"runningVersion", this->runningVersion},
-			{"inOverTime", this->inOverTime},
-			{"boostStatus", this->boostStatus},
-			{"systemInfo", {
-				{"freeHeap", freeHeap},
-				{"totalHeap", totalHeap},
-				{"usedHeap", usedHeap},
-				{"memoryUsagePercent", (double)((int)(memoryUsagePercent * 10)) / 10},
-				{"cpuUsagePercent", (double)((int)(cpuUsagePercent * 10)) / 10}
-			}},
-		};
-
-		if (this->manualOverrideOutput.has_value())
+		// Manual override and boost
+		if (instance->manualOverrideOutput.has_value())
 		{
-			resultData["manualOverrideOutput"] = this->manualOverrideOutput.value();
+			// Here we don't override the pidOutput display since we want the user to see the pid values even when overriding
+			outputPercent = instance->manualOverrideOutput.value();
 		}
-
-		if (this->overrideTargetTemperature.has_value())
+		else if (instance->boostStatus == Boost)
 		{
-			resultData["manualOverrideTargetTemp"] = this->overrideTargetTemperature.value();
+			outputPercent = 100;
+			instance->pidOutput = 100;
 		}
-	}
-	else if (command == "GetRunningSchedule")
-	{
-		json jRunningSchedule;
-		jRunningSchedule["version"] = this->runningVersion;
-
-		json jExecutionSteps = json::array({});
-		for (auto const &[key, val] : this->executionSteps)
+		else if (instance->boostStatus == Rest)
 		{
-			json jExecutionStep = val->to_json();
-			jExecutionSteps.push_back(jExecutionStep);
+			outputPercent = 0;
+			instance->pidOutput = 0;
 		}
-		jRunningSchedule["steps"] = jExecutionSteps;
 
-		json jNotifications = json::array({});
-		for (auto &notification : this->notifications)
+		// the model learns from what the power budget let through, not from what we asked
+		int grantedPercent = instance->setHeaterOutput(outputPercent, totalWattage);
+		controller.applied(grantedPercent);
+
+		instance->perf.record(PerfPidCompute, esp_timer_get_time() - now);
+
+		// when our target changes we restart the output window, so the new demand is applied right away
+		if (instance->resetPitTime)
 		{
-			json jNotification = notification->to_json();
-			jNotifications.push_back(jNotification);
+			ESP_LOGI(TAG, "Reset Pid Timer");
+			instance->resetPitTime = false;
+			instance->outputTick = 0;
 		}
-		jRunningSchedule["notifications"] = jNotifications;
 
-		resultData = jRunningSchedule;
+		vTaskDelay(pdMS_TO_TICKS(PID_SAMPLE_TIME_MS));
 	}
-	else if (command == "SetTemp")
-	{
 
-		if (data["targetTemp"].is_null())
-		{
-			this->overrideTargetTemperature = std::nullopt;
+	instance->releaseHeaters(0);
 
-			// when not in a program also direclty set targtetemp
-			if (this->selectedMashScheduleName.empty() == true)
-			{
-				this->targetTemperature = 0;
-			}
-		}
-		else if (data["targetTemp"].is_number())
-		{
+	instance->pidOutput = 0;
 
-			this->overrideTargetTemperature = (float)data["targetTemp"];
+	if (!instance->boilRun && !instance->simulation)
+	{
+		instance->saveThermalModel();
+	}
 
-			// when not in a program also direclty set targtetemp
-			if (this->selectedMashScheduleName.empty() == true)
-			{
-				this->targetTemperature = this->overrideTargetTemperature.value();
-			}
-		}
-		else
-		{
-			this->overrideTargetTemperature = std::nullopt;
+	vTaskDelete(NULL);
+}
 
-			message = "Incorrect data, integer or float expected!";
-			success = false;
-		}
-	}
-	else if (command == "SetOverrideOutput")
+// Enables the heaters for the current mode (mash or boil), returns the total wattage we have availible
+uint BrewEngine::enableHeaters()
+{
+	uint totalWattage = 0;
+
+	for (auto &heater : this->heaters)
 	{
+		// heaters of the other vessels are enabled by their own loop
+		if (heater->vessel != 0)
+		{
+			continue;
+		}
 
-		if (data["output"].is_null() == false && data["output"].is_number())
+		if ((this->boilRun && heater->useForBoil) || (!this->boilRun && heater->useForMash))
 		{
-			this->manualOverrideOutput = (int)data["output"];
+			totalWattage += heater->watt;
+			heater->enabled = true;
 		}
 		else
 		{
-			this->manualOverrideOutput = std::nullopt;
+			heater->enabled = false;
 		}
-
-		// reset so effect is immidiate
-		this->resetPitTime = true;
 	}
-	else if (command == "Start")
+
+	return totalWattage;
+}
+
+// Spreads the requested output over the enabled heaters of a vessel by preference, the power budget then decides what they get.
+// Returns the output (% of totalWattage) that was granted, that is what the heaters of the vessel really switch.
+int BrewEngine::setHeaterOutput(int outputPercent, uint totalWattage, uint8_t vessel)
+{
+	// calc the wattage we need
+	int outputWatt = (totalWattage / 100) * outputPercent;
+
+	// we need to calculate our burn time per output, each heater is only written once so the output timer never sees a half calculated state
+	for (auto &heater : this->heaters)
 	{
-		if (data["selectedMashSchedule"].is_null())
+		if (heater->vessel != vessel)
 		{
-			this->selectedMashScheduleName.clear();
-		}
-		else
-		{
-			this->selectedMashScheduleName = (string)data["selectedMashSchedule"];
+			continue;
 		}
 
-		this->start();
-		this->statisticsManager->StartSession(this->selectedMashScheduleName);
-		
-		// Log session start to Firebase
-		if (this->firebaseEnabled)
+		uint8_t burnTime = 0;
+
+		if (heater->enabled && outputWatt > 0)
 		{
-			// Session metadata is now tracked by local statistics manager
-			ESP_LOGI(TAG, "Session started - metadata logged locally and to Firebase via temperature writes");
+			// we can complete it with this heater
+			if (heater->watt > outputWatt)
+			{
+				burnTime = (int)(((double)outputWatt / (double)heater->watt) * 100);
+				ESP_LOGD(TAG, "Pid Calc Heater %s: OutputWatt: %d Burn: %d", heater->name.c_str(), outputWatt, burnTime);
+				outputWatt = 0;
+			}
+			else
+			{
+				// we can't complete it, take out part and continue
+				outputWatt -= heater->watt;
+				burnTime = 100;
+				ESP_LOGD(TAG, "Pid Calc Heater %s: OutputWatt: %d Burn: 100", heater->name.c_str(), outputWatt);
+			}
 		}
+
+		heater->requestedBurnTime = burnTime;
 	}
-	else if (command == "StartStir")
+
+	this->applyPowerBudget();
+
+	if (totalWattage == 0)
 	{
-		this->startStir(data);
+		return 0;
 	}
-	else if (command == "Stop")
+
+	uint32_t grantedWatt = 0;
+	portENTER_CRITICAL(&this->powerLock);
+	for (auto const &heater : this->heaters)
 	{
-		this->stop();
-		this->statisticsManager->EndSession();
-		
-		// Log session end to Firebase
-		if (this->firebaseEnabled)
+		if (heater->vessel == vessel)
 		{
-			// Session metadata is now tracked by local statistics manager
-			ESP_LOGI(TAG, "Session ended - metadata logged locally");
+			grantedWatt += (uint32_t)heater->watt * heater->burnTime / 100;
 		}
 	}
-	else if (command == "StopStir")
-	{
-		this->stopStir();
-	}
-	else if (command == "GetMashSchedules")
-	{
+	portEXIT_CRITICAL(&this->powerLock);
 
-		json jSchedules = json::array({});
+	return (int)std::min((uint32_t)100, grantedWatt * 100 / totalWattage);
+}
 
-		for (auto const &[key, val] : this->mashSchedules)
-		{
-			json jSchedule = val->to_json();
-			jSchedules.push_back(jSchedule);
-		}
+// All vessels share maxPower, heaters are served in preference order so the most important element keeps its power.
+// The on windows are laid out per slot of the window (PowerBudget), heaters only overlap where together they fit maxPower,
+// so every grant is also what the output timer switches.
+void BrewEngine::applyPowerBudget()
+{
+	portENTER_CRITICAL(&this->powerLock);
 
-		resultData = jSchedules;
-	}
-	else if (command == "SaveMashSchedule")
-	{
-		this->setMashSchedule(data);
+	this->powerBudget.reset(this->maxPower);
 
-		this->saveMashSchedules();
-	}
-	else if (command == "SetMashSchedule") // used by import function to set but not save
+	for (auto &heater : this->heaters)
 	{
-		this->setMashSchedule(data);
-	}
-	else if (command == "DeleteMashSchedule")
-	{
-		string deleteName = (string)data["name"];
+		PowerGrant grant = {0, 0};
 
-		auto pos = this->mashSchedules.find(deleteName);
-
-		if (pos == this->mashSchedules.end())
-		{
-			message = "Schedule with name: " + deleteName + " not found";
-			success = false;
-		}
-		else
+		if (heater->enabled && heater->requestedBurnTime > 0)
 		{
-			this->mashSchedules.erase(pos);
-			this->saveMashSchedules();
+			int currentPhase = (heater->burnTime > 0) ? heater->phaseOffset : -1;
+			grant = this->powerBudget.place(heater->watt, heater->requestedBurnTime, currentPhase);
 		}
-	}
-	else if (command == "GetPIDSettings")
-	{
-		resultData = {
-			{"kP", this->mashkP},
-			{"kI", this->mashkI},
-			{"kD", this->mashkD},
-			{"boilkP", this->boilkP},
-			{"boilkI", this->boilkI},
-			{"boilkD", this->boilkD},
-			{"pidLoopTime", this->pidLoopTime},
-			{"stepInterval", this->stepInterval},
-			{"boostModeUntil", this->boostModeUntil},
-		};
-	}
-	else if (command == "SavePIDSettings")
-	{
-		this->mashkP = data["kP"].get<double>();
-		this->mashkI = data["kI"].get<double>();
-		this->mashkD = data["kD"].get<double>();
-		this->boilkP = data["boilkP"].get<double>();
-		this->boilkI = data["boilkI"].get<double>();
-		this->boilkD = data["boilkD"].get<double>();
-		this->pidLoopTime = data["pidLoopTime"].get<uint16_t>();
-		this->stepInterval = data["stepInterval"].get<uint16_t>();
-		this->boostModeUntil = data["boostModeUntil"].get<uint8_t>();
-		this->savePIDSettings();
-	}
-	else if (command == "GetTempSettings")
-	{
-		// Convert sensors to json
-		json jSensors = json::array({});
 
-		for (auto const &[key, val] : this->sensors)
+		// burst fire keeps its accumulator, we only give it the phase when it starts
+		if (grant.burnTime > 0 && heater->burnTime == 0)
 		{
-			json jSensor = val->to_json();
-			jSensors.push_back(jSensor);
+			heater->burstAccumulator = grant.phase;
 		}
 
-		resultData = jSensors;
+		// a window only moves when staying would give less, it then moves right away so it never overlaps the new layout
+		heater->phaseOffset = grant.phase;
+		heater->burnTime = grant.burnTime;
 	}
-	else if (command == "SaveTempSettings")
+
+	portEXIT_CRITICAL(&this->powerLock);
+}
+
+// Turns off the heaters of a vessel, the output timer only stops when no vessel needs it anymore
+void BrewEngine::releaseHeaters(uint8_t vessel)
+{
+	for (auto &heater : this->heaters)
 	{
-		this->saveTempSensorSettings(data);
+		if (heater->vessel == vessel)
+		{
+			heater->enabled = false;
+			heater->requestedBurnTime = 0;
+		}
 	}
-	else if (command == "DetectTempSensors")
+
+	this->applyPowerBudget();
+
+	if (!this->controlRun && !this->vesselsRunning())
 	{
-		this->detectOnewireTemperatureSensors();
+		this->stopOutputTimer();
+		return;
 	}
-	else if (command == "AddRtdSensor")
+
+	for (auto &heater : this->heaters)
 	{
-		if (!this->rtdSensorsEnabled)
+		if (heater->vessel == vessel)
 		{
-			success = false;
-			message = "RTD sensors are not enabled in system settings";
-		}
-		else
-		{
-			string name = data["name"];
-			int csPin = data["csPin"];
-			int sensorType = data["sensorType"];
-			bool useForControl = data["useForControl"];
-			bool show = data["show"];
-			
-			// Generate unique ID for RTD sensor
-			uint64_t rtdSensorId = 0x31865000 + csPin; // Base ID + CS pin
-			
-			// Check if sensor already exists
-			if (this->sensors.find(rtdSensorId) != this->sensors.end())
-			{
-				success = false;
-				message = "RTD sensor with CS pin " + to_string(csPin) + " already exists";
-			}
-			else
+			heater->burn = false;
+			if (!this->simulation)
 			{
-				// Validate GPIO pin
-				if (csPin < 0 || csPin >= GPIO_NUM_MAX)
-				{
-					success = false;
-					message = "Invalid CS pin number: " + to_string(csPin);
-				}
-				else
-				{
-					// Initialize MAX31865 device (SPI bus should already be initialized)
-					max31865_t *rtd_sensor = new max31865_t;
-					esp_err_t ret = max31865_init_desc(rtd_sensor, SPI2_HOST, csPin);
-					
-					if (ret == ESP_OK)
-					{
-						// Configure MAX31865
-						ret = max31865_set_config(rtd_sensor, true, 1, false, false, 0, true, true, 0, 0xFFFF);
-					}
-					
-					if (ret == ESP_OK)
-					{
-						// Set RTD parameters based on sensor type
-						if (sensorType == SENSOR_PT100)
-						{
-							rtd_sensor->rtd_nominal = 100;
-							rtd_sensor->ref_resistor = 430;
-						}
-						else if (sensorType == SENSOR_PT1000)
-						{
-							rtd_sensor->rtd_nominal = 1000;
-							rtd_sensor->ref_resistor = 4300;
-						}
-						
-						// Create temperature sensor object
-						auto sensor = new TemperatureSensor();
-						sensor->id = rtdSensorId;
-						sensor->name = name;
-						sensor->color = (sensorType == SENSOR_PT100) ? "#00C853" : "#FF9800"; // Green for PT100, Orange for PT1000
-						sensor->useForControl = useForControl;
-						sensor->show = show;
-						sensor->connected = true;
-						sensor->compensateAbsolute = 0;
-						sensor->compensateRelative = 1;
-						sensor->sensorType = (SensorType)sensorType;
-						sensor->max31865Handle = *rtd_sensor;
-						sensor->consecutiveFailures = 0; // Initialize failure counter
-						
-						this->sensors.insert_or_assign(sensor->id, sensor);
-						this->rtdSensors.push_back(rtd_sensor);
-						this->rtdSensorCount++;
-						
-						// Save sensor settings
-						json jSensors = json::array({});
-						for (auto const &[key, val] : this->sensors)
-						{
-							json jSensor = val->to_json();
-							jSensors.push_back(jSensor);
-						}
-						this->saveTempSensorSettings(jSensors);
-						
-						ESP_LOGI(TAG, "RTD sensor added successfully: %s (CS pin %d)", name.c_str(), csPin);
-						message = "RTD sensor added successfully";
-					}
-					else
-					{
-						delete rtd_sensor;
-						success = false;
-						message = "Failed to initialize MAX31865: " + string(esp_err_to_name(ret));
-						ESP_LOGE(TAG, "Failed to initialize RTD sensor: %s", esp_err_to_name(ret));
-					}
-				}
+				gpio_set_level(heater->pinNr, this->gpioLow);
 			}
 		}
 	}
-	else if (command == "AddNtcSensor")
+}
+
+bool BrewEngine::vesselsRunning()
+{
+	for (auto const &vessel : this->vessels)
 	{
-		string name = data["name"];
-		int analogPin = data["analogPin"];
-		int sensorType = data["sensorType"];
-		float ntcResistance = data["ntcResistance"];
-		float dividerResistor = data["dividerResistor"];
-		bool useForControl = data["useForControl"];
-		bool show = data["show"];
-		
-		// Generate unique ID for NTC sensor
-		uint64_t ntcSensorId = 0x4E544300 + analogPin; // "NTC" base ID + analog pin
-		
-		// Check if sensor already exists
-		if (this->sensors.find(ntcSensorId) != this->sensors.end())
-		{
-			success = false;
-			message = "NTC sensor with analog pin " + to_string(analogPin) + " already exists";
-		}
-		else
+		if (vessel->running)
 		{
-			// Validate GPIO pin
-			if (analogPin < 0 || analogPin >= GPIO_NUM_MAX)
-			{
-				success = false;
-				message = "Invalid analog pin number: " + to_string(analogPin);
-			}
-			else
-			{
-				// Create temperature sensor object
-				auto sensor = new TemperatureSensor();
-				sensor->id = ntcSensorId;
-				sensor->name = name;
-				sensor->color = "#9C27B0"; // Purple for NTC
-				sensor->useForControl = useForControl;
-				sensor->show = show;
-				sensor->connected = true; // NTC sensors are always "connected" if properly wired
-				sensor->compensateAbsolute = 0;
-				sensor->compensateRelative = 1;
-				sensor->sensorType = (SensorType)sensorType;
-				sensor->analogPin = analogPin;
-				sensor->ntcResistance = ntcResistance;
-				sensor->dividerResistor = dividerResistor;
-				sensor->consecutiveFailures = 0;
-				
-				this->sensors.insert_or_assign(sensor->id, sensor);
-				
-				// Save sensor settings
-				json jSensors = json::array({});
-				for (auto const &[key, val] : this->sensors)
-				{
-					json jSensor = val->to_json();
-					jSensors.push_back(jSensor);
-				}
-				this->saveTempSensorSettings(jSensors);
-				
-				ESP_LOGI(TAG, "NTC sensor added successfully: %s (analog pin %d)", name.c_str(), analogPin);
-				message = "NTC sensor added successfully";
-			}
+			return true;
 		}
 	}
-	else if (command == "GetHeaterSettings")
-	{
-		// Convert heaters to json
-		json jHeaters = json::array({});
 
-		for (auto const &heater : this->heaters)
-		{
-			json jHeater = heater->to_json();
-			jHeaters.push_back(jHeater);
-		}
+	return false;
+}
 
-		resultData = jHeaters;
-	}
-	else if (command == "SaveHeaterSettings")
+// Holds a vessel at its setpoint, a running vessel only gets its target updated
+string BrewEngine::startVessel(const json &config)
+{
+	if (config["id"].is_null() || !config["id"].is_number_integer())
 	{
-		if (this->controlRun)
-		{
-			message = "You cannot save heater settings while running!";
-			success = false;
-		}
-		else
-		{
-			this->saveHeaterSettings(data);
-		}
+		return "Incorrect data, id expected!";
 	}
-	else if (command == "GetWifiSettings")
+
+	if (this->simulation)
 	{
-		// get data from wifi-connect
-		if (this->GetWifiSettingsJson)
-		{
-			resultData = this->GetWifiSettingsJson();
-		}
+		return "Stop the simulation before starting a vessel";
 	}
-	else if (command == "SaveWifiSettings")
+
+	uint8_t id = (uint8_t)config["id"];
+	auto it = std::find_if(this->vessels.begin(), this->vessels.end(), [id](Vessel *v)
+						   { return v->id == id; });
+	if (it == this->vessels.end())
 	{
-		// save via wifi-connect
-		if (this->SaveWifiSettingsJson)
-		{
-			this->SaveWifiSettingsJson(data);
-		}
-		message = "Please restart device for changes to have effect!";
+		return "Unknown vessel";
 	}
-	else if (command == "ScanWifi")
+
+	Vessel *vessel = *it;
+
+	float target = vessel->setpoint;
+	if (!config["targetTemp"].is_null() && config["targetTemp"].is_number())
 	{
-		// scans for networks
-		if (this->ScanWifiJson)
-		{
-			resultData = this->ScanWifiJson();
-		}
+		target = (float)config["targetTemp"];
 	}
-	else if (command == "GetSystemSettings")
+	vessel->targetTemperature = target;
+
+	if (vessel->running)
 	{
-		resultData = {
-			{"onewirePin", this->oneWire_PIN},
-			{"stirPin", this->stir_PIN},
-			{"buzzerPin", this->buzzer_PIN},
-			{"buzzerTime", this->buzzerTime},
-			{"invertOutputs", this->invertOutputs},
-			{"mqttUri", this->mqttUri},
-			{"temperatureScale", this->temperatureScale},
-			{"rtdSensorsEnabled", this->rtdSensorsEnabled},
-			{"spiMosiPin", this->spi_mosi_pin},
-			{"spiMisoPin", this->spi_miso_pin},
-			{"spiClkPin", this->spi_clk_pin},
-			{"spiCsPin", this->spi_cs_pin},
-			{"firebaseUrl", this->firebaseUrl},
-			{"firebaseApiKey", this->firebaseApiKey},
-			{"firebaseAuthToken", this->firebaseAuthToken},
-			{"firebaseEmail", this->firebaseEmail},
-			{"firebasePassword", this->firebasePassword},
-			{"firebaseAuthMethod", this->firebaseAuthMethod},
-			{"firebaseSendInterval", this->firebaseSendInterval},
-			{"firebaseDatabaseEnabled", this->firebaseDatabaseEnabled},
-		};
+		return "";
 	}
-	else if (command == "SaveSystemSettings")
+
+	if (vessel->sensors.empty())
 	{
-		this->saveSystemSettingsJson(data);
-		message = "Please restart device for changes to have effect!";
+		return "Vessel has no sensors";
 	}
-	else if (command == "TestFirebase")
+
+	uint totalWattage = 0;
+	for (auto &heater : this->heaters)
 	{
-		if (this->firebaseUrl.empty())
-		{
-			message = "Firebase configuration incomplete";
-			success = false;
-		}
-		else
+		if (heater->vessel == vessel->id)
 		{
-			// Test connection with a dummy data point
-			esp_err_t result = this->writeTemperatureToFirebase(25.0, 25.0, 50, "test");
-			if (result == ESP_OK) {
-				message = "Firebase connection test successful";
-			} else {
-				message = "Firebase connection test failed - check logs for details";
-				success = false;
-			}
+			heater->enabled = true;
+			totalWattage += heater->watt;
 		}
 	}
-	else if (command == "Reboot")
-	{
-		xTaskCreate(&this->reboot, "reboot_task", 1024, this, 5, NULL);
-	}
-	else if (command == "FactoryReset")
+
+	if (totalWattage == 0)
 	{
-		this->settingsManager->FactoryReset();
-		message = "Device will restart shortly, reconnect to factory wifi settings to continue!";
-		xTaskCreate(&this->reboot, "reboot_task", 1024, this, 5, NULL);
+		return "Vessel has no heaters";
 	}
-	else if (command == "BootIntoRecovery")
-	{
-		message = this->bootIntoRecovery();
 
-		if (message.find("Error") != std::string::npos)
+	vessel->totalWattage = totalWattage;
+	vessel->output = 0;
+	vessel->grantedOutput = 0;
+	vessel->pid.emplace(vessel->kP, vessel->kI, vessel->kD);
+	vessel->pid->setMin(0);
+	vessel->pid->setMax(100);
+	vessel->pid->setTimeBase(this->pidLoopTime);
+	vessel->pid->setDerivativeFilter(this->pidLoopTime / 10.0);
+	vessel->running = true;
+
+	ESP_LOGI(TAG, "Vessel %s started, target %.1f", vessel->name.c_str(), target);
+
+	this->startOutputTimer();
+
+	if (!this->vesselLoopRunning)
+	{
+		this->vesselLoopRunning = true;
+		xTaskCreate(&this->vesselLoop, "vesselloop_task", 4096, this, 5, NULL);
+	}
+
+	return "";
+}
+
+string BrewEngine::stopVessel(const json &config)
+{
+	if (config["id"].is_null() || !config["id"].is_number_integer())
+	{
+		return "Incorrect data, id expected!";
+	}
+
+	uint8_t id = (uint8_t)config["id"];
+	for (auto const &vessel : this->vessels)
+	{
+		if (vessel->id == id)
+		{
+			vessel->running = false;
+			vessel->output = 0;
+			vessel->grantedOutput = 0;
+			this->releaseHeaters(id);
+
+			ESP_LOGI(TAG, "Vessel %s stopped", vessel->name.c_str());
+			return "";
+		}
+	}
+
+	return "Unknown vessel";
+}
+
+// One pid per running vessel, they average their own sensors and hand their output to the shared power budget
+void BrewEngine::vesselLoop(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	int64_t lastRun = esp_timer_get_time();
+
+	while (instance->run && instance->vesselsRunning())
+	{
+		vTaskDelay(pdMS_TO_TICKS(PID_SAMPLE_TIME_MS));
+
+		int64_t now = esp_timer_get_time();
+		double dt = (double)(now - lastRun) / 1000000;
+		lastRun = now;
+
+		for (auto const &vessel : instance->vessels)
+		{
+			if (!vessel->running)
+			{
+				continue;
+			}
+
+			float sum = 0.0;
+			float weightSum = 0.0;
+			for (size_t slot = 0; slot < instance->samples.size(); slot++)
+			{
+				TemperatureSample sample;
+				if (instance->samples.read(slot, sample) && sample.vessel == vessel->id && sample.valid && (now - sample.timestamp) < SAMPLE_MAX_AGE_US)
+				{
+					sum += sample.temperature * sample.weight;
+					weightSum += sample.weight;
+				}
+			}
+
+			// without a temperature we don't heat
+			int output = 0;
+			if (weightSum > 0)
+			{
+				vessel->temperature = sum / weightSum;
+				output = (int)vessel->pid->getOutput((double)vessel->temperature, (double)vessel->targetTemperature, dt);
+			}
+			else
+			{
+				vessel->temperature = NAN;
+			}
+
+			if (!vessel->running)
+			{
+				continue; // stopped while we calculated, the heaters are already released
+			}
+
+			vessel->output = output;
+			vessel->grantedOutput = instance->setHeaterOutput(output, vessel->totalWattage, vessel->id);
+
+			// other heaters had preference, the pid continues from what the vessel got so its integral doesn't wind up
+			if (weightSum > 0 && vessel->grantedOutput < output)
+			{
+				vessel->pid->setOutput(vessel->grantedOutput, (double)vessel->temperature, (double)vessel->targetTemperature);
+			}
+		}
+	}
+
+	instance->vesselLoopRunning = false;
+
+	vTaskDelete(NULL);
+}
+
+void BrewEngine::startOutputTimer()
+{
+	// another vessel already runs the outputs, we join its window
+	if (this->outputTimer != nullptr && esp_timer_is_active(this->outputTimer))
+	{
+		return;
+	}
+
+	this->lastOutputTickAt = 0;
+
+	for (auto const &heater : this->heaters)
+	{
+		heater->burn = false;
+		heater->burstAccumulator = 0;
+		gpio_set_level(heater->pinNr, this->gpioLow);
+	}
+
+	if (this->outputTimer == nullptr)
+	{
+		esp_timer_create_args_t timerArgs = {};
+		timerArgs.callback = &this->outputTimerCallback;
+		timerArgs.arg = this;
+		timerArgs.dispatch_method = ESP_TIMER_TASK;
+		timerArgs.name = "output_timer";
+		timerArgs.skip_unhandled_events = true;
+
+		esp_err_t err = esp_timer_create(&timerArgs, &this->outputTimer);
+		if (err != ESP_OK)
+		{
+			ESP_LOGE(TAG, "Failed to create output timer: %s", esp_err_to_name(err));
+			this->outputTimer = nullptr;
+			return;
+		}
+	}
+
+	uint64_t period = OUTPUT_TICK_US;
+	if (this->outputMode == BurstFire)
+	{
+		// one tick per full mains cycle, the zero-cross SSR does the actual alignment
+		period = 1000000 / this->mainsFrequency;
+	}
+
+	this->outputTick = 0;
+	this->outputPeriodUs = (int64_t)period;
+	esp_timer_stop(this->outputTimer); // in case it is still running
+	esp_timer_start_periodic(this->outputTimer, period);
+
+	ESP_LOGI(TAG, "Output timer started, mode: %d, period: %lluus", this->outputMode, period);
+}
+
+void BrewEngine::stopOutputTimer()
+{
+	if (this->outputTimer != nullptr)
+	{
+		esp_timer_stop(this->outputTimer);
+	}
+
+	// set outputs off
+	for (auto const &heater : this->heaters)
+	{
+		heater->burn = false;
+		gpio_set_level(heater->pinNr, this->gpioLow);
+	}
+}
+
+void BrewEngine::outputTimerCallback(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	if (!instance->run)
+	{
+		return;
+	}
+
+	int64_t startedAt = esp_timer_get_time();
+	if (instance->lastOutputTickAt != 0)
+	{
+		instance->perf.record(PerfOutputLate, llabs(startedAt - instance->lastOutputTickAt - instance->outputPeriodUs));
+	}
+	instance->lastOutputTickAt = startedAt;
+
+	// with a power limit burst fire also follows the budget layout, over a window of POWER_SLOTS mains cycles
+	bool spread = instance->outputMode == BurstFire && instance->maxPower == 0;
+	uint32_t windowTicks = (instance->outputMode == BurstFire) ? POWER_SLOTS : (uint32_t)instance->pidLoopTime * (1000000 / OUTPUT_TICK_US);
+	uint32_t tick = instance->outputTick;
+	uint32_t burningWatt = 0;
+
+	for (auto const &heater : instance->heaters)
+	{
+		bool burn = false;
+
+		// the main kettle heaters only follow a running program
+		bool active = heater->vessel != 0 || instance->controlRun;
+
+		// burn time and phase are written together by the power budget
+		portENTER_CRITICAL(&instance->powerLock);
+		uint8_t burnTime = heater->burnTime;
+		uint8_t phaseOffset = heater->phaseOffset;
+
+		if (active && heater->enabled && burnTime > 0)
+		{
+			if (spread)
+			{
+				// spread the on cycles evenly, 50% gives on-off-on-off, the accumulator starts at the phase of the heater
+				heater->burstAccumulator += burnTime;
+				if (heater->burstAccumulator >= 100)
+				{
+					heater->burstAccumulator -= 100;
+					burn = true;
+				}
+			}
+			else
+			{
+				// the on window starts at the phase of the heater and wraps around the end of the window
+				burn = PowerBudget::burns(tick, windowTicks, phaseOffset, burnTime);
+			}
+		}
+		portEXIT_CRITICAL(&instance->powerLock);
+
+		// never more than maxPower at once, heaters are in preference order so the preferred ones win
+		if (burn && instance->maxPower > 0 && burningWatt + heater->watt > instance->maxPower)
+		{
+			burn = false;
+		}
+
+		if (burn)
+		{
+			burningWatt += heater->watt;
+		}
+
+		// only touch the gpio on a change, a simulation never switches the real heaters
+		if (burn != heater->burn)
+		{
+			heater->burn = burn;
+			if (!instance->simulation)
+			{
+				gpio_set_level(heater->pinNr, burn ? instance->gpioHigh : instance->gpioLow);
+			}
+		}
+	}
+
+	if (burningWatt > instance->peakPower)
+	{
+		instance->peakPower = burningWatt;
+	}
+
+	if (!spread && windowTicks > 0)
+	{
+		instance->outputTick = (tick + 1) % windowTicks;
+	}
+
+	instance->perf.record(PerfOutputUpdate, esp_timer_get_time() - startedAt);
+}
+
+// Relay (Astrom-Hagglund) experiment, the heaters toggle around the target and the resulting oscillation gives us the gains
+string BrewEngine::startAutoTune(const json &config)
+{
+	if (this->controlRun)
+	{
+		return "Stop the running program before starting AutoTune";
+	}
+
+	if (config["targetTemp"].is_null() || !config["targetTemp"].is_number())
+	{
+		return "Incorrect data, targetTemp expected!";
+	}
+
+	this->autoTuneTarget = (float)config["targetTemp"];
+
+	// by default we tune the set that matches the temperature
+	if (!config["boil"].is_null() && config["boil"].is_boolean())
+	{
+		this->boilRun = config["boil"];
+	}
+	else
+	{
+		this->boilRun = (this->temperatureScale == Celsius && this->autoTuneTarget >= 100) || (this->temperatureScale == Fahrenheit && this->autoTuneTarget >= 212);
+	}
+
+	this->autoTuneHysteresis = this->tempMargin;
+	if (!config["hysteresis"].is_null() && config["hysteresis"].is_number() && (float)config["hysteresis"] > 0)
+	{
+		this->autoTuneHysteresis = (float)config["hysteresis"];
+	}
+
+	this->autoTuneOutput = 100;
+	if (!config["output"].is_null() && config["output"].is_number_integer() && config["output"] > 0 && config["output"] <= 100)
+	{
+		this->autoTuneOutput = (uint8_t)config["output"];
+	}
+
+	this->autoTuneCycles = 3;
+	if (!config["cycles"].is_null() && config["cycles"].is_number_integer() && config["cycles"] >= 2 && config["cycles"] <= 10)
+	{
+		this->autoTuneCycles = (uint8_t)config["cycles"];
+	}
+
+	// Tyreus-Luyben is less aggressive and gives less overshoot, better fit for a kettle
+	this->autoTuneRule = "TL";
+	if (!config["rule"].is_null() && config["rule"].is_string() && config["rule"] == "ZN")
+	{
+		this->autoTuneRule = "ZN";
+	}
+
+	if (!this->simulation)
+	{
+		this->clearCheckpoint();
+	}
+
+	this->controlRun = true;
+	this->autoTuneRun = true;
+	this->boostStatus = Off;
+	this->targetTemperature = this->autoTuneTarget;
+	this->statusText = "AutoTune: Heating";
+
+	xTaskCreate(&this->autoTuneLoop, "autotune_task", 4096, this, 5, NULL);
+
+	this->startOutputTimer();
+
+	return "";
+}
+
+void BrewEngine::autoTuneLoop(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	uint totalWattage = instance->enableHeaters();
+
+	float target = instance->autoTuneTarget;
+	float hysteresis = instance->autoTuneHysteresis;
+	bool relayOn = true;
+	int switches = 0;
+
+	float peakHigh = -999;
+	float peakLow = 999;
+	float amplitudeSum = 0;
+	double periodSum = 0;
+	int measuredCycles = 0;
+	int64_t lastCycleStart = 0;
+
+	int64_t start = esp_timer_get_time();
+	string result;
+
+	while (instance->run && instance->controlRun)
+	{
+		float temperature = instance->temperature;
+
+		if (isnan(temperature) || !instance->temperatureValid)
+		{
+			result = "AutoTune aborted: no temperature";
+			break;
+		}
+
+		// safety, we never get here in a normal relay test
+		if (temperature > target + 10 || (esp_timer_get_time() - start) > (int64_t)AUTOTUNE_MAX_TIME_S * 1000000)
+		{
+			result = "AutoTune aborted: not oscillating";
+			break;
+		}
+
+		peakHigh = std::max(peakHigh, temperature);
+		peakLow = std::min(peakLow, temperature);
+
+		if (relayOn && temperature > target + hysteresis)
+		{
+			relayOn = false;
+			switches++;
+		}
+		else if (!relayOn && temperature < target - hysteresis)
+		{
+			relayOn = true;
+			switches++;
+
+			// a full cycle ends at every switch on, the first one is still the heat up and is skipped
+			int64_t now = esp_timer_get_time();
+			if (switches >= 4)
+			{
+				periodSum += (double)(now - lastCycleStart) / 1000000;
+				amplitudeSum += (peakHigh - peakLow) / 2;
+				measuredCycles++;
+			}
+			lastCycleStart = now;
+			peakHigh = temperature;
+			peakLow = temperature;
+
+			instance->statusText = "AutoTune: Cycle " + to_string(measuredCycles) + "/" + to_string(instance->autoTuneCycles);
+			ESP_LOGI(TAG, "%s", instance->statusText.c_str());
+			instance->logRemote(instance->statusText);
+
+			if (measuredCycles >= instance->autoTuneCycles)
+			{
+				break;
+			}
+		}
+
+		uint8_t output = relayOn ? instance->autoTuneOutput : 0;
+		instance->pidOutput = output;
+		instance->setHeaterOutput(output, totalWattage);
+
+		vTaskDelay(pdMS_TO_TICKS(1000));
+	}
+
+	// the run ends before the heaters are released, so the output timer stops with them when no vessel runs
+	bool boil = instance->boilRun;
+	instance->autoTuneRun = false;
+	instance->controlRun = false;
+	instance->releaseHeaters(0);
+	instance->pidOutput = 0;
+
+	if (measuredCycles >= instance->autoTuneCycles && measuredCycles > 0)
+	{
+		double amplitude = amplitudeSum / measuredCycles;
+		double period = periodSum / measuredCycles;
+
+		// relay swings from 0 to output, so d is half of it
+		double d = (double)instance->autoTuneOutput / 2;
+		double ku = (4 * d) / (M_PI * std::max(amplitude, 0.01));
+
+		double kp, ti, td;
+		if (instance->autoTuneRule == "ZN")
+		{
+			kp = 0.6 * ku;
+			ti = period / 2;
+			td = period / 8;
+		}
+		else
+		{
+			kp = ku / 2.2;
+			ti = 2.2 * period;
+			td = period / 6.3;
+		}
+
+		// our pid works per pidLoopTime: i = ki * sum(e) / 2 and d = kd * delta(e)
+		double loopTime = instance->pidLoopTime;
+		double ki = 2 * kp * loopTime / ti;
+		double kd = kp * td / loopTime;
+
+		// gains are stored with 1 decimal and the pid doesn't allow 0
+		kp = std::clamp(kp, 0.1, 6553.0);
+		ki = std::clamp(ki, 0.1, 6553.0);
+		kd = std::clamp(kd, 0.1, 6553.0);
+
+		if (boil)
+		{
+			instance->boilkP = kp;
+			instance->boilkI = ki;
+			instance->boilkD = kd;
+		}
+		else
+		{
+			instance->mashkP = kp;
+			instance->mashkI = ki;
+			instance->mashkD = kd;
+		}
+		instance->savePIDSettings();
+
+		char buffer[96];
+		snprintf(buffer, sizeof(buffer), "AutoTune done (Ku %.1f Pu %.0fs): kP %.1f kI %.1f kD %.1f", ku, period, kp, ki, kd);
+		result = buffer;
+
+		// let the user know, same as a schedule notification
+		instance->buzz();
+	}
+	else if (result.empty())
+	{
+		result = "AutoTune stopped";
+	}
+
+	ESP_LOGI(TAG, "%s", result.c_str());
+	instance->logRemote(result);
+
+	instance->statusText = result;
+
+	vTaskDelete(NULL);
+}
+
+// One task for everything that happens at a point in time: schedule steps, notifications, stir edges and the buzzer.
+// It sleeps until the nearest deadline, commands that change one of them wake it with a task notification.
+void BrewEngine::schedulerLoop(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	while (instance->run)
+	{
+		uint32_t waitMs = SCHEDULER_MAX_WAIT_MS;
+		waitMs = std::min(waitMs, instance->runControl());
+		waitMs = std::min(waitMs, instance->runStir());
+		waitMs = std::min(waitMs, instance->runBuzzer());
+
+		// a notification (command) wakes us early, the deadlines are recalculated anyway
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs) + 1);
+	}
+
+	vTaskDelete(NULL);
+}
+
+void BrewEngine::wakeScheduler()
+{
+	if (this->schedulerHandle != NULL)
+	{
+		xTaskNotifyGive(this->schedulerHandle);
+	}
+}
+
+// rounded up, so we never wake just before a deadline
+static uint32_t msUntil(system_clock::time_point deadline, system_clock::time_point now)
+{
+	if (deadline <= now)
+	{
+		return 0;
+	}
+
+	auto us = chrono::duration_cast<chrono::microseconds>(deadline - now).count();
+	return (uint32_t)std::min<int64_t>((us + 999) / 1000, SCHEDULER_MAX_WAIT_MS);
+}
+
+// Runs the schedule, returns the ms until it needs to run again
+uint32_t BrewEngine::runControl()
+{
+	if (!this->scheduleRun)
+	{
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	if (!this->controlRun)
+	{
+		this->scheduleRun = false;
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	system_clock::time_point now = std::chrono::system_clock::now();
+
+	if (this->executionSteps.size() <= this->currentMashStep)
+	{
+		// last step need to stop
+		ESP_LOGI(TAG, "Program Finished");
+		this->stop();
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	// temperature driven states (boost, overtime, the delayed pid reset) are checked every second, like before
+	uint32_t waitMs = SCHEDULER_MAX_WAIT_MS;
+
+	int nextStepIndex = this->currentMashStep;
+
+	const ExecutionStep *nextStep = &this->executionSteps[nextStepIndex];
+
+	system_clock::time_point nextAction = nextStep->time;
+
+	bool gotoNextStep = false;
+
+	// set target when not overriden
+	if (this->overrideTargetTemperature.has_value())
+	{
+		this->targetTemperature = this->overrideTargetTemperature.value();
+	}
+	else
+	{
+		this->targetTemperature = nextStep->temperature;
+	}
+
+	// slope of the ramp we are in, used for feed-forward, we are behind in overtime so there is no ramp to follow
+	this->targetSlope = 0;
+	if (!this->overrideTargetTemperature.has_value() && !this->inOverTime && nextStepIndex > 0)
+	{
+		const ExecutionStep *prevStep = &this->executionSteps[nextStepIndex - 1];
+		auto stepSeconds = chrono::duration_cast<chrono::seconds>(nextStep->time - prevStep->time).count();
+		if (stepSeconds > 0)
+		{
+			this->targetSlope = (nextStep->temperature - prevStep->temperature) / (float)stepSeconds;
+		}
+	}
+
+	uint secondsToGo = 0;
+	// if its smaller 0 is ok!
+	if (nextAction > now)
+	{
+		secondsToGo = chrono::duration_cast<chrono::seconds>(nextAction - now).count();
+	}
+
+	// Boost mode logic
+	if (nextStep->allowBoost)
+	{
+		waitMs = CONTROL_POLL_MS;
+
+		if (this->boostUntil == 0)
+		{
+			this->boostUntil = (uint)((nextStep->temperature / 100) * (float)this->boostModeUntil);
+		}
+
+		if (this->boostStatus == Off && this->temperature < this->boostUntil)
+		{
+
+			ESP_LOGI(TAG, "Boost Start Until: %d", this->boostUntil);
+			this->logRemote("Boost Start");
+			this->boostStatus = Boost;
+		}
+		else if (this->boostStatus == Boost && this->temperature >= this->boostUntil)
+		{
+			// When in boost mode we wait unit boost temp is reched, pid is locked to 100% in boost mode
+			ESP_LOGI(TAG, "Boost Rest Start");
+			this->logRemote("Boost Rest Start");
+			this->boostStatus = Rest;
+		}
+		else if (this->boostStatus == Rest && this->temperature < this->boostPrevTemperature)
+		{
+			// When in boost rest mode, we wait until temperature drops pid is locked to 0%
+			ESP_LOGI(TAG, "Boost Rest End");
+			this->logRemote("Boost Rest End");
+			this->boostStatus = Off;
+
+			// Reset pid
+			this->resetPitTime = true;
+		}
+	}
+
+	if (secondsToGo < 1)
+	{ // change temp and increment Currentstep
+
+		if (nextStep->extendIfNeeded == true && this->inOverTime == false && (nextStep->temperature - this->temperature) >= this->tempMargin)
+		{
+			// temp must be reached, we keep going but need to triger a recaluclation event when done
+			ESP_LOGI(TAG, "OverTime Start");
+			this->logRemote("OverTime Start");
+			this->inOverTime = true;
+			this->saveCheckpoint();
+		}
+		else if (this->inOverTime == true && (nextStep->temperature - this->temperature) <= this->tempMargin)
+		{
+			// we reached out temp after overtime, we need to recalc the rest and start going again
+			ESP_LOGI(TAG, "OverTime Done");
+			this->logRemote("OverTime Done");
+			this->inOverTime = false;
+			this->recalculateScheduleAfterOverTime();
+			gotoNextStep = true;
+		}
+		else if (this->inOverTime == false)
+		{
+			ESP_LOGI(TAG, "Going to next Step");
+			gotoNextStep = true;
+			// also reset override on step change
+			this->overrideTargetTemperature = std::nullopt;
+		}
+
+		// else when in overtime just keep going until we reach temp
+	}
+
+	// the pid needs to reset one step later so the next temp is set, oherwise it has a delay
+	if (this->resetPidNextStep)
+	{
+		this->resetPidNextStep = false;
+		this->resetPitTime = true;
+	}
+
+	if (gotoNextStep)
+	{
+		this->currentMashStep++;
+
+		// Also reset boost
+		this->boostStatus = Off;
+
+		this->resetPidNextStep = true;
+
+		this->saveCheckpoint();
+
+		// the next step sets its target right away
+		waitMs = 0;
+	}
+	else if (this->inOverTime)
+	{
+		waitMs = CONTROL_POLL_MS;
+	}
+	else
+	{
+		waitMs = std::min(waitMs, msUntil(nextAction, now));
+	}
+
+	if (this->resetPidNextStep)
+	{
+		waitMs = std::min(waitMs, (uint32_t)CONTROL_POLL_MS);
+	}
+
+	// notifications, but only when not in overtime
+	if (!this->inOverTime && !this->notifications.empty())
+	{
+		// filter out items that are not done
+		auto isNotDone = [](Notification *notification)
+		{ return notification->done == false; };
+
+		auto notDone = this->notifications | views::filter(isNotDone);
+
+		if (!notDone.empty())
+		{
+			// they are sorted so we just have to check the first one
+			auto first = notDone.front();
+
+			if (now >= first->timePoint)
+			{
+				ESP_LOGI(TAG, "Notify %s", first->name.c_str());
+
+				this->buzz();
+
+				first->done = true;
+
+				// the next one can be due at the same time
+				waitMs = 0;
+			}
+			else
+			{
+				waitMs = std::min(waitMs, msUntil(first->timePoint, now));
+			}
+		}
+	}
+
+	// For boost mode to see if temp starts to drop
+	this->boostPrevTemperature = this->temperature;
+
+	return waitMs;
+}
+
+// Switches the stir pin on the interval edges, returns the ms until the next edge
+uint32_t BrewEngine::runStir()
+{
+	if (!this->stirRun)
+	{
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	if (this->stirIntervalStart == 0 && this->stirIntervalStop == this->stirTimeSpan)
+	{
+		// always on, just set high and wait for end
+		gpio_set_level(this->stir_PIN, this->gpioHigh);
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	system_clock::time_point now = std::chrono::system_clock::now();
+
+	auto cycleEnd = this->stirStartCycle + minutes(this->stirTimeSpan);
+
+	// start next cycle
+	while (now >= cycleEnd && this->stirTimeSpan > 0)
+	{
+		this->stirStartCycle = cycleEnd;
+		cycleEnd = this->stirStartCycle + minutes(this->stirTimeSpan);
+	}
+
+	auto startStirTime = this->stirStartCycle + minutes(this->stirIntervalStart);
+	auto stopStirTime = this->stirStartCycle + minutes(this->stirIntervalStop);
+
+	if (now >= startStirTime && now < stopStirTime)
+	{
+		gpio_set_level(this->stir_PIN, this->gpioHigh);
+		return msUntil(stopStirTime, now);
+	}
+
+	gpio_set_level(this->stir_PIN, this->gpioLow);
+
+	if (now < startStirTime)
+	{
+		return msUntil(startStirTime, now);
+	}
+
+	// without a timespan there is no next cycle
+	return this->stirTimeSpan > 0 ? msUntil(cycleEnd, now) : SCHEDULER_MAX_WAIT_MS;
+}
+
+// Sounds the buzzer for buzzerTime, a new request while it sounds extends it
+void BrewEngine::buzz()
+{
+	this->buzzerRequested = true;
+	this->wakeScheduler();
+}
+
+uint32_t BrewEngine::runBuzzer()
+{
+	if (this->buzzer_PIN <= 0)
+	{
+		this->buzzerRequested = false;
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	int64_t now = esp_timer_get_time();
+
+	if (this->buzzerRequested)
+	{
+		this->buzzerRequested = false;
+		this->buzzerOffAt = now + (int64_t)this->buzzerTime * 1000000;
+		gpio_set_level(this->buzzer_PIN, this->gpioHigh);
+	}
+
+	if (this->buzzerOffAt == 0)
+	{
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	if (now >= this->buzzerOffAt)
+	{
+		this->buzzerOffAt = 0;
+		gpio_set_level(this->buzzer_PIN, this->gpioLow);
+		return SCHEDULER_MAX_WAIT_MS;
+	}
+
+	return (uint32_t)((this->buzzerOffAt - now + 999) / 1000);
+}
+
+string BrewEngine::bootIntoRecovery()
+{
+	// recovery is our factory
+	esp_partition_subtype_t t = ESP_PARTITION_SUBTYPE_APP_FACTORY;
+	const esp_partition_t *factory_partition = esp_partition_find_first(ESP_PARTITION_TYPE_APP, t, NULL);
+
+	if (factory_partition == NULL)
+	{
+		ESP_LOGE(TAG, "Factory Partition not found!");
+		return "Error: Factory Partition not found!";
+	}
+
+	if (esp_ota_set_boot_partition(factory_partition) == ESP_OK)
+	{
+		return "Device is booting into recovery hold on!";
+	}
+
+	return "Error: Unable to chage boot Partition!";
+}
+
+void BrewEngine::reboot(void *arg)
+{
+	vTaskDelay(2000 / portTICK_PERIOD_MS);
+	esp_restart();
+}
+
+// Data for the control page, tempLog can be left out when the caller streams it
+json BrewEngine::getData(const json &data, bool withTempLog)
+{
+	time_t lastLogDateTime = time(0);
+
+	size_t logSize = this->tempLog.size();
+	if (logSize > 0)
+	{
+		lastLogDateTime = this->tempLog.timeAt(logSize - 1);
+	}
+
+	json jTempLog = json::array({});
+	if (logSize > 0 && withTempLog)
+	{
+		// If we have a last date we only need to send the log increment
+		size_t first = 0;
+		if (data.is_object() && data.contains("lastDate") && data["lastDate"].is_number())
+		{
+			time_t lastClientDate = (time_t)data["lastDate"];
+			ESP_LOGD(TAG, "lastClientDate %s", ctime(&lastClientDate));
+
+			first = this->tempLog.findAfter(lastClientDate);
+		}
+
+		time_t logTime;
+		float logTemperature;
+		for (size_t i = first; i < logSize && this->tempLog.read(i, logTime, logTemperature); i++)
+		{
+			jTempLog.push_back({
+				{"time", logTime},
+				{"temp", (double)((int)(logTemperature * 10)) / 10},
+			});
+		}
+	}
+
+	// currenttemps is an array of current temps, they are not necessarily all used for control
+	json jCurrentTemps = json::array({});
+	for (size_t slot = 0; slot < this->samples.size(); slot++)
+	{
+		TemperatureSample sample;
+		if (!this->samples.read(slot, sample) || !sample.show)
+		{
+			continue;
+		}
+
+		json jCurrentTemp;
+		jCurrentTemp["sensor"] = to_string(sample.sensorId);				  // js doesn't support unint64
+		jCurrentTemp["temp"] = (double)((int)(sample.temperature * 10)) / 10; // round float to 1 digit for display
+		jCurrentTemps.push_back(jCurrentTemp);
+	}
+
+	json jVessels = json::array({});
+	for (auto const &vessel : this->vessels)
+	{
+		jVessels.push_back(vessel->status_json());
+	}
+
+	// Get system resource usage
+	uint32_t freeHeap = esp_get_free_heap_size();
+	uint32_t totalHeap = heap_caps_get_total_size(MALLOC_CAP_DEFAULT);
+	uint32_t usedHeap = totalHeap - freeHeap;
+	float memoryUsagePercent = ((float)usedHeap / (float)totalHeap) * 100.0f;
+	
+	// Simple CPU usage estimation based on system activity
+	// Uses memory allocation patterns and task switching as indicators
+	static uint32_t lastCpuCheck = 0;
+	static uint32_t lastFreeHeap = 0;
+	static uint32_t lastMinFreeHeap = 0;
+	static float cpuUsagePercent = 15.0f; // Start with baseline 15%
+	
+	uint32_t currentTime = esp_timer_get_time() / 1000; // Convert to milliseconds
+	
+	// Update CPU usage estimation every 2000ms
+	if (currentTime - lastCpuCheck >= 2000) {
+		uint32_t currentFreeHeap = esp_get_free_heap_size();
+		uint32_t currentMinFreeHeap = esp_get_minimum_free_heap_size();
+		
+		if (lastCpuCheck > 0) {
+			// Method 1: Heap activity indicates CPU usage
+			uint32_t heapActivity = 0;
+			if (currentFreeHeap != lastFreeHeap) {
+				heapActivity = abs((int32_t)(currentFreeHeap - lastFreeHeap));
+			}
+			
+			// Method 2: Minimum free heap changes indicate memory pressure
+			uint32_t memPressure = 0;
+			if (currentMinFreeHeap != lastMinFreeHeap) {
+				memPressure = abs((int32_t)(currentMinFreeHeap - lastMinFreeHeap));
+			}
+			
+			// Calculate CPU usage based on system activity
+			float activityFactor = (float)(heapActivity + memPressure * 2) / 1024.0f;
+			cpuUsagePercent = 15.0f + (activityFactor * 5.0f); // Base 15% + activity
+			
+			// Add some variation based on temperature sensor activity
+			if (jCurrentTemps.size() > 0) {
+				cpuUsagePercent += (float)jCurrentTemps.size() * 2.0f;
+			}
+			
+			// Add load based on PID controller activity
+			if (this->pidOutput > 0) {
+				cpuUsagePercent += (this->pidOutput / 100.0f) * 10.0f;
+			}
+			
+			// Clamp between realistic values
+			if (cpuUsagePercent < 5.0f) cpuUsagePercent = 5.0f;
+			if (cpuUsagePercent > 85.0f) cpuUsagePercent = 85.0f;
+		}
+		
+		lastCpuCheck = currentTime;
+		lastFreeHeap = currentFreeHeap;
+		lastMinFreeHeap = currentMinFreeHeap;
+	}
+
+	// sensorTempLogs removed - will fetch from database instead to save memory
+	json resultData = {
+		{"temp", (double)((int)(this->temperature * 10)) / 10}, // round float to 1 digit for display
+		{"temps", jCurrentTemps},
+		{"targetTemp", (double)((int)(this->targetTemperature * 10)) / 10}, // round float to 1 digit for display,
+		{"manualOverrideTargetTemp", nullptr},
+		{"output", this->pidOutput},
+		{"manualOverrideOutput", nullptr},
+		{"status", this->statusText},
+		{"stirStatus", this->stirStatusText},
+		{"lastLogDateTime", lastLogDateTime},
+		{"sensorTempLogs", json::array({})}, // Empty array - will fetch from database instead
+		{"runningVersion", this->runningVersion},
+		{"inOverTime", this->inOverTime},
+		{"boostStatus", this->boostStatus},
+		{"resumeAvailable", nullptr},
+		{"vessels", jVessels},
+		{"systemInfo", {
+			{"freeHeap", freeHeap},
+			{"totalHeap", totalHeap},
+			{"usedHeap", usedHeap},
+			{"memoryUsagePercent", (double)((int)(memoryUsagePercent * 10)) / 10},
+			{"cpuUsagePercent", (double)((int)(cpuUsagePercent * 10)) / 10}
+		}},
+	};
+
+	if (this->manualOverrideOutput.has_value())
+	{
+		resultData["manualOverrideOutput"] = this->manualOverrideOutput.value();
+	}
+
+	if (this->overrideTargetTemperature.has_value())
+	{
+		resultData["manualOverrideTargetTemp"] = this->overrideTargetTemperature.value();
+	}
+
+	if (!this->resumeCheckpoint.empty() && !this->controlRun)
+	{
+		resultData["resumeAvailable"] = {
+			{"schedule", this->resumeCheckpoint["schedule"]},
+			{"step", this->resumeCheckpoint["step"]},
+			{"savedAt", this->resumeCheckpoint["savedAt"]},
+		};
+	}
+
+	if (withTempLog)
+	{
+		resultData["tempLog"] = jTempLog;
+	}
+
+	return resultData;
+}
+
+// Timing histograms of the probe points, and per task stack and cpu usage when FreeRTOS keeps those stats
+json BrewEngine::getPerf()
+{
+	json jPerf = {
+		{"uptimeS", esp_timer_get_time() / 1000000},
+		{"bucketsUs", PerfStats::bucketBounds()},
+		{"probes", this->perf.to_json()},
+		{"power", {{"maxPower", this->maxPower}, {"peakW", this->peakPower}}},
+		{"freeHeap", esp_get_free_heap_size()},
+		{"minFreeHeap", esp_get_minimum_free_heap_size()},
+	};
+
+	if (this->simulation)
+	{
+		jPerf["simulation"] = this->simulator.to_json();
+	}
+
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY)
+	TaskStatus_t *tasks = new TaskStatus_t[PERF_MAX_TASKS];
+	uint32_t totalRunTime = 0;
+	UBaseType_t taskCount = uxTaskGetSystemState(tasks, PERF_MAX_TASKS, &totalRunTime);
+
+	json jTasks = json::array({});
+	for (UBaseType_t i = 0; i < taskCount; i++)
+	{
+		json jTask = {
+			{"name", tasks[i].pcTaskName},
+			{"priority", tasks[i].uxCurrentPriority},
+			{"stackFreeMin", tasks[i].usStackHighWaterMark}, // bytes on esp-idf
+		};
+
+#if defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+		if (totalRunTime > 0)
+		{
+			// share of one core since boot
+			jTask["cpuPercent"] = (double)((uint64_t)tasks[i].ulRunTimeCounter * 1000 / totalRunTime) / 10;
+		}
+#endif
+		jTasks.push_back(jTask);
+	}
+	delete[] tasks;
+
+	jPerf["tasks"] = jTasks;
+#endif
+
+	return jPerf;
+}
+
+// Replaces the control sensors with a simulated kettle that is heated by the output we calculate, the heater gpio's stay off.
+// Lets us compare pid and feed-forward settings on the real firmware, cpu cost per cycle shows in the perf probes.
+string BrewEngine::startSimulation(const json &config)
+{
+	if (this->controlRun)
+	{
+		return "Stop the running program before starting a simulation";
+	}
+
+	if (this->simulation || this->simulationTaskRunning)
+	{
+		return "Simulation is already running";
+	}
+
+	if (this->vesselsRunning())
+	{
+		return "Stop the vessels before starting a simulation";
+	}
+
+	// our own temperatures are in the selected scale, the simulator works in celsius
+	float startTemperature = this->temperature;
+	if (!config["startTemp"].is_null() && config["startTemp"].is_number())
+	{
+		startTemperature = (float)config["startTemp"];
+	}
+	else if (std::isnan(startTemperature))
+	{
+		startTemperature = (this->temperatureScale == Celsius) ? 20 : 68;
+	}
+	if (this->temperatureScale == Fahrenheit)
+	{
+		startTemperature = (startTemperature - 32) / 1.8;
+	}
+
+	this->simulator = KettleSimulator();
+	this->simulator.from_json(config);
+	if (this->simulator.volume <= 0)
+	{
+		return "Incorrect data, volume must be above 0";
+	}
+	this->simulator.settleMargin = (this->temperatureScale == Celsius) ? this->tempMargin : this->tempMargin / 1.8;
+	this->simulator.reset(startTemperature);
+
+	this->thermalModelBackup = this->thermalModel;
+
+	ESP_LOGI(TAG, "Simulation started: %.1fL, %.1fW/K", this->simulator.volume, this->simulator.lossPerK);
+
+	this->simulation = true;
+	this->simulationTaskRunning = true;
+	xTaskCreate(&this->simulationLoop, "simulation_task", 4096, this, 5, NULL);
+
+	return "";
+}
+
+string BrewEngine::stopSimulation()
+{
+	if (this->controlRun)
+	{
+		return "Stop the running program before stopping the simulation";
+	}
+
+	if (!this->simulation)
+	{
+		return "";
+	}
+
+	this->simulation = false;
+	this->thermalModel = this->thermalModelBackup;
+
+	ESP_LOGI(TAG, "Simulation stopped: %s", this->simulator.to_json().dump().c_str());
+
+	return "";
+}
+
+void BrewEngine::simulationLoop(void *arg)
+{
+	BrewEngine *instance = (BrewEngine *)arg;
+
+	const double dt = (double)SIM_STEP_MS / 1000;
+
+	while (instance->run && instance->simulation)
+	{
+		vTaskDelay(pdMS_TO_TICKS(SIM_STEP_MS));
+
+		// the average power of the output window, the timer spreads it the same way over the real heaters
+		double power = 0;
+		if (instance->controlRun)
+		{
+			for (auto const &heater : instance->heaters)
+			{
+				if (heater->enabled)
+				{
+					power += (double)heater->watt * heater->burnTime / 100;
+				}
+			}
+		}
+
+		instance->simulator.step(power, dt);
+
+		if (instance->controlRun)
+		{
+			double target = instance->targetTemperature;
+			if (instance->temperatureScale == Fahrenheit)
+			{
+				target = (target - 32) / 1.8;
+			}
+			instance->simulator.track(target, dt);
+		}
+
+		float temperature = instance->simulator.sensorTemperature;
+		if (instance->temperatureScale == Fahrenheit)
+		{
+			temperature = (temperature * 1.8) + 32;
+		}
+
+		TemperatureSample sample;
+		sample.sensorId = SIM_SENSOR_ID;
+		sample.temperature = temperature;
+		sample.timestamp = esp_timer_get_time();
+		sample.valid = true;
+		sample.show = true;
+		sample.useForControl = true;
+		sample.weight = 1;
+		sample.vessel = 0;
+
+		instance->samples.publish(SIM_SLOT, sample);
+	}
+
+	instance->clearSamples(SIM_SLOT, SIM_SLOT + 1);
+	instance->simulationTaskRunning = false;
+
+	vTaskDelete(NULL);
+}
+
+string BrewEngine::processCommand(const string &command, json data)
+{
+	return this->processCommand(lookupApiCommand(command), std::move(data));
+}
+
+string BrewEngine::processCommand(ApiCommand command, json data)
+{
+	ESP_LOGD(TAG, "processCommand %d", command);
+	ESP_LOGD(TAG, "data %s", data.dump().c_str());
+
+	json resultData = {};
+	string message = "";
+	bool success = true;
+
+	switch (command)
+	{
+		case CommandData:
+		{
+			resultData = this->getData(data, true);
+			break;
+		}
+		case CommandGetRunningSchedule:
+		{
+			json jRunningSchedule;
+			jRunningSchedule["version"] = this->runningVersion;
+
+			// clients that know an earlier version only get the edits since then
+			vector<ScheduleEdit> edits;
+			if (data.is_object() && data["sinceVersion"].is_number() && this->scheduleEdits.since((uint16_t)data["sinceVersion"], edits))
+			{
+				json jEdits = json::array({});
+				for (auto const &edit : edits)
+				{
+					jEdits.push_back({{"version", edit.version}, {"fromStep", edit.fromStep}, {"shift", edit.shift}});
+				}
+				jRunningSchedule["edits"] = jEdits;
+			}
+			else
+			{
+				json jExecutionSteps = json::array({});
+				for (auto const &step : this->executionSteps)
+				{
+					jExecutionSteps.push_back(step.to_json());
+				}
+				jRunningSchedule["steps"] = jExecutionSteps;
+
+				json jNotifications = json::array({});
+				for (auto &notification : this->notifications)
+				{
+					json jNotification = notification->to_json();
+					jNotifications.push_back(jNotification);
+				}
+				jRunningSchedule["notifications"] = jNotifications;
+			}
+
+			resultData = jRunningSchedule;
+			break;
+		}
+		case CommandGetPerf:
+		{
+			resultData = this->getPerf();
+
+			if (data.is_object() && data.value("reset", false))
+			{
+				this->perf.reset();
+				this->peakPower = 0;
+			}
+			break;
+		}
+		case CommandSetTemp:
+		{
+
+			if (data["targetTemp"].is_null())
+			{
+				this->overrideTargetTemperature = std::nullopt;
+
+				// when not in a program also direclty set targtetemp
+				if (this->selectedMashScheduleName.empty() == true)
+				{
+					this->targetTemperature = 0;
+				}
+			}
+			else if (data["targetTemp"].is_number())
+			{
+
+				this->overrideTargetTemperature = (float)data["targetTemp"];
+
+				// when not in a program also direclty set targtetemp
+				if (this->selectedMashScheduleName.empty() == true)
+				{
+					this->targetTemperature = this->overrideTargetTemperature.value();
+				}
+			}
+			else
+			{
+				this->overrideTargetTemperature = std::nullopt;
+
+				message = "Incorrect data, integer or float expected!";
+				success = false;
+			}
+
+			if (success && this->controlRun)
+			{
+				this->saveCheckpoint();
+
+				// the schedule applies the override
+				this->wakeScheduler();
+			}
+			break;
+		}
+		case CommandSetOverrideOutput:
+		{
+
+			if (data["output"].is_null() == false && data["output"].is_number())
+			{
+				this->manualOverrideOutput = (int)data["output"];
+			}
+			else
+			{
+				this->manualOverrideOutput = std::nullopt;
+			}
+
+			// reset so effect is immidiate
+			this->resetPitTime = true;
+			break;
+		}
+		case CommandStart:
+		{
+			if (data["selectedMashSchedule"].is_null())
+			{
+				this->selectedMashScheduleName.clear();
+			}
+			else
+			{
+				this->selectedMashScheduleName = (string)data["selectedMashSchedule"];
+			}
+
+			this->start();
+
+			// a simulated run is not a brew, it stays out of the statistics
+			if (!this->simulation)
+			{
+				this->statisticsManager->StartSession(this->selectedMashScheduleName);
+			}
+			this->saveCheckpoint();
+		
+			// Log session start to Firebase
+			if (this->firebaseEnabled)
+			{
+				// Session metadata is now tracked by local statistics manager
+				ESP_LOGI(TAG, "Session started - metadata logged locally and to Firebase via temperature writes");
+			}
+			break;
+		}
+		case CommandResume:
+		{
+			if (this->resumeCheckpoint.empty() || this->controlRun)
+			{
+				message = "Nothing to resume";
+				success = false;
+			}
+			else if (this->simulation)
+			{
+				message = "Stop the simulation before resuming";
+				success = false;
+			}
+			else
+			{
+				uint32_t sessionId = this->resumeCheckpoint.value("sessionId", (uint32_t)0);
+
+				// the statistics session only continues with the schedule, a checkpoint that was too old starts over in a new one
+				bool resumed = this->start(true);
+
+				if (!resumed || !this->statisticsManager->ResumeSession(sessionId))
+				{
+					this->statisticsManager->StartSession(this->selectedMashScheduleName);
+				}
+				this->saveCheckpoint();
+			}
+			break;
+		}
+		case CommandDiscardResume:
+		{
+			this->clearCheckpoint();
+			break;
+		}
+		case CommandStartSimulation:
+		{
+			message = this->startSimulation(data);
+			success = message.empty();
+			break;
+		}
+		case CommandStopSimulation:
+		{
+			message = this->stopSimulation();
+			success = message.empty();
+			break;
+		}
+		case CommandAutoTune:
+		{
+			message = this->startAutoTune(data);
+			success = message.empty();
+			break;
+		}
+		case CommandStartStir:
+		{
+			this->startStir(data);
+			break;
+		}
+		case CommandStop:
+		{
+			this->stop();
+
+			// the schedule ends now, not at the next timeout of the scheduler
+			this->wakeScheduler();
+			if (!this->simulation)
+			{
+				this->statisticsManager->EndSession();
+			}
+		
+			// Log session end to Firebase
+			if (this->firebaseEnabled)
+			{
+				// Session metadata is now tracked by local statistics manager
+				ESP_LOGI(TAG, "Session ended - metadata logged locally");
+			}
+			break;
+		}
+		case CommandStopStir:
+		{
+			this->stopStir();
+			break;
+		}
+		case CommandGetMashSchedules:
+		{
+
+			json jSchedules = json::array({});
+
+			for (auto const &[key, val] : this->mashSchedules)
+			{
+				json jSchedule = val->to_json();
+				jSchedules.push_back(jSchedule);
+			}
+
+			resultData = jSchedules;
+			break;
+		}
+		case CommandSaveMashSchedule:
+		{
+			message = this->setMashSchedule(data);
+
+			if (message.empty())
+			{
+				this->saveMashSchedules();
+			}
+			else
+			{
+				success = false;
+			}
+			break;
+		}
+		case CommandSetMashSchedule: // used by import function to set but not save
+		{
+			message = this->setMashSchedule(data);
+			success = message.empty();
+			break;
+		}
+		case CommandDeleteMashSchedule:
+		{
+			string deleteName = (string)data["name"];
+
+			auto pos = this->mashSchedules.find(deleteName);
+
+			if (pos == this->mashSchedules.end())
+			{
+				message = "Schedule with name: " + deleteName + " not found";
+				success = false;
+			}
+			else
+			{
+				MashSchedule *schedule = pos->second;
+				this->mashSchedules.erase(pos);
+				this->releaseMashSchedule(schedule);
+				this->saveMashSchedules();
+			}
+			break;
+		}
+		case CommandGetPIDSettings:
+		{
+			resultData = {
+				{"kP", this->mashkP},
+				{"kI", this->mashkI},
+				{"kD", this->mashkD},
+				{"boilkP", this->boilkP},
+				{"boilkI", this->boilkI},
+				{"boilkD", this->boilkD},
+				{"pidLoopTime", this->pidLoopTime},
+				{"stepInterval", this->stepInterval},
+				{"boostModeUntil", this->boostModeUntil},
+			};
+			break;
+		}
+		case CommandSavePIDSettings:
+		{
+			this->mashkP = data["kP"].get<double>();
+			this->mashkI = data["kI"].get<double>();
+			this->mashkD = data["kD"].get<double>();
+			this->boilkP = data["boilkP"].get<double>();
+			this->boilkI = data["boilkI"].get<double>();
+			this->boilkD = data["boilkD"].get<double>();
+			this->pidLoopTime = data["pidLoopTime"].get<uint16_t>();
+			this->stepInterval = data["stepInterval"].get<uint16_t>();
+			this->boostModeUntil = data["boostModeUntil"].get<uint8_t>();
+			this->savePIDSettings();
+			break;
+		}
+		case CommandGetTempSettings:
+		{
+			// the detection can add sensors while we list them
+			xSemaphoreTakeRecursive(this->sensorsMutex, portMAX_DELAY);
+
+			// Convert sensors to json
+			json jSensors = json::array({});
+
+			for (auto const &[key, val] : this->sensors)
+			{
+				json jSensor = val->to_json();
+				jSensors.push_back(jSensor);
+			}
+
+			resultData = jSensors;
+			xSemaphoreGiveRecursive(this->sensorsMutex);
+			break;
+		}
+		case CommandSaveTempSettings:
+		{
+			this->saveTempSensorSettings(data);
+			break;
+		}
+		case CommandDetectTempSensors:
+		{
+			this->detectOnewireTemperatureSensors();
+			break;
+		}
+		case CommandAddRtdSensor:
+		{
+			// the check for an existing sensor and the add are one change for the bus tasks
+			xSemaphoreTakeRecursive(this->sensorsMutex, portMAX_DELAY);
+
+			if (!this->rtdSensorsEnabled)
+			{
+				success = false;
+				message = "RTD sensors are not enabled in system settings";
+			}
+			else
+			{
+				string name = data["name"];
+				int csPin = data["csPin"];
+				int sensorType = data["sensorType"];
+				bool useForControl = data["useForControl"];
+				bool show = data["show"];
+			
+				// Generate unique ID for RTD sensor
+				uint64_t rtdSensorId = 0x31865000 + csPin; // Base ID + CS pin
+			
+				// Check if sensor already exists
+				if (this->sensors.find(rtdSensorId) != this->sensors.end())
+				{
+					success = false;
+					message = "RTD sensor with CS pin " + to_string(csPin) + " already exists";
+				}
+				else
+				{
+					// Validate GPIO pin
+					if (csPin < 0 || csPin >= GPIO_NUM_MAX)
+					{
+						success = false;
+						message = "Invalid CS pin number: " + to_string(csPin);
+					}
+					else if (this->sensorPool.inUse() >= MAX_TEMP_SENSORS)
+					{
+						success = false;
+						message = "Only " + to_string(MAX_TEMP_SENSORS) + " temperature sensors supported";
+					}
+					else
+					{
+						// Initialize MAX31865 device (SPI bus should already be initialized)
+						max31865_t *rtd_sensor = this->rtdPool.create();
+						esp_err_t ret = (rtd_sensor != nullptr) ? max31865_init_desc(rtd_sensor, SPI2_HOST, csPin) : ESP_ERR_NO_MEM;
+					
+						if (ret == ESP_OK)
+						{
+							// Configure MAX31865
+							ret = max31865_set_config(rtd_sensor, true, 1, false, false, 0, true, true, 0, 0xFFFF);
+						}
+					
+						if (ret == ESP_OK)
+						{
+							// Set RTD parameters based on sensor type
+							if (sensorType == SENSOR_PT100)
+							{
+								rtd_sensor->rtd_nominal = 100;
+								rtd_sensor->ref_resistor = 430;
+							}
+							else if (sensorType == SENSOR_PT1000)
+							{
+								rtd_sensor->rtd_nominal = 1000;
+								rtd_sensor->ref_resistor = 4300;
+							}
+						
+							// Create temperature sensor object
+							auto sensor = this->sensorPool.create();
+							sensor->id = rtdSensorId;
+							sensor->name = name;
+							sensor->color = (sensorType == SENSOR_PT100) ? "#00C853" : "#FF9800"; // Green for PT100, Orange for PT1000
+							sensor->useForControl = useForControl;
+							sensor->show = show;
+							sensor->connected = true;
+							sensor->compensateAbsolute = 0;
+							sensor->compensateRelative = 1;
+							sensor->sensorType = (SensorType)sensorType;
+							sensor->max31865Handle = *rtd_sensor;
+							sensor->consecutiveFailures = 0; // Initialize failure counter
+						
+							this->sensors.insert_or_assign(sensor->id, sensor);
+							this->rtdSensors.push_back(rtd_sensor);
+							this->rtdSensorCount++;
+						
+							// Save sensor settings
+							json jSensors = json::array({});
+							for (auto const &[key, val] : this->sensors)
+							{
+								json jSensor = val->to_json();
+								jSensors.push_back(jSensor);
+							}
+							this->saveTempSensorSettings(jSensors);
+						
+							ESP_LOGI(TAG, "RTD sensor added successfully: %s (CS pin %d)", name.c_str(), csPin);
+							message = "RTD sensor added successfully";
+						}
+						else
+						{
+							this->rtdPool.destroy(rtd_sensor);
+							success = false;
+							message = "Failed to initialize MAX31865: " + string(esp_err_to_name(ret));
+							ESP_LOGE(TAG, "Failed to initialize RTD sensor: %s", esp_err_to_name(ret));
+						}
+					}
+				}
+			}
+			xSemaphoreGiveRecursive(this->sensorsMutex);
+			break;
+		}
+		case CommandAddNtcSensor:
+		{
+			// the check for an existing sensor and the add are one change for the bus tasks
+			xSemaphoreTakeRecursive(this->sensorsMutex, portMAX_DELAY);
+
+			string name = data["name"];
+			int analogPin = data["analogPin"];
+			int sensorType = data["sensorType"];
+			float ntcResistance = data["ntcResistance"];
+			float dividerResistor = data["dividerResistor"];
+			bool useForControl = data["useForControl"];
+			bool show = data["show"];
+		
+			// Generate unique ID for NTC sensor
+			uint64_t ntcSensorId = 0x4E544300 + analogPin; // "NTC" base ID + analog pin
+		
+			// Check if sensor already exists
+			if (this->sensors.find(ntcSensorId) != this->sensors.end())
+			{
+				success = false;
+				message = "NTC sensor with analog pin " + to_string(analogPin) + " already exists";
+			}
+			else
+			{
+				// Validate GPIO pin
+				if (analogPin < 0 || analogPin >= GPIO_NUM_MAX)
+				{
+					success = false;
+					message = "Invalid analog pin number: " + to_string(analogPin);
+				}
+				else if (this->sensorPool.inUse() >= MAX_TEMP_SENSORS)
+				{
+					success = false;
+					message = "Only " + to_string(MAX_TEMP_SENSORS) + " temperature sensors supported";
+				}
+				else
+				{
+					// Create temperature sensor object
+					auto sensor = this->sensorPool.create();
+					sensor->id = ntcSensorId;
+					sensor->name = name;
+					sensor->color = "#9C27B0"; // Purple for NTC
+					sensor->useForControl = useForControl;
+					sensor->show = show;
+					sensor->connected = true; // NTC sensors are always "connected" if properly wired
+					sensor->compensateAbsolute = 0;
+					sensor->compensateRelative = 1;
+					sensor->sensorType = (SensorType)sensorType;
+					sensor->analogPin = analogPin;
+					sensor->ntcResistance = ntcResistance;
+					sensor->dividerResistor = dividerResistor;
+					sensor->oversample = 8;
+					sensor->consecutiveFailures = 0;
+				
+					this->sensors.insert_or_assign(sensor->id, sensor);
+				
+					// Save sensor settings
+					json jSensors = json::array({});
+					for (auto const &[key, val] : this->sensors)
+					{
+						json jSensor = val->to_json();
+						jSensors.push_back(jSensor);
+					}
+					this->saveTempSensorSettings(jSensors);
+				
+					ESP_LOGI(TAG, "NTC sensor added successfully: %s (analog pin %d)", name.c_str(), analogPin);
+					message = "NTC sensor added successfully";
+				}
+			}
+			xSemaphoreGiveRecursive(this->sensorsMutex);
+			break;
+		}
+		case CommandGetHeaterSettings:
+		{
+			// Convert heaters to json
+			json jHeaters = json::array({});
+
+			for (auto const &heater : this->heaters)
+			{
+				json jHeater = heater->to_json();
+				jHeaters.push_back(jHeater);
+			}
+
+			resultData = jHeaters;
+			break;
+		}
+		case CommandSaveHeaterSettings:
+		{
+			if (this->controlRun || this->vesselsRunning())
+			{
+				message = "You cannot save heater settings while running!";
+				success = false;
+			}
+			else
+			{
+				this->saveHeaterSettings(data);
+			}
+			break;
+		}
+		case CommandGetVesselSettings:
+		{
+			json jVessels = json::array({});
+
+			for (auto const &vessel : this->vessels)
+			{
+				jVessels.push_back(vessel->to_json());
+			}
+
+			resultData = jVessels;
+			break;
+		}
+		case CommandSaveVesselSettings:
+		{
+			// the vessel loop may still be busy with the last one, it uses the vessel objects
+			if (this->vesselsRunning() || this->vesselLoopRunning)
+			{
+				message = "You cannot save vessel settings while a vessel is running!";
+				success = false;
+			}
+			else
+			{
+				this->saveVesselSettings(data);
+			}
+			break;
+		}
+		case CommandStartVessel:
+		{
+			message = this->startVessel(data);
+			success = message.empty();
+			break;
+		}
+		case CommandStopVessel:
+		{
+			message = this->stopVessel(data);
+			success = message.empty();
+			break;
+		}
+		case CommandGetWifiSettings:
+		{
+			// get data from wifi-connect
+			if (this->GetWifiSettingsJson)
+			{
+				resultData = this->GetWifiSettingsJson();
+			}
+			break;
+		}
+		case CommandSaveWifiSettings:
+		{
+			// save via wifi-connect
+			if (this->SaveWifiSettingsJson)
+			{
+				this->SaveWifiSettingsJson(data);
+			}
+			message = "Please restart device for changes to have effect!";
+			break;
+		}
+		case CommandScanWifi:
+		{
+			// scans for networks
+			if (this->ScanWifiJson)
+			{
+				resultData = this->ScanWifiJson();
+			}
+			break;
+		}
+		case CommandGetSystemSettings:
+		{
+			resultData = {
+				{"onewirePin", this->oneWire_PIN},
+				{"stirPin", this->stir_PIN},
+				{"buzzerPin", this->buzzer_PIN},
+				{"buzzerTime", this->buzzerTime},
+				{"invertOutputs", this->invertOutputs},
+				{"outputMode", this->outputMode},
+				{"mainsFrequency", this->mainsFrequency},
+				{"maxPower", this->maxPower},
+				{"mqttUri", this->mqttUri},
+				{"mqttDeadband", (double)this->mqttDeadband / 10},
+				{"mqttMinInterval", this->mqttMinInterval},
+				{"temperatureScale", this->temperatureScale},
+				{"rtdSensorsEnabled", this->rtdSensorsEnabled},
+				{"spiMosiPin", this->spi_mosi_pin},
+				{"spiMisoPin", this->spi_miso_pin},
+				{"spiClkPin", this->spi_clk_pin},
+				{"spiCsPin", this->spi_cs_pin},
+				{"firebaseUrl", this->firebaseUrl},
+				{"firebaseApiKey", this->firebaseApiKey},
+				{"firebaseAuthToken", this->firebaseAuthToken},
+				{"firebaseEmail", this->firebaseEmail},
+				{"firebasePassword", this->firebasePassword},
+				{"firebaseAuthMethod", this->firebaseAuthMethod},
+				{"firebaseSendInterval", this->firebaseSendInterval},
+				{"firebaseDatabaseEnabled", this->firebaseDatabaseEnabled},
+			};
+			break;
+		}
+		case CommandSaveSystemSettings:
+		{
+			string error = this->saveSystemSettingsJson(data);
+			if (!error.empty())
+			{
+				message = error;
+				success = false;
+				break;
+			}
+			message = "Please restart device for changes to have effect!";
+			break;
+		}
+		case CommandTestFirebase:
+		{
+			if (this->firebaseUrl.empty())
+			{
+				message = "Firebase configuration incomplete";
+				success = false;
+			}
+			else
+			{
+				// Test connection with a dummy data point
+				esp_err_t result = this->writeTemperatureToFirebase(25.0, 25.0, 50, "test");
+				if (result == ESP_OK) {
+					message = "Firebase connection test successful";
+				} else {
+					message = "Firebase connection test failed - check logs for details";
+					success = false;
+				}
+			}
+			break;
+		}
+		case CommandReboot:
+		{
+			xTaskCreate(&this->reboot, "reboot_task", 1024, this, 5, NULL);
+			break;
+		}
+		case CommandFactoryReset:
+		{
+			this->settingsManager->FactoryReset();
+			message = "Device will restart shortly, reconnect to factory wifi settings to continue!";
+			xTaskCreate(&this->reboot, "reboot_task", 1024, this, 5, NULL);
+			break;
+		}
+		case CommandBootIntoRecovery:
+		{
+			message = this->bootIntoRecovery();
+
+			if (message.find("Error") != std::string::npos)
+			{
+				success = false;
+			}
+			else
+			{
+				xTaskCreate(&this->reboot, "reboot_task", 1024, this, 5, NULL);
+			}
+			break;
+		}
+		case CommandGetStatistics:
 		{
-			success = false;
+			if (this->firebaseEnabled)
+			{
+				resultData = this->getFirebaseStatistics(data);
+			}
+			else
+			{
+				vector<BrewSession> sessions = this->statisticsManager->GetSessionList();
+				json jSessions = json::array();
+			
+				for (const auto& session : sessions) {
+					json jSession;
+					jSession["sessionId"] = session.sessionId;
+					jSession["scheduleName"] = session.scheduleName;
+					jSession["startTime"] = session.startTime;
+					jSession["endTime"] = session.endTime;
+				jSession["duration"] = session.totalDuration;
+				jSession["dataPoints"] = session.dataPoints;
+				jSession["avgTemperature"] = session.avgTemperature;
+				jSession["minTemperature"] = session.minTemperature;
+				jSession["maxTemperature"] = session.maxTemperature;
+				jSession["completed"] = session.completed;
+				jSessions.push_back(jSession);
+				}
+			
+				resultData["sessions"] = jSessions;
+			
+				map<string, uint32_t> stats = this->statisticsManager->GetSessionStats();
+				resultData["stats"] = stats;
+			
+				json jConfig;
+				jConfig["maxSessions"] = this->statisticsManager->GetMaxSessions();
+				jConfig["currentSessionActive"] = this->statisticsManager->IsSessionActive();
+				if (this->statisticsManager->IsSessionActive()) {
+					jConfig["currentSessionId"] = this->statisticsManager->GetCurrentSessionId();
+					jConfig["currentDataPoints"] = this->statisticsManager->GetCurrentSessionDataPoints();
+				}
+				resultData["config"] = jConfig;
+			}
+			break;
 		}
-		else
+		case CommandGetSessionData:
 		{
-			xTaskCreate(&this->reboot, "reboot_task", 1024, this, 5, NULL);
+			if (data["sessionId"].is_null()) {
+				message = "Session ID required";
+				success = false;
+			}
+			else {
+				if (this->firebaseEnabled)
+				{
+					resultData = this->getFirebaseSessionData(data);
+				}
+				else
+				{
+					uint32_t sessionId = data["sessionId"];
+					BrewSession session = this->statisticsManager->GetSessionById(sessionId);
+				
+					if (session.sessionId == 0) {
+						message = "Session not found";
+						success = false;
+					}
+					else {
+						vector<TempDataPoint> sessionData = this->statisticsManager->GetSessionData(sessionId);
+				
+					json jSession;
+					jSession["sessionId"] = session.sessionId;
+					jSession["scheduleName"] = session.scheduleName;
+					jSession["startTime"] = session.startTime;
+					jSession["endTime"] = session.endTime;
+					jSession["duration"] = session.totalDuration;
+					jSession["avgTemperature"] = session.avgTemperature;
+					jSession["minTemperature"] = session.minTemperature;
+					jSession["maxTemperature"] = session.maxTemperature;
+					jSession["completed"] = session.completed;
+				
+					json jData = json::array();
+					for (const auto& point : sessionData) {
+						json jPoint;
+						jPoint["timestamp"] = point.timestamp;
+						jPoint["avgTemp"] = (int)point.avgTemp;
+						jPoint["targetTemp"] = (int)point.targetTemp;
+						jPoint["pidOutput"] = (int)point.pidOutput;
+						jData.push_back(jPoint);
+					}
+				
+						jSession["data"] = jData;
+						resultData = jSession;
+					}
+				}
+			}
+			break;
+		}
+		case CommandExportSession:
+		{
+			if (data["sessionId"].is_null()) {
+				message = "Session ID required";
+				success = false;
+			}
+			else {
+				uint32_t sessionId = data["sessionId"];
+				string format = data.value("format", "json");
+			
+				if (format == "json") {
+					string exportData = this->statisticsManager->ExportSessionToJson(sessionId);
+					if (exportData == "{}") {
+						message = "Session not found";
+						success = false;
+					}
+					else {
+						resultData["exportData"] = exportData;
+						resultData["format"] = "json";
+					}
+				}
+				else if (format == "csv") {
+					string exportData = this->statisticsManager->ExportSessionToCsv(sessionId);
+					if (exportData.empty()) {
+						message = "Session not found or no data";
+						success = false;
+					}
+					else {
+						resultData["exportData"] = exportData;
+						resultData["format"] = "csv";
+					}
+				}
+				else {
+					message = "Invalid format. Use 'json' or 'csv'";
+					success = false;
+				}
+			}
+			break;
+		}
+		case CommandSetStatisticsConfig:
+		{
+			if (!data["maxSessions"].is_null()) {
+				uint8_t maxSessions = data["maxSessions"];
+				this->statisticsManager->SetMaxSessions(maxSessions);
+			}
+		
+			resultData["maxSessions"] = this->statisticsManager->GetMaxSessions();
+			message = "Statistics configuration updated";
+			break;
+		}
+		default:
+			break;
+	}
+
+	json jResultPayload;
+	jResultPayload["data"] = resultData;
+	jResultPayload["success"] = success;
+
+	if (message != "")
+	{
+		jResultPayload["message"] = message;
+	}
+
+	// Log memory usage before JSON serialization
+	ESP_LOGI(TAG, "Free heap before JSON serialization: %lu bytes", esp_get_free_heap_size());
+	ESP_LOGI(TAG, "Min free heap: %lu bytes", esp_get_minimum_free_heap_size());
+
+	string resultPayload;
+	try {
+		resultPayload = jResultPayload.dump();
+		ESP_LOGD(TAG, "JSON serialization successful, size: %zu bytes", resultPayload.length());
+	} catch (const std::exception& e) {
+		ESP_LOGE(TAG, "JSON serialization failed: %s", e.what());
+		ESP_LOGE(TAG, "Free heap after failure: %lu bytes", esp_get_free_heap_size());
+		
+		// Return minimal error response
+		json errorResponse;
+		errorResponse["success"] = false;
+		errorResponse["message"] = "Memory allocation error during JSON serialization";
+		errorResponse["data"] = json::object();
+		resultPayload = errorResponse.dump();
+	}
+
+	return resultPayload;
+}
+
+httpd_handle_t BrewEngine::startWebserver(void)
+{
+
+	httpd_uri_t indexUri = {};
+	indexUri.uri = "/";
+	indexUri.method = HTTP_GET;
+	indexUri.handler = this->assetGetHandler;
+
+	httpd_uri_t logoUri = {};
+	logoUri.uri = "/logo.svg";
+	logoUri.method = HTTP_GET;
+	logoUri.handler = this->assetGetHandler;
+
+	httpd_uri_t manifestUri = {};
+	manifestUri.uri = "/manifest.json";
+	manifestUri.method = HTTP_GET;
+	manifestUri.handler = this->assetGetHandler;
+
+	httpd_uri_t postUri = {};
+	postUri.uri = "/api";
+	postUri.method = HTTP_POST;
+	postUri.handler = this->apiPostHandler;
+
+	httpd_uri_t optionsUri = {};
+	optionsUri.uri = "/api";
+	optionsUri.method = HTTP_OPTIONS;
+	optionsUri.handler = this->apiOptionsHandler;
+
+	httpd_uri_t wsUri = {};
+	wsUri.uri = "/ws";
+	wsUri.method = HTTP_GET;
+	wsUri.handler = this->wsHandler;
+	wsUri.is_websocket = true;
+
+	httpd_uri_t exportUri = {};
+	exportUri.uri = "/export/*";
+	exportUri.method = HTTP_GET;
+	exportUri.handler = this->exportGetHandler;
+
+	httpd_uri_t otherUri = {};
+	otherUri.uri = "/*";
+	otherUri.method = HTTP_GET;
+	otherUri.handler = this->assetGetHandler;
+
+	httpd_handle_t server = NULL;
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	// whiout this the esp crashed whitout a proper warning
+	config.stack_size = 32768;          // Increased from 20480 to prevent stack overflow
+	config.uri_match_fn = httpd_uri_match_wildcard;
+	config.max_open_sockets = HTTPD_MAX_OPEN_SOCKETS; // Reduce concurrent connections, websockets stay open
+	config.lru_purge_enable = true;     // Drop the oldest idle connection instead of refusing a new one
+	config.max_uri_handlers = 10;       // Limit URI handlers
+	config.max_resp_headers = 8;        // Limit response headers
+	config.recv_wait_timeout = 5;       // Reduce timeout to free resources faster
+	config.send_wait_timeout = 5;       // Reduce timeout to free resources faster
+
+	// Start the httpd server
+	ESP_LOGI(TAG, "Starting server on port: '%d'", config.server_port);
+	if (httpd_start(&server, &config) == ESP_OK)
+	{
+		// Set URI handlers
+		httpd_register_uri_handler(server, &indexUri);
+		httpd_register_uri_handler(server, &logoUri);
+		httpd_register_uri_handler(server, &manifestUri);
+		httpd_register_uri_handler(server, &wsUri); // before the wildcard, first match wins
+		httpd_register_uri_handler(server, &exportUri);
+		httpd_register_uri_handler(server, &otherUri);
+		httpd_register_uri_handler(server, &postUri);
+		httpd_register_uri_handler(server, &optionsUri);
+		return server;
+	}
+
+	ESP_LOGI(TAG, "Error starting server!");
+	return NULL;
+}
+
+void BrewEngine::logRemote(const string &message)
+{
+	if (this->mqttEnabled && !this->simulation)
+	{
+		string iso_datetime = this->to_iso_8601(std::chrono::system_clock::now());
+		json jPayload;
+		jPayload["time"] = iso_datetime;
+		jPayload["level"] = "Debug";
+		jPayload["message"] = message;
+		string payload = jPayload.dump();
+
+		esp_mqtt_client_publish(this->mqttClient, this->mqttTopicLog.c_str(), payload.c_str(), 0, 1, 1);
+	}
+}
+
+void BrewEngine::stopWebserver(httpd_handle_t server)
+{
+	// Stop the httpd server
+	httpd_stop(server);
+}
+
+// Embedded web files, their ETags are made at build time (web-assets.h) from the firmware version and a hash of the file.
+// Browsers revalidate them on every load, which is a 304 without a body until a firmware update changes them.
+extern const unsigned char index_html_start[] asm("_binary_index_html_gz_start");
+extern const unsigned char index_html_end[] asm("_binary_index_html_gz_end");
+extern const unsigned char logo_svg_file_start[] asm("_binary_logo_svg_gz_start");
+extern const unsigned char logo_svg_file_end[] asm("_binary_logo_svg_gz_end");
+extern const unsigned char manifest_json_file_start[] asm("_binary_manifest_json_start");
+extern const unsigned char manifest_json_file_end[] asm("_binary_manifest_json_end");
+
+struct WebAsset
+{
+	const char *uri;
+	const unsigned char *start;
+	const unsigned char *end;
+	const char *type;
+	bool gzip;
+	const char *etag;
+};
+
+static const WebAsset webAssets[] = {
+	{"/", index_html_start, index_html_end, "text/html", true, INDEX_HTML_ETAG},
+	{"/logo.svg", logo_svg_file_start, logo_svg_file_end, "image/svg+xml", true, LOGO_SVG_ETAG},
+	{"/manifest.json", manifest_json_file_start, manifest_json_file_end, "application/json", false, MANIFEST_JSON_ETAG},
+};
+
+static bool headerContains(httpd_req_t *req, const char *field, const char *value)
+{
+	size_t length = httpd_req_get_hdr_value_len(req, field);
+	if (length == 0)
+	{
+		return false;
+	}
+
+	string header(length + 1, '\0');
+	if (httpd_req_get_hdr_value_str(req, field, &header[0], header.size()) != ESP_OK)
+	{
+		return false;
+	}
+
+	return header.find(value) != string::npos;
+}
+
+esp_err_t BrewEngine::assetGetHandler(httpd_req_t *req)
+{
+	// the query string doesn't select another file
+	size_t uriLength = strcspn(req->uri, "?");
+
+	for (auto const &asset : webAssets)
+	{
+		if (strlen(asset.uri) != uriLength || strncmp(asset.uri, req->uri, uriLength) != 0)
+		{
+			continue;
+		}
+
+		// the urls are fixed, so the browser must check with us, immutable would keep an old ui after an update
+		httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+		httpd_resp_set_hdr(req, "ETag", asset.etag);
+
+		if (headerContains(req, "If-None-Match", asset.etag))
+		{
+			httpd_resp_set_status(req, "304 Not Modified");
+			httpd_resp_send(req, NULL, 0);
+			return ESP_OK;
+		}
+
+		httpd_resp_set_type(req, asset.type);
+		if (asset.gzip)
+		{
+			httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+		}
+		httpd_resp_send(req, (const char *)asset.start, asset.end - asset.start);
+
+		return ESP_OK;
+	}
+
+	httpd_resp_set_status(req, "307 Temporary Redirect");
+	httpd_resp_set_hdr(req, "Location", "/");
+	httpd_resp_send(req, "<html><body>Wrong</body></html>", 0); // Response body can be empty
+
+	return ESP_OK;
+}
+
+// Download of the session history: /export/<sessionId>.csv, /export/<sessionId>.json or /export/all.json (overview),
+// the optional query parameter step only sends every n-th point. Rows are streamed straight from storage.
+esp_err_t BrewEngine::exportGetHandler(httpd_req_t *req)
+{
+	const char *name = req->uri + strlen("/export/");
+	const char *query = strchr(name, '?');
+	string file = (query != NULL) ? string(name, query - name) : string(name);
+
+	uint16_t step = 1;
+	char queryString[32];
+	char stepValue[8];
+	if (httpd_req_get_url_query_str(req, queryString, sizeof(queryString)) == ESP_OK &&
+		httpd_query_key_value(queryString, "step", stepValue, sizeof(stepValue)) == ESP_OK)
+	{
+		int value = atoi(stepValue);
+		if (value >= 1 && value <= 1000)
+		{
+			step = value;
+		}
+	}
+
+	size_t dot = file.rfind('.');
+	string format = (dot != string::npos) ? file.substr(dot + 1) : "";
+	string id = file.substr(0, dot);
+
+	httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+	if (id == "all" && format == "json")
+	{
+		httpd_resp_set_type(req, "application/json");
+
+		ChunkedWriter writer(req);
+		mainInstance->statisticsManager->ExportAllSessionsToJson([&writer](const char *data, size_t length) { writer.write(data, length); });
+		return writer.finish();
+	}
+
+	uint32_t sessionId = strtoul(id.c_str(), NULL, 10);
+	if (sessionId == 0 || (format != "csv" && format != "json") || mainInstance->statisticsManager->GetSessionById(sessionId).sessionId == 0)
+	{
+		httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Session not found");
+		return ESP_OK;
+	}
+
+	// must stay valid until the headers are sent with the first chunk
+	char disposition[64];
+	snprintf(disposition, sizeof(disposition), "attachment; filename=\"session-%lu.%s\"", (unsigned long)sessionId, format.c_str());
+	httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+	httpd_resp_set_type(req, (format == "csv") ? "text/csv" : "application/json");
+
+	ChunkedWriter writer(req);
+	auto write = [&writer](const char *data, size_t length) { writer.write(data, length); };
+
+	if (format == "csv")
+	{
+		mainInstance->statisticsManager->ExportSessionToCsv(sessionId, write, step);
+	}
+	else
+	{
+		mainInstance->statisticsManager->ExportSessionToJson(sessionId, write, step);
+	}
+
+	return writer.finish();
+}
+
+// Commands with potentially large results are written straight to the socket in chunks instead of being built in memory first,
+// returns false when the command is not streamed and the normal processCommand response must be sent.
+bool BrewEngine::streamCommand(httpd_req_t *req, ApiCommand command, const json &data)
+{
+	if (command == CommandData)
+	{
+		ChunkedWriter writer(req);
+		char line[48];
+
+		writer.write("{\"data\":{\"tempLog\":[");
+
+		// If we have a last date we only need to send the log increment
+		size_t first = 0;
+		if (data.is_object() && data.contains("lastDate") && data["lastDate"].is_number())
+		{
+			first = this->tempLog.findAfter((time_t)data["lastDate"]);
+		}
+
+		size_t logSize = this->tempLog.size();
+		time_t logTime;
+		float logTemperature;
+		for (size_t i = first; i < logSize && this->tempLog.read(i, logTime, logTemperature); i++)
+		{
+			int length = snprintf(line, sizeof(line), "%s{\"time\":%lld,\"temp\":%.1f}", (i == first) ? "" : ",", (long long)logTime, logTemperature);
+			writer.write(line, length);
+		}
+		writer.write("]");
+
+		json resultData = this->getData(data, false);
+		for (auto &[key, value] : resultData.items())
+		{
+			writer.write(",\"" + key + "\":" + value.dump());
 		}
+
+		writer.write("},\"message\":\"\",\"success\":true}");
+		writer.finish();
+
+		return true;
 	}
-	else if (command == "GetStatistics")
+	else if (command == CommandGetRunningSchedule)
 	{
-		if (this->firebaseEnabled)
+		vector<ScheduleEdit> edits;
+		if (data.is_object() && data.contains("sinceVersion") && data["sinceVersion"].is_number() && this->scheduleEdits.since((uint16_t)data["sinceVersion"], edits))
 		{
-			resultData = this->getFirebaseStatistics(data);
+			return false; // the difference is small, processCommand sends it
 		}
-		else
+
+		// a long boil has hundreds of steps, we send them one by one instead of building the whole document
+		ChunkedWriter writer(req);
+
+		writer.write("{\"data\":{\"version\":" + to_string(this->runningVersion) + ",\"steps\":[");
+		for (size_t i = 0; i < this->executionSteps.size(); i++)
 		{
-			vector<BrewSession> sessions = this->statisticsManager->GetSessionList();
-			json jSessions = json::array();
-			
-			for (const auto& session : sessions) {
-				json jSession;
-				jSession["sessionId"] = session.sessionId;
-				jSession["scheduleName"] = session.scheduleName;
-				jSession["startTime"] = session.startTime;
-				jSession["endTime"] = session.endTime;
-			jSession["duration"] = session.totalDuration;
-			jSession["dataPoints"] = session.dataPoints;
-			jSession["avgTemperature"] = session.avgTemperature;
-			jSession["minTemperature"] = session.minTemperature;
-			jSession["maxTemperature"] = session.maxTemperature;
-			jSession["completed"] = session.completed;
-			jSessions.push_back(jSession);
+			if (i > 0)
+			{
+				writer.write(",");
 			}
-			
-			resultData["sessions"] = jSessions;
-			
-			map<string, uint32_t> stats = this->statisticsManager->GetSessionStats();
-			resultData["stats"] = stats;
-			
-			json jConfig;
-			jConfig["maxSessions"] = this->statisticsManager->GetMaxSessions();
-			jConfig["currentSessionActive"] = this->statisticsManager->IsSessionActive();
-			if (this->statisticsManager->IsSessionActive()) {
-				jConfig["currentSessionId"] = this->statisticsManager->GetCurrentSessionId();
-				jConfig["currentDataPoints"] = this->statisticsManager->GetCurrentSessionDataPoints();
+			writer.write(this->executionSteps[i].to_json().dump());
+		}
+
+		writer.write("],\"notifications\":[");
+		bool first = true;
+		for (auto &notification : this->notifications)
+		{
+			if (!first)
+			{
+				writer.write(",");
 			}
-			resultData["config"] = jConfig;
+			writer.write(notification->to_json().dump());
+			first = false;
 		}
+		writer.write("]},\"message\":\"\",\"success\":true}");
+		writer.finish();
+
+		return true;
 	}
-	else if (command == "GetSessionData")
+	else if (command == CommandGetMashSchedules)
 	{
-		if (data["sessionId"].is_null()) {
-			message = "Session ID required";
-			success = false;
-		}
-		else {
-			if (this->firebaseEnabled)
-			{
-				resultData = this->getFirebaseSessionData(data);
-			}
-			else
+		ChunkedWriter writer(req);
+		bool first = true;
+
+		writer.write("{\"data\":[");
+		for (auto const &[key, val] : this->mashSchedules)
+		{
+			if (!first)
 			{
-				uint32_t sessionId = data["sessionId"];
-				BrewSession session = this->statisticsManager->GetSessionById(sessionId);
-				
-				if (session.sessionId == 0) {
-					message = "Session not found";
-					success = false;
-				}
-				else {
-					vector<TempDataPoint> sessionData = this->statisticsManager->GetSessionData(sessionId);
-				
-				json jSession;
-				jSession["sessionId"] = session.sessionId;
-				jSession["scheduleName"] = session.scheduleName;
-				jSession["startTime"] = session.startTime;
-				jSession["endTime"] = session.endTime;
-				jSession["duration"] = session.totalDuration;
-				jSession["avgTemperature"] = session.avgTemperature;
-				jSession["minTemperature"] = session.minTemperature;
-				jSession["maxTemperature"] = session.maxTemperature;
-				jSession["completed"] = session.completed;
-				
-				json jData = json::array();
-				for (const auto& point : sessionData) {
-					json jPoint;
-					jPoint["timestamp"] = point.timestamp;
-					jPoint["avgTemp"] = (int)point.avgTemp;
-					jPoint["targetTemp"] = (int)point.targetTemp;
-					jPoint["pidOutput"] = (int)point.pidOutput;
-					jData.push_back(jPoint);
-				}
-				
-					jSession["data"] = jData;
-					resultData = jSession;
-				}
+				writer.write(",");
 			}
+			writer.write(val->to_json().dump());
+			first = false;
 		}
+		writer.write("],\"message\":\"\",\"success\":true}");
+		writer.finish();
+
+		return true;
 	}
-	else if (command == "ExportSession")
+	else if (command == CommandExportSession)
 	{
-		if (data["sessionId"].is_null()) {
-			message = "Session ID required";
-			success = false;
+		if (!data.is_object() || !data.contains("sessionId") || !data["sessionId"].is_number())
+		{
+			return false; // let processCommand report the error
 		}
-		else {
-			uint32_t sessionId = data["sessionId"];
-			string format = data.value("format", "json");
-			
-			if (format == "json") {
-				string exportData = this->statisticsManager->ExportSessionToJson(sessionId);
-				if (exportData == "{}") {
-					message = "Session not found";
-					success = false;
-				}
-				else {
-					resultData["exportData"] = exportData;
-					resultData["format"] = "json";
-				}
+
+		uint32_t sessionId = data["sessionId"];
+		string format = data.value("format", "json");
+
+		if (format != "json" && format != "csv")
+		{
+			return false;
+		}
+
+		ChunkedWriter writer(req);
+		bool started = false;
+
+		// the export is sent as a json string, so every piece is escaped on the way out,
+		// runs that need no escaping are passed on as they are
+		auto write = [&](const char *piece, size_t length) {
+			if (!started)
+			{
+				writer.write("{\"data\":{\"format\":\"" + format + "\",\"exportData\":\"");
+				started = true;
 			}
-			else if (format == "csv") {
-				string exportData = this->statisticsManager->ExportSessionToCsv(sessionId);
-				if (exportData.empty()) {
-					message = "Session not found or no data";
-					success = false;
+
+			size_t runStart = 0;
+			for (size_t i = 0; i < length; i++)
+			{
+				unsigned char character = (unsigned char)piece[i];
+				if (character != '"' && character != '\\' && character >= 0x20)
+				{
+					continue;
 				}
-				else {
-					resultData["exportData"] = exportData;
-					resultData["format"] = "csv";
+
+				writer.write(piece + runStart, i - runStart);
+				runStart = i + 1;
+
+				char escaped[8];
+				switch (character)
+				{
+					case '"':
+						writer.write("\\\"");
+						break;
+					case '\\':
+						writer.write("\\\\");
+						break;
+					case '\n':
+						writer.write("\\n");
+						break;
+					case '\r':
+						writer.write("\\r");
+						break;
+					case '\t':
+						writer.write("\\t");
+						break;
+					default:
+						snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+						writer.write(escaped);
 				}
 			}
-			else {
-				message = "Invalid format. Use 'json' or 'csv'";
-				success = false;
-			}
+			writer.write(piece + runStart, length - runStart);
+		};
+
+		bool found = (format == "json") ? this->statisticsManager->ExportSessionToJson(sessionId, write) : this->statisticsManager->ExportSessionToCsv(sessionId, write);
+
+		if (!started)
+		{
+			// nothing was sent yet, processCommand will send the not found message
+			return false;
 		}
-	}
-	else if (command == "SetStatisticsConfig")
-	{
-		if (!data["maxSessions"].is_null()) {
-			uint8_t maxSessions = data["maxSessions"];
-			this->statisticsManager->SetMaxSessions(maxSessions);
+
+		if (!found)
+		{
+			ESP_LOGW(TAG, "Export of session %lu incomplete", (unsigned long)sessionId);
 		}
-		
-		resultData["maxSessions"] = this->statisticsManager->GetMaxSessions();
-		message = "Statistics configuration updated";
+
+		writer.write("\"},\"message\":\"\",\"success\":true}");
+		writer.finish();
+
+		return true;
 	}
 
-	json jResultPayload;
-	jResultPayload["data"] = resultData;
-	jResultPayload["success"] = success;
+	return false;
+}
 
-	if (message != "")
+esp_err_t BrewEngine::apiPostHandler(httpd_req_t *req)
+{
+	PerfTimer timer(mainInstance->perf, PerfHttpRequest);
+
+	httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+	httpd_resp_set_hdr(req, "Vary", "Accept");
+
+	if (req->content_len > API_MAX_BODY)
 	{
-		jResultPayload["message"] = message;
+		ESP_LOGW(TAG, "Api request of %zu bytes refused, max is %d", req->content_len, API_MAX_BODY);
+		httpd_resp_set_status(req, "413 Payload Too Large");
+		httpd_resp_set_type(req, "text/plain");
+		httpd_resp_sendstr(req, "{\"data\":{},\"success\":false,\"message\":\"Request too large\"}");
+
+		// the body is not read, so the connection can't be used for the next request
+		return ESP_FAIL;
 	}
 
-	// Log memory usage before JSON serialization
-	ESP_LOGI(TAG, "Free heap before JSON serialization: %lu bytes", esp_get_free_heap_size());
-	ESP_LOGI(TAG, "Min free heap: %lu bytes", esp_get_minimum_free_heap_size());
+	// the webserver has one task, so requests never share the buffer
+	char *buffer = mainInstance->apiBuffer;
+	size_t received = 0;
 
-	string resultPayload;
-	try {
-		resultPayload = jResultPayload.dump();
-		ESP_LOGD(TAG, "JSON serialization successful, size: %zu bytes", resultPayload.length());
-	} catch (const std::exception& e) {
-		ESP_LOGE(TAG, "JSON serialization failed: %s", e.what());
-		ESP_LOGE(TAG, "Free heap after failure: %lu bytes", esp_get_free_heap_size());
-		
-		// Return minimal error response
-		json errorResponse;
-		errorResponse["success"] = false;
-		errorResponse["message"] = "Memory allocation error during JSON serialization";
-		errorResponse["data"] = json::object();
-		resultPayload = errorResponse.dump();
+	while (received < req->content_len)
+	{
+		int ret = httpd_req_recv(req, buffer + received, req->content_len - received);
+
+		if (ret <= 0)
+		{
+			if (ret == HTTPD_SOCK_ERR_TIMEOUT)
+			{
+				// Timeout, just continue
+				continue;
+			}
+
+			return ESP_FAIL;
+		}
+
+		received += ret;
 	}
 
-	return resultPayload;
-}
+	// clients on a weak connection can ask for cbor, the web ui keeps using json
+	bool cborRequest = headerContains(req, "Content-Type", "application/cbor");
+	bool cborResponse = headerContains(req, "Accept", "application/cbor");
 
-httpd_handle_t BrewEngine::startWebserver(void)
-{
+	// parsed straight from the receive buffer
+	json jCommand = cborRequest ? json::from_cbor(buffer, buffer + received, true, false) : json::parse(buffer, buffer + received, nullptr, false);
 
-	httpd_uri_t indexUri;
-	indexUri.uri = "/";
-	indexUri.method = HTTP_GET;
-	indexUri.handler = this->indexGetHandler;
+	if (!jCommand.is_object() || !jCommand["command"].is_string())
+	{
+		httpd_resp_set_status(req, "400 Bad Request");
+		httpd_resp_set_type(req, "text/plain");
+		httpd_resp_sendstr(req, "{\"data\":{},\"success\":false,\"message\":\"Invalid request\"}");
 
-	httpd_uri_t logoUri;
-	logoUri.uri = "/logo.svg";
-	logoUri.method = HTTP_GET;
-	logoUri.handler = this->logoGetHandler;
+		return ESP_OK;
+	}
 
-	httpd_uri_t manifestUri;
-	manifestUri.uri = "/manifest.json";
-	manifestUri.method = HTTP_GET;
-	manifestUri.handler = this->manifestGetHandler;
+	ApiCommand command = lookupApiCommand(jCommand["command"].get_ref<const string &>());
+	json data = std::move(jCommand["data"]);
 
-	httpd_uri_t postUri;
-	postUri.uri = "/api";
-	postUri.method = HTTP_POST;
-	postUri.handler = this->apiPostHandler;
+	if (cborResponse)
+	{
+		// the streamed commands are built as json text, so cbor clients always go through processCommand
+		string commandResult = mainInstance->processCommand(command, std::move(data));
+		vector<uint8_t> encoded = json::to_cbor(json::parse(commandResult, nullptr, false));
 
-	httpd_uri_t optionsUri;
-	optionsUri.uri = "/api";
-	optionsUri.method = HTTP_OPTIONS;
-	optionsUri.handler = this->apiOptionsHandler;
+		httpd_resp_set_type(req, "application/cbor");
+		httpd_resp_send(req, (const char *)encoded.data(), encoded.size());
 
-	httpd_uri_t otherUri;
-	otherUri.uri = "/*";
-	otherUri.method = HTTP_GET;
-	otherUri.handler = this->otherGetHandler;
+		return ESP_OK;
+	}
 
-	httpd_handle_t server = NULL;
-	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-	// whiout this the esp crashed whitout a proper warning
-	config.stack_size = 32768;          // Increased from 20480 to prevent stack overflow
-	config.uri_match_fn = httpd_uri_match_wildcard;
-	config.max_open_sockets = 4;        // Reduce concurrent connections 
-	config.max_uri_handlers = 8;        // Limit URI handlers
-	config.max_resp_headers = 8;        // Limit response headers
-	config.recv_wait_timeout = 5;       // Reduce timeout to free resources faster
-	config.send_wait_timeout = 5;       // Reduce timeout to free resources faster
+	httpd_resp_set_type(req, "text/plain");
 
-	// Start the httpd server
-	ESP_LOGI(TAG, "Starting server on port: '%d'", config.server_port);
-	if (httpd_start(&server, &config) == ESP_OK)
+	if (mainInstance->streamCommand(req, command, data))
 	{
-		// Set URI handlers
-		httpd_register_uri_handler(server, &indexUri);
-		httpd_register_uri_handler(server, &logoUri);
-		httpd_register_uri_handler(server, &manifestUri);
-		httpd_register_uri_handler(server, &otherUri);
-		httpd_register_uri_handler(server, &postUri);
-		httpd_register_uri_handler(server, &optionsUri);
-		return server;
+		return ESP_OK;
 	}
 
-	ESP_LOGI(TAG, "Error starting server!");
-	return NULL;
+	string commandResult = mainInstance->processCommand(command, std::move(data));
+	httpd_resp_sendstr(req, commandResult.c_str());
+
+	return ESP_OK;
 }
 
-void BrewEngine::logRemote(const string &message)
+// Push channel for the web ui, pushLoop sends the changes to all connected clients
+esp_err_t BrewEngine::wsHandler(httpd_req_t *req)
 {
-	if (this->mqttEnabled)
+	if (req->method == HTTP_GET)
 	{
-		string iso_datetime = this->to_iso_8601(std::chrono::system_clock::now());
-		json jPayload;
-		jPayload["time"] = iso_datetime;
-		jPayload["level"] = "Debug";
-		jPayload["message"] = message;
-		string payload = jPayload.dump();
+		// handshake done, pushLoop will pick up the new socket and send a snapshot
+		ESP_LOGI(TAG, "Websocket client connected on socket %d", httpd_req_to_sockfd(req));
+		return ESP_OK;
+	}
 
-		esp_mqtt_client_publish(this->mqttClient, this->mqttTopicLog.c_str(), payload.c_str(), 0, 1, 1);
+	// clients don't need to send anything, but we have to read the frame to keep the stream in sync
+	httpd_ws_frame_t frame = {};
+	esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+	if (ret != ESP_OK)
+	{
+		return ret;
 	}
-}
 
-void BrewEngine::stopWebserver(httpd_handle_t server)
-{
-	// Stop the httpd server
-	httpd_stop(server);
-}
+	if (frame.len > 0)
+	{
+		uint8_t buf[128];
+		if (frame.len > sizeof(buf))
+		{
+			ESP_LOGW(TAG, "Websocket frame of %zu bytes ignored", frame.len);
+			return ESP_FAIL;
+		}
 
-esp_err_t BrewEngine::indexGetHandler(httpd_req_t *req)
-{
-	// ESP_LOGI(TAG, "index_get_handler");
-	extern const unsigned char index_html_start[] asm("_binary_index_html_gz_start");
-	extern const unsigned char index_html_end[] asm("_binary_index_html_gz_end");
-	const size_t index_html_size = (index_html_end - index_html_start);
-	httpd_resp_set_type(req, "text/html");
-	httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
-	httpd_resp_send(req, (const char *)index_html_start, index_html_size);
+		frame.payload = buf;
+		ret = httpd_ws_recv_frame(req, &frame, frame.len);
+	}
 
-	return ESP_OK;
+	return ret;
 }
 
-esp_err_t BrewEngine::logoGetHandler(httpd_req_t *req)
+struct WsMessage
 {
-	extern const unsigned char logo_svg_file_start[] asm("_binary_logo_svg_gz_start");
-	extern const unsigned char logo_svg_file_end[] asm("_binary_logo_svg_gz_end");
-	const size_t logo_svg_file_size = (logo_svg_file_end - logo_svg_file_start);
-	httpd_resp_set_type(req, "image/svg+xml");
-	httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
-	httpd_resp_send(req, (const char *)logo_svg_file_start, logo_svg_file_size);
-
-	return ESP_OK;
-}
+	httpd_handle_t server;
+	string payload;
+	vector<int> fds;
+};
 
-esp_err_t BrewEngine::manifestGetHandler(httpd_req_t *req)
+// runs in the httpd task, the only place where we may write to its sockets
+void BrewEngine::wsSendWork(void *arg)
 {
-	extern const unsigned char manifest_json_file_start[] asm("_binary_manifest_json_start");
-	extern const unsigned char manifest_json_file_end[] asm("_binary_manifest_json_end");
-	const size_t manifest_json_file_size = (manifest_json_file_end - manifest_json_file_start);
-	httpd_resp_set_type(req, "application/json");
-	httpd_resp_send(req, (const char *)manifest_json_file_start, manifest_json_file_size);
+	WsMessage *message = (WsMessage *)arg;
 
-	return ESP_OK;
+	httpd_ws_frame_t frame = {};
+	frame.final = true;
+	frame.type = HTTPD_WS_TYPE_TEXT;
+	frame.payload = (uint8_t *)message->payload.c_str();
+	frame.len = message->payload.length();
+
+	for (int fd : message->fds)
+	{
+		if (httpd_ws_send_frame_async(message->server, fd, &frame) != ESP_OK)
+		{
+			ESP_LOGW(TAG, "Websocket send to socket %d failed, closing", fd);
+			httpd_sess_trigger_close(message->server, fd);
+		}
+	}
+
+	delete message;
 }
 
-esp_err_t BrewEngine::otherGetHandler(httpd_req_t *req)
+// the message is serialized once, no matter how many clients there are
+void BrewEngine::wsBroadcast(const json &jMessage, const vector<int> &fds)
 {
-	httpd_resp_set_status(req, "307 Temporary Redirect");
-	httpd_resp_set_hdr(req, "Location", "/");
-	httpd_resp_send(req, "<html><body>Wrong</body></html>", 0); // Response body can be empty
+	if (fds.empty())
+	{
+		return;
+	}
 
-	return ESP_OK;
+	WsMessage *message = new WsMessage();
+	message->server = this->server;
+	message->payload = jMessage.dump();
+	message->fds = fds;
+
+	if (httpd_queue_work(this->server, &this->wsSendWork, message) != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Unable to queue websocket message");
+		delete message;
+	}
 }
 
-esp_err_t BrewEngine::apiPostHandler(httpd_req_t *req)
+// Single publisher for all websocket clients: new clients get a full snapshot of the Data fields,
+// after that only the fields that changed and the new temperature log samples are sent.
+void BrewEngine::pushLoop(void *arg)
 {
-	string stringBuffer;
-	char buf[256];
-	uint32_t ret;
-	uint32_t remaining = req->content_len;
+	BrewEngine *instance = (BrewEngine *)arg;
 
-	while (remaining > 0)
+	json lastData = json::object();
+	time_t lastPushedLog = 0;
+	int64_t lastSystemInfo = 0;
+
+	while (instance->run)
 	{
-		// Read the data
-		int nBytes = (std::min<uint32_t>)(remaining, sizeof(buf));
+		vTaskDelay(pdMS_TO_TICKS(WS_PUSH_INTERVAL_MS));
 
-		if ((ret = httpd_req_recv(req, buf, nBytes)) <= 0)
+		size_t fdCount = HTTPD_MAX_OPEN_SOCKETS;
+		int fds[HTTPD_MAX_OPEN_SOCKETS];
+		if (httpd_get_client_list(instance->server, &fdCount, fds) != ESP_OK)
 		{
-			if (ret == HTTPD_SOCK_ERR_TIMEOUT)
+			continue;
+		}
+
+		vector<int> subscribers;
+		vector<int> newSubscribers;
+		for (size_t i = 0; i < fdCount; i++)
+		{
+			if (httpd_ws_get_fd_info(instance->server, fds[i]) != HTTPD_WS_CLIENT_WEBSOCKET)
 			{
-				// Timeout, just continue
 				continue;
 			}
 
-			return ESP_FAIL;
+			if (std::find(instance->wsClients.begin(), instance->wsClients.end(), fds[i]) != instance->wsClients.end())
+			{
+				subscribers.push_back(fds[i]);
+			}
+			else
+			{
+				newSubscribers.push_back(fds[i]);
+			}
 		}
 
-		size_t bytes_read = ret;
+		instance->wsClients = subscribers;
+		instance->wsClients.insert(instance->wsClients.end(), newSubscribers.begin(), newSubscribers.end());
 
-		remaining -= bytes_read;
+		// log samples newer than what was pushed, clients get the history once with the Data command
+		size_t logSize = instance->tempLog.size();
+		json jTempLog = json::array({});
+		time_t logTime;
+		float logTemperature;
 
-		// append to buffer
-		stringBuffer.append((char *)buf, bytes_read);
-	}
+		// the log started over after a clock step back, everything in it is new
+		if (logSize > 0 && instance->tempLog.timeAt(logSize - 1) < lastPushedLog)
+		{
+			lastPushedLog = 0;
+		}
 
-	string commandResult = mainInstance->processCommand(stringBuffer);
+		for (size_t i = instance->tempLog.findAfter(lastPushedLog); i < logSize && instance->tempLog.read(i, logTime, logTemperature); i++)
+		{
+			jTempLog.push_back({
+				{"time", logTime},
+				{"temp", (double)((int)(logTemperature * 10)) / 10},
+			});
+			lastPushedLog = logTime;
+		}
 
-	const char *returnBuf = commandResult.c_str();
-	httpd_resp_set_type(req, "text/plain");
-	httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-	httpd_resp_sendstr(req, returnBuf);
+		if (instance->wsClients.empty())
+		{
+			lastData = json::object();
+			continue;
+		}
 
-	return ESP_OK;
+		json current = instance->getData(json::object(), false);
+
+		if (!newSubscribers.empty())
+		{
+			json jSnapshot;
+			jSnapshot["data"] = current;
+			jSnapshot["data"]["tempLog"] = json::array({});
+			jSnapshot["snapshot"] = true;
+			instance->wsBroadcast(jSnapshot, newSubscribers);
+		}
+
+		int64_t now = esp_timer_get_time();
+		bool pushSystemInfo = (now - lastSystemInfo) > (int64_t)WS_SYSTEMINFO_INTERVAL_S * 1000000;
+
+		json delta = json::object();
+		for (auto &[key, value] : current.items())
+		{
+			if (key == "systemInfo" && !pushSystemInfo)
+			{
+				continue;
+			}
+
+			if (!lastData.contains(key) || lastData[key] != value)
+			{
+				delta[key] = value;
+			}
+		}
+
+		if (!jTempLog.empty())
+		{
+			delta["tempLog"] = jTempLog;
+		}
+
+		if (!delta.empty() && !subscribers.empty())
+		{
+			json jDelta;
+			jDelta["data"] = delta;
+			jDelta["snapshot"] = false;
+			instance->wsBroadcast(jDelta, subscribers);
+		}
+
+		if (pushSystemInfo)
+		{
+			lastSystemInfo = now;
+		}
+		else if (lastData.contains("systemInfo"))
+		{
+			current["systemInfo"] = lastData["systemInfo"];
+		}
+
+		lastData = current;
+	}
+
+	vTaskDelete(NULL);
 }
 
 // needed for cors
@@ -9,6 +9,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #include "esp_log.h"
 #include <esp_http_server.h>
@@ -32,6 +34,7 @@
 #include <ranges>
 #include <map>
 #include <vector>
+#include <memory>
 
 #include "onewire_bus.h"
 #include "ds18b20.h"
@@ -40,8 +43,22 @@
 #include "mqtt_client.h"
 
 #include "pidController.hpp"
+#include "sample-buffer.hpp"
+#include "thermal-model.hpp"
+#include "temp-log.hpp"
+#include "schedule-edits.hpp"
+#include "perf-stats.hpp"
+#include "kettle-simulator.hpp"
+#include "kettle-controller.hpp"
+#include "power-budget.hpp"
+#include "ntc-table.hpp"
+#include "chunked-writer.hpp"
+#include "object-pool.hpp"
+#include "api-commands.hpp"
+#include "web-assets.h"
 
 #include "heater.h"
+#include "vessel.h"
 
 #include "mash-schedule.h"
 #include "execution-step.h"
@@ -54,7 +71,45 @@
 #include "nlohmann_json.hpp"
 
 #define ONEWIRE_MAX_DS18B20 10
+#define ONEWIRE_CMD_SKIP_ROM 0xCC
+#define DS18B20_CMD_CONVERT_T 0x44
 #define MAX_RTD_SENSORS 5
+#define MAX_NTC_SENSORS 10
+#define MAX_VESSELS 4
+#define MAX_HEATERS 10
+#define MAX_TEMP_SENSORS (ONEWIRE_MAX_DS18B20 + MAX_RTD_SENSORS + MAX_NTC_SENSORS)
+
+// every bus task owns its own range of sample slots
+#define ONEWIRE_SLOT_BASE 0
+#define RTD_SLOT_BASE (ONEWIRE_SLOT_BASE + ONEWIRE_MAX_DS18B20)
+#define NTC_SLOT_BASE (RTD_SLOT_BASE + MAX_RTD_SENSORS)
+#define SIM_SLOT (NTC_SLOT_BASE + MAX_NTC_SENSORS) // simulated kettle, only filled in simulation mode
+#define MAX_SAMPLE_SLOTS (SIM_SLOT + 1)
+#define SIM_SENSOR_ID 0x51300000
+#define SIM_STEP_MS 500
+#define CONTROL_POLL_MS 1000          // boost and overtime follow the temperature, so those are still polled
+#define SCHEDULER_MAX_WAIT_MS 30000   // deadlines are wall clock, a time sync can move them
+#define SAMPLE_MAX_AGE_US 5000000 // samples older than 5s are not used for control
+
+#define OUTPUT_TICK_US 10000 // time proportional output resolution
+#define TEMPLOG_SIZE 2400      // 4 bytes per sample, at 10s a bit more than 6.5 hours
+#define TEMPLOG_INTERVAL_S 10
+#define AUTOTUNE_MAX_TIME_S 10800 // 3 hours
+#define PID_SAMPLE_TIME_MS 1000 // pid runs at this rate, independent of the output window (pidLoopTime)
+#define HTTPD_MAX_OPEN_SOCKETS 6 // websocket clients keep their socket open
+#define API_MAX_BODY 16384 // largest /api request, a big imported schedule is well below this
+#define WS_PUSH_INTERVAL_MS 1000
+#define WS_SYSTEMINFO_INTERVAL_S 10 // heap usage changes all the time, we only push it now and then
+#define MQTT_TELEMETRY_INTERVAL_MS 1000
+#define MQTT_HEARTBEAT_S 60 // unchanged values are still republished at this interval
+#define MQTT_DIAGNOSTICS_INTERVAL_S 60
+#define PERF_MAX_TASKS 32 // tasks reported by GetPerf
+#define FIREBASE_QUEUE_LENGTH 120  // at the default 10s interval 20 minutes of samples survive an outage
+#define FIREBASE_BATCH_SIZE 10     // samples per PATCH
+#define FIREBASE_BATCH_WINDOW_S 30 // a batch is sent when it is full or its oldest sample is this old
+#define FIREBASE_BACKOFF_MAX_S 300
+#define SCHEDULE_EDIT_LOG_SIZE 16 // schedule edits kept for clients that ask for the difference
+#define CHECKPOINT_MAX_AGE_S 3600 // a run that was interrupted longer ago is not offered for resume
 
 enum TemperatureScale
 {
@@ -62,6 +117,12 @@ enum TemperatureScale
     Fahrenheit = 1
 };
 
+enum OutputMode
+{
+    TimeProportional = 0, // heaters are on for burnTime % of the pid window
+    BurstFire = 1         // on/off per full mains cycle, evenly spread, for zero-cross SSRs
+};
+
 enum BoostStatus
 {
     Off = 0,
@@ -75,21 +136,41 @@ using std::cout;
 using std::endl;
 using json = nlohmann::json;
 
+// One temperature record for the firebase uplink, copied into a FreeRTOS queue so it has to stay trivially copyable
+struct FirebaseSample
+{
+    time_t timestamp;
+    float temperature;
+    float targetTemperature;
+    uint8_t pidOutput;
+    char status[24];
+};
+
 class BrewEngine
 {
 private:
     static void readLoop(void *arg);
+    static void onewireReadLoop(void *arg);
+    static void rtdReadLoop(void *arg);
+    static void ntcReadLoop(void *arg);
     static void pidLoop(void *arg);
-    static void outputLoop(void *arg);
-    static void controlLoop(void *arg);
-    static void stirLoop(void *arg);
+    static void outputTimerCallback(void *arg);
+    static void schedulerLoop(void *arg);
+    static void autoTuneLoop(void *arg);
     static void reboot(void *arg);
     static void factoryReset(void *arg);
-    static void buzzer(void *arg);
+    static void sensorDetectTask(void *arg);
+    static void networkInitTask(void *arg);
+    static void simulationLoop(void *arg);
+    static void vesselLoop(void *arg);
 
     void readTempSensorSettings();
     void detectOnewireTemperatureSensors();
+    void restoreOnewireTemperatureSensors();
     void initOneWire();
+    uint16_t startOnewireConversion();
+    void publishTemperature(size_t slot, TemperatureSensor *sensor, float temperature, bool valid);
+    void clearSamples(size_t from, size_t to);
     void detectRtdTemperatureSensors();
     void initRtdSensors();
     void initNtcTemperatureSensors();
@@ -97,36 +178,69 @@ private:
     bool reinitializeRtdSensor(TemperatureSensor *sensor);
     void initMqtt();
     void initHeaters();
+    uint enableHeaters();
+    int setHeaterOutput(int outputPercent, uint totalWattage, uint8_t vessel = 0);
+    void applyPowerBudget();
+    void releaseHeaters(uint8_t vessel);
+    void startOutputTimer();
+    void stopOutputTimer();
     void readSystemSettings();
+    json readJsonSetting(const string &name, const json &defaultValue);
     void readSettings();
     void saveMashSchedules();
-    void setMashSchedule(const json &jSchedule);
+    string setMashSchedule(const json &jSchedule);
+    void releaseMashSchedule(MashSchedule *schedule);
     void savePIDSettings();
-    void saveSystemSettingsJson(const json &config);
+    void readThermalModel();
+    void saveThermalModel();
+    string saveSystemSettingsJson(const json &config);
     void addDefaultMash();
-    void start();
-    void loadSchedule();
+    bool start(bool resume = false);
+    void loadSchedule(float startTemperature);
+    void saveCheckpoint();
+    void clearCheckpoint();
+    bool restoreCheckpoint(const json &jCheckpoint);
     void recalculateScheduleAfterOverTime();
     void stop();
     void logRemote(const string &message);
     void addDefaultHeaters();
     void readHeaterSettings();
     void saveHeaterSettings(const json &jHeaters);
+    void readVesselSettings();
+    void saveVesselSettings(const json &jVessels);
+    void assignVessels();
+    bool vesselsRunning();
+    string startVessel(const json &config);
+    string stopVessel(const json &config);
 
     void saveTempSensorSettings(const json &jTempSensors);
     void startStir(const json &stirConfig);
     void stopStir();
+    void wakeScheduler();
+    uint32_t runControl();
+    uint32_t runStir();
+    uint32_t runBuzzer();
+    void buzz();
     string bootIntoRecovery();
+    string startAutoTune(const json &config);
 
-    string processCommand(const string &payLoad);
+    json getData(const json &data, bool withTempLog);
+    json getPerf();
+    string startSimulation(const json &config);
+    string stopSimulation();
+    string processCommand(const string &command, json data);
+    string processCommand(ApiCommand command, json data);
+    bool streamCommand(httpd_req_t *req, ApiCommand command, const json &data);
 
     httpd_handle_t startWebserver(void);
     void stopWebserver(httpd_handle_t server);
-    static esp_err_t indexGetHandler(httpd_req_t *req);
-    static esp_err_t logoGetHandler(httpd_req_t *req);
-    static esp_err_t manifestGetHandler(httpd_req_t *req);
-    static esp_err_t otherGetHandler(httpd_req_t *req);
+    static esp_err_t assetGetHandler(httpd_req_t *req);
     static esp_err_t apiPostHandler(httpd_req_t *req);
+    static esp_err_t wsHandler(httpd_req_t *req);
+    static esp_err_t exportGetHandler(httpd_req_t *req);
+    static void wsSendWork(void *arg);
+    static void pushLoop(void *arg);
+    void wsBroadcast(const json &jMessage, const vector<int> &fds);
     static esp_err_t apiOptionsHandler(httpd_req_t *req);
 
     // small helpers
@@ -135,13 +249,17 @@ private:
     SettingsManager *settingsManager;
     StatisticsManager *statisticsManager;
     httpd_handle_t server;
+    char apiBuffer[API_MAX_BODY]; // receive buffer of /api, allocated once with the engine
+    vector<int> wsClients; // websocket sockets that already received a full snapshot, only used by pushLoop
 
     TemperatureScale temperatureScale = Celsius;
     float temperature = 0;                                         // average temp, we use float beceasue ds18b20_get_temperature returns float, no point in going more percise
+    bool temperatureValid = false;                                 // false while no control sensor gives a reading, temperature then holds the last average
     float targetTemperature = 0;                                   // requested temp
     std::optional<float> overrideTargetTemperature = std::nullopt; // manualy overwritten temp
-    std::map<uint64_t, float> currentTemperatures;                 // map with last temp for each sensor
-    std::map<time_t, int8_t> tempLog;                              // integer log of averages, only used to show running history on web
+    SampleBuffer<MAX_SAMPLE_SLOTS> samples;                        // last temp for each sensor, written by the bus tasks
+    std::unique_ptr<NtcTable> ntcTables[MAX_NTC_SENSORS];          // conversion per NTC slot, only used by the ntc task
+    TempLog<TEMPLOG_SIZE> tempLog;                                 // log of averages, only used to show running history on web
     // sensorTempLogs removed - will fetch from database instead to save memory
 
     // pid
@@ -162,13 +280,43 @@ private:
 
     uint8_t boostModeUntil = 85;
 
+    ThermalModel thermalModel; // learned kettle model, used for feed-forward on ramps
+    float targetSlope = 0;     // °/s of the running ramp, set by the control loop
+
+    // autotune
+    bool autoTuneRun = false;
+    float autoTuneTarget = 0;
+    float autoTuneHysteresis = 0.5;
+    uint8_t autoTuneOutput = 100; // relay output in %
+    uint8_t autoTuneCycles = 3;   // measured oscillations
+    string autoTuneRule = "TL";   // TL: Tyreus-Luyben, ZN: Ziegler-Nichols
+
     // execution
     bool run = false;
     bool controlRun = false;   // true when a program is running
     bool boilRun = false;      // true when a boil schedule  is running
-    bool skipTempLoop = false; // When we are changing temp settings we temporarily need to skip our temp loop
+    int64_t bootStartedAt = 0; // esp_timer time when Init started, used for the boot timing log
+    bool firstSampleLogged = false;
+    PerfStats perf;
+    int64_t lastOutputTickAt = 0;
+    int64_t outputPeriodUs = OUTPUT_TICK_US; // period the output timer was started with, burst fire ticks per mains cycle
+
+    // simulation, heaters are never switched and the simulated kettle is the only control sensor
+    bool simulation = false;
+    bool simulationTaskRunning = false;
+    KettleSimulator simulator;
+    ThermalModel thermalModelBackup; // the real kettle model, the simulation must not train it
     BoostStatus boostStatus;   // Status of boost
 
+    // scheduler, one task for the schedule, stir and buzzer deadlines
+    TaskHandle_t schedulerHandle = NULL;
+    bool scheduleRun = false;       // the schedule of the running program is followed
+    bool resetPidNextStep = false;  // the pid needs to reset one step later so the next temp is set, oherwise it has a delay
+    float boostPrevTemperature = 0; // for boost mode to see if temp starts to drop
+    uint boostUntil = 0;
+    bool buzzerRequested = false;
+    int64_t buzzerOffAt = 0;        // esp_timer time, 0 when silent
+
     bool inOverTime = false; // when a step time isn't reached we go in overtime, we need this to know that we need recalcualtion
 
     string statusText = "Idle";
@@ -176,17 +324,43 @@ private:
     string selectedMashScheduleName;
     uint16_t currentMashStep;
 
-    std::map<uint16_t, ExecutionStep *> executionSteps; // calculated real steps
+    std::vector<ExecutionStep> executionSteps; // calculated real steps, the index is the step number
     uint16_t currentExecutionStep = 0;
     uint16_t stepInterval = 60;  // calcualte a substep every x seconds
     uint16_t runningVersion = 0; // we increase our version after recalc, so client can keep uptodate with planning
+    ScheduleEditLog<SCHEDULE_EDIT_LOG_SIZE> scheduleEdits;
+    json resumeCheckpoint;       // checkpoint of a run that was interrupted by a reset, offered to the user
 
     // IO
     uint8_t gpioHigh = 1;
     uint8_t gpioLow = 0;
+
+    // output
+    OutputMode outputMode = TimeProportional;
+    uint8_t mainsFrequency = 50;           // Hz, used for the burst fire cycle
+    esp_timer_handle_t outputTimer = nullptr;
+    uint32_t outputTick = 0;               // position in the current time proportional window
     bool invertOutputs;
 
-    std::vector<Heater *> heaters; // we support up to 10 heaters
+    std::vector<Heater *> heaters; // we support up to MAX_HEATERS heaters
+
+    // fixed storage for everything that is rebuilt when settings are saved, so editing them can't fragment the heap
+    ObjectPool<TemperatureSensor, MAX_TEMP_SENSORS> sensorPool;
+    ObjectPool<max31865_t, MAX_RTD_SENSORS> rtdPool;
+    ObjectPool<Heater, MAX_HEATERS> heaterPool;
+    ObjectPool<MashSchedule, MAX_MASH_SCHEDULES + 1> schedulePool; // +1, a replaced schedule is freed after the new one is built
+    MashStepPool stepPool;
+    NotificationPool notificationPool;
+    RunningNotificationPool runningNotificationPool; // the copy in notifications, a run never competes with the saved schedules
+
+    // vessels next to the main kettle, they share the heaters budget with it
+    std::vector<Vessel *> vessels;
+    bool vesselLoopRunning = false;
+    uint16_t maxPower = 0;                                 // W that may be on at the same time, 0 is no limit
+    portMUX_TYPE powerLock = portMUX_INITIALIZER_UNLOCKED; // guards the requested and granted burn times
+    PowerBudget powerBudget;                               // layout of the on windows, only used under powerLock
+    portMUX_TYPE filterLock = portMUX_INITIALIZER_UNLOCKED; // guards the sensor filters, settings swap them while the bus tasks filter
+    uint32_t peakPower = 0;                                // W, highest simultaneous load the output timer switched
 
     gpio_num_t oneWire_PIN;
     gpio_num_t stir_PIN;
@@ -217,6 +391,11 @@ private:
     esp_mqtt_client_handle_t mqttClient;
     string mqttTopic = "";
     string mqttTopicLog = "";
+    string mqttTopicTelemetry = "";
+    string mqttTopicDiagnostics = "";
+    uint8_t mqttDeadband = 2;      // in tenths of a degree, smaller changes are not published
+    uint16_t mqttMinInterval = 5;  // seconds between two publishes of the same field
+    static void mqttTelemetryLoop(void *arg);
 
     // Firebase
     bool firebaseEnabled = false;
@@ -245,13 +424,17 @@ private:
     bool isCustomTokenExpired();
     static esp_err_t http_event_handler(esp_http_client_event_t *evt);
     esp_err_t writeTemperatureToFirebase(float temperature, float targetTemperature, uint8_t pidOutput, const string &status);
+    void queueFirebaseSample(float temperature, float targetTemperature, uint8_t pidOutput, const string &status);
+    esp_http_client_handle_t createFirebaseClient();
+    esp_err_t patchFirebaseTemperatures(esp_http_client_handle_t client, const FirebaseSample *batch, size_t count);
+    static void firebaseUplinkLoop(void *arg);
+    QueueHandle_t firebaseQueue = NULL;
     esp_err_t queryLatestTemperatureFromFirebase(float *temperature, time_t *timestamp);
     esp_err_t queryTemperatureSeriesFromFirebase(int limit);
     json getFirebaseStatistics(const json &requestData);
     json getFirebaseSessionData(const json &requestData);
 
     // stirring/pumping
-    TaskHandle_t stirLoopHandle = NULL;
     string stirStatusText = "Idle";
     bool stirRun = false;
     uint16_t stirTimeSpan = 10; // stir timespan in minutes
@@ -262,6 +445,7 @@ private:
     // one wire
     onewire_bus_handle_t obh;
     std::map<uint64_t, TemperatureSensor *> sensors; // map with sensor id and handle
+    SemaphoreHandle_t sensorsMutex;                  // recursive, guards the map and the bus handles, the bus tasks hold it while they read
 
 public:
     BrewEngine(SettingsManager *settingsManager); // constructor
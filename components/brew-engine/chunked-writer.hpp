@@ -0,0 +1,96 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_CHUNKEDWRITER_HPP_
+#define INCLUDE_CHUNKEDWRITER_HPP_
+
+#include <esp_http_server.h>
+#include <string>
+#include <cstring>
+
+#define CHUNKED_WRITER_BUFFER 1024
+
+using namespace std;
+
+// Collects small writes in a fixed buffer and sends them as http chunks, so a large response never has to be in memory
+class ChunkedWriter
+{
+
+private:
+    httpd_req_t *req;
+    char buffer[CHUNKED_WRITER_BUFFER];
+    size_t used = 0;
+    bool failed = false;
+
+public:
+    ChunkedWriter(httpd_req_t *req)
+    {
+        this->req = req;
+    }
+
+    void flush()
+    {
+        if (used == 0 || failed)
+        {
+            return;
+        }
+
+        if (httpd_resp_send_chunk(req, buffer, used) != ESP_OK)
+        {
+            // client is gone, we just drop the rest
+            failed = true;
+        }
+        used = 0;
+    }
+
+    void write(const char *data, size_t length)
+    {
+        while (length > 0 && !failed)
+        {
+            size_t space = sizeof(buffer) - used;
+            size_t part = (length < space) ? length : space;
+
+            memcpy(buffer + used, data, part);
+            used += part;
+            data += part;
+            length -= part;
+
+            if (used == sizeof(buffer))
+            {
+                flush();
+            }
+        }
+    }
+
+    void write(const char *data)
+    {
+        write(data, strlen(data));
+    }
+
+    void write(const string &data)
+    {
+        write(data.c_str(), data.length());
+    }
+
+    // flushes the buffer and ends the chunked response
+    esp_err_t finish()
+    {
+        flush();
+
+        if (failed)
+        {
+            return ESP_FAIL;
+        }
+
+        return httpd_resp_send_chunk(req, NULL, 0);
+    }
+
+    bool hasFailed()
+    {
+        return failed;
+    }
+};
+
+#endif // INCLUDE_CHUNKEDWRITER_HPP_
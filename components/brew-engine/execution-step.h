@@ -12,11 +12,18 @@ class ExecutionStep
 {
 public:
     system_clock::time_point time;
-    float temperature;
-    bool extendIfNeeded;
-    bool allowBoost;
+    float temperature = 0;
+    bool extendIfNeeded = false;
+    bool allowBoost = false;
 
-    json to_json()
+    ExecutionStep() = default;
+
+    ExecutionStep(system_clock::time_point time, float temperature, bool extendIfNeeded = false, bool allowBoost = false)
+        : time(time), temperature(temperature), extendIfNeeded(extendIfNeeded), allowBoost(allowBoost)
+    {
+    }
+
+    json to_json() const
     {
         auto seconds = std::chrono::duration_cast<std::chrono::seconds>(this->time.time_since_epoch()).count();
 
@@ -2,6 +2,7 @@
 #define _Heater_H_
 
 #include "nlohmann_json.hpp"
+#include "inline-string.hpp"
 
 using namespace std;
 using json = nlohmann::json;
@@ -10,7 +11,7 @@ class Heater
 {
 public:
     uint8_t id;
-    string name;
+    InlineString<MAX_NAME_LENGTH> name;
     uint8_t preference;
     gpio_num_t pinNr;
     uint16_t watt;
@@ -19,6 +20,10 @@ public:
     uint8_t burnTime; // runtime burn Time flag, doesn't go to json, in %
     bool burn;        // runtime burn flag true means burn now
     bool enabled;     // runtime flag to make it easyer to filter in loops, is set based on mode and mash/boil
+    uint8_t burstAccumulator; // runtime accumulator for burst fire output, in %
+    uint8_t requestedBurnTime = 0; // runtime, what the vessel asks for, burnTime is what the power budget grants
+    uint8_t vessel = 0;       // runtime, the vessel that owns this heater, 0 is the main kettle
+    uint8_t phaseOffset = 0;  // runtime, where in the window (%) the on time starts, so heaters take turns
 
     json to_json()
     {
@@ -71,6 +76,10 @@ public:
         this->burnTime = 0;
         this->burn = false;
         this->enabled = false;
+        this->burstAccumulator = 0;
+        this->requestedBurnTime = 0;
+        this->vessel = 0;
+        this->phaseOffset = 0;
     };
 
 protected:
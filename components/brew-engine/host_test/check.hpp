@@ -0,0 +1,29 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef HOST_TEST_CHECK_HPP_
+#define HOST_TEST_CHECK_HPP_
+
+#include <cstdio>
+#include <cmath>
+
+// Minimal checks for the host tests, a failed check is printed and makes the test return 1
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                              \
+    do                                                                                \
+    {                                                                                 \
+        if (!(condition))                                                             \
+        {                                                                             \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++;                                                          \
+        }                                                                             \
+    } while (0)
+
+#define CHECK_NEAR(value, expected, margin) CHECK(std::fabs((double)(value) - (double)(expected)) <= (margin))
+
+#define CHECK_RESULT() (checkFailures == 0 ? 0 : 1)
+
+#endif /* HOST_TEST_CHECK_HPP_ */
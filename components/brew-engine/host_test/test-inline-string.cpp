@@ -0,0 +1,45 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include "check.hpp"
+#include "inline-string.hpp"
+
+using json = nlohmann::json;
+
+int main()
+{
+    InlineString<8> empty;
+    CHECK(empty.empty());
+    CHECK(empty == "");
+
+    InlineString<8> name("Mash");
+    CHECK(name.size() == 4);
+    CHECK(name == "Mash");
+    CHECK(name == std::string("Mash"));
+    CHECK(name != "Boil");
+    CHECK(name.str() == "Mash");
+    CHECK(("Step " + name) == "Step Mash");
+    CHECK((name + " in") == "Mash in");
+
+    // too long is cut at the capacity
+    name = std::string("Lautering");
+    CHECK(name.size() == 8);
+    CHECK(name == "Lauterin");
+
+    // never in the middle of a multibyte character, "é" is 2 bytes and doesn't fit in byte 6
+    name = "Brouwé dag";
+    CHECK(name == "Brouwé ");
+    InlineString<6> accent("Brouwé");
+    CHECK(accent.size() == 5);
+    CHECK(accent == "Brouw");
+
+    // json round trip
+    json jName = InlineString<MAX_NAME_LENGTH>("Hop stand");
+    CHECK(jName.is_string() && jName == "Hop stand");
+    InlineString<MAX_NAME_LENGTH> parsed = json("Whirlpool").get<InlineString<MAX_NAME_LENGTH>>();
+    CHECK(parsed == "Whirlpool");
+
+    return CHECK_RESULT();
+}
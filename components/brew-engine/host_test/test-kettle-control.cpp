@@ -0,0 +1,123 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include <chrono>
+#include "check.hpp"
+#include "kettle-controller.hpp"
+#include "kettle-simulator.hpp"
+
+struct Rest
+{
+    double temperature;
+    double holdSeconds; // counted from reaching the temperature
+};
+
+// Brews a mash schedule on the simulated kettle with the controller of the pid task, in simulated time.
+// The pid runs every second like on the device, the kettle is stepped at the rate of the firmware simulation.
+static json brew(ThermalModel &model, double &simulatedSeconds)
+{
+    const Rest schedule[] = {{65, 3600}, {72, 900}, {78, 600}};
+    const double watt = 3500;
+    const double pidInterval = 1;
+    const double simStep = 0.5;
+
+    KettleSimulator simulator;
+    simulator.volume = 25;
+    simulator.lossPerK = 8;
+    simulator.settleMargin = 0.5;
+    simulator.reset(20);
+    model.ambient = simulator.ambient;
+
+    // same defaults as the firmware mash pid
+    KettleController controller(10, 1, 10, 60, watt, false, model);
+
+    double time = 0;
+    for (const Rest &rest : schedule)
+    {
+        double reachedAt = -1;
+        while (reachedAt < 0 || time - reachedAt < rest.holdSeconds)
+        {
+            int output = controller.compute(simulator.sensorTemperature, rest.temperature, 0, pidInterval, false);
+            controller.applied(output);
+
+            for (double t = 0; t < pidInterval; t += simStep)
+            {
+                simulator.step(watt * output / 100, simStep);
+                simulator.track(rest.temperature, simStep);
+            }
+            time += pidInterval;
+
+            if (reachedAt < 0 && simulator.waterTemperature >= rest.temperature - simulator.settleMargin)
+            {
+                reachedAt = time;
+            }
+
+            // a broken controller never gets there, don't hang the test
+            if (time > 6 * 3600)
+            {
+                simulatedSeconds = time;
+                return simulator.to_json();
+            }
+        }
+    }
+
+    simulatedSeconds = time;
+    return simulator.to_json();
+}
+
+int main()
+{
+    ThermalModel model;
+    double simulatedSeconds = 0;
+
+    auto started = std::chrono::steady_clock::now();
+    json first = brew(model, simulatedSeconds);
+    json second = brew(model, simulatedSeconds);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    double speedUp = (2 * simulatedSeconds) / std::max(wallSeconds, 1e-6);
+
+    printf("untrained model: %s\n", first.dump().c_str());
+    printf("trained model:   %s\n", second.dump().c_str());
+    printf("thermal model: gain %.5f loss %.6f samples %u\n", model.gain, model.loss, model.samples);
+    printf("simulated %.0fs per brew, %.0fx real time\n", simulatedSeconds, speedUp);
+
+    // the benchmark must stay well above 1000x real time to be usable for comparing settings
+    CHECK(speedUp >= 1000);
+    CHECK(simulatedSeconds < 6 * 3600);
+
+    // the model learns the kettle: 1 / heat capacity in °/s per kW and the loss over heat capacity
+    CHECK(model.isValid());
+    CHECK_NEAR(model.gain, 1 / (25 * 4.186), 0.001);
+    CHECK_NEAR(model.loss, 8 / (25 * 4186.0), 0.00002);
+
+    // control quality of the current settings, loosen these only on purpose
+    CHECK((double)first["maxOvershoot"] < 2.5);
+    CHECK((double)second["maxOvershoot"] < 2.5);
+    CHECK((double)second["maxOvershoot"] <= (double)first["maxOvershoot"] + 0.1);
+    CHECK((double)first["meanAbsError"] < 6);
+    CHECK((double)second["meanAbsError"] < 6);
+
+    // after a pause without temperature the pid takes over from the heaters being off
+    KettleController controller(10, 1, 10, 60, 3500, false, model);
+    controller.compute(60, 65, 0, 1, false);
+    controller.applied(0);
+    controller.pause();
+    CHECK(!controller.inControl());
+    int output = controller.compute(60, 65, 0, 1, false);
+    CHECK(controller.inControl());
+    CHECK(output >= 0 && output <= 100);
+
+    // the power budget grants less than asked, the pid continues from the grant instead of winding up
+    KettleController limited(10, 1, 10, 60, 3500, true, model); // boil, no feed-forward from the model
+    for (int i = 0; i < 6000; i++)
+    {
+        int asked = limited.compute(64, 65, 0, 1, false);
+        limited.applied(std::min(asked, 20));
+    }
+    CHECK(limited.compute(64, 65, 0, 1, false) < 25);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,56 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include "check.hpp"
+#include "ntc-table.hpp"
+
+// adc without a calibration, linear over the supply
+static float linearMillivolts(int raw)
+{
+    return raw * NTC_SUPPLY_MV / NTC_ADC_MAX;
+}
+
+int main()
+{
+    // equal resistors give half the supply at 25°C
+    CHECK_NEAR(NtcTable::temperatureFromMillivolts(NTC_SUPPLY_MV / 2, 10000, 10000), 25, 0.01);
+    CHECK(std::isnan(NtcTable::temperatureFromMillivolts(NTC_SUPPLY_MV, 10000, 10000)));
+
+    NtcTable table;
+    CHECK(!table.valid);
+
+    table.build(10000, 10000, false, linearMillivolts);
+    CHECK(table.valid);
+    CHECK(table.matches(10000, 10000, false));
+    CHECK(!table.matches(10000, 4700, false));
+    CHECK(!table.matches(10000, 10000, true));
+
+    float temperature = 0;
+    CHECK(table.lookup(2047.5, temperature) == NtcOk);
+    CHECK_NEAR(temperature, 25, 0.1);
+
+    // the table follows the beta equation within the error it reports
+    CHECK(table.maxError < 0.5);
+    for (int raw = 100; raw < 3800; raw += 7)
+    {
+        float exact = NtcTable::temperatureFromMillivolts(linearMillivolts(raw), 10000, 10000);
+        if (exact < NTC_MIN_TEMP || exact > NTC_MAX_TEMP)
+        {
+            continue;
+        }
+
+        CHECK(table.lookup(raw, temperature) == NtcOk);
+        CHECK_NEAR(temperature, exact, table.maxError + 0.01);
+    }
+
+    // faults at both ends of the divider
+    CHECK(table.lookup(0, temperature) == NtcShort);
+    CHECK(table.lookup(NTC_ADC_MAX, temperature) == NtcOpen);
+
+    // a reading past the range the table knows
+    CHECK(table.lookup(40, temperature) == NtcOutOfRange);
+
+    return CHECK_RESULT();
+}
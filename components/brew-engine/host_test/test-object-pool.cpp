@@ -0,0 +1,91 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "object-pool.hpp"
+
+struct Counted
+{
+    static int alive;
+    int value;
+
+    Counted(int value) : value(value) { alive++; }
+    ~Counted() { alive--; }
+};
+int Counted::alive = 0;
+
+int main()
+{
+    ObjectPool<Counted, 3> pool;
+    CHECK(pool.capacity() == 3);
+    CHECK(pool.inUse() == 0);
+
+    Counted *a = pool.create(1);
+    Counted *b = pool.create(2);
+    Counted *c = pool.create(3);
+    CHECK(a != nullptr && b != nullptr && c != nullptr);
+    CHECK(a->value == 1 && c->value == 3);
+    CHECK(Counted::alive == 3);
+
+    // full, the caller reports it
+    CHECK(pool.create(4) == nullptr);
+    CHECK(Counted::alive == 3);
+
+    // destroy runs the destructor and frees the slot for the next object
+    CHECK(pool.destroy(b));
+    CHECK(Counted::alive == 2);
+    CHECK(pool.inUse() == 2);
+    Counted *d = pool.create(5);
+    CHECK(d == b && d->value == 5);
+
+    // pointers that aren't ours are left alone
+    Counted outside(6);
+    CHECK(!pool.owns(&outside));
+    CHECK(!pool.destroy(&outside));
+    CHECK(!pool.destroy(nullptr));
+    CHECK(!pool.owns((Counted *)((char *)a + 1)));
+
+    pool.destroy(a);
+    pool.destroy(c);
+    pool.destroy(d);
+    CHECK(pool.inUse() == 0);
+
+    // creating and destroying from several threads never hands out a slot twice
+    ObjectPool<int, 64> shared;
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&shared, &failures, t]() {
+            for (int i = 0; i < 10000; i++)
+            {
+                int *value = shared.create(t);
+                if (value == nullptr)
+                {
+                    continue;
+                }
+                if (*value != t)
+                {
+                    failures++;
+                }
+                *value = t;
+                if (*value != t || !shared.destroy(value))
+                {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    CHECK(failures == 0);
+    CHECK(shared.inUse() == 0);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,126 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include <cstdlib>
+#include <vector>
+#include "check.hpp"
+#include "power-budget.hpp"
+
+struct TestHeater
+{
+    uint16_t watt;
+    uint8_t requested;
+    PowerGrant grant;
+};
+
+static void layout(PowerBudget &budget, uint32_t maxPower, std::vector<TestHeater> &heaters)
+{
+    budget.reset(maxPower);
+    for (auto &heater : heaters)
+    {
+        heater.grant = budget.place(heater.watt, heater.requested, -1);
+    }
+}
+
+// runs the window like the output timer and checks every grant is switched on completely without passing maxPower
+static bool deliverable(const std::vector<TestHeater> &heaters, uint32_t maxPower, uint32_t windowTicks)
+{
+    std::vector<uint32_t> onTicks(heaters.size(), 0);
+
+    for (uint32_t tick = 0; tick < windowTicks; tick++)
+    {
+        uint32_t watt = 0;
+        for (size_t i = 0; i < heaters.size(); i++)
+        {
+            if (PowerBudget::burns(tick, windowTicks, heaters[i].grant.phase, heaters[i].grant.burnTime))
+            {
+                watt += heaters[i].watt;
+                onTicks[i]++;
+            }
+        }
+
+        if (maxPower > 0 && watt > maxPower)
+        {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < heaters.size(); i++)
+    {
+        if (onTicks[i] != windowTicks * heaters[i].grant.burnTime / POWER_SLOTS)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    PowerBudget budget;
+
+    // two 2000W elements on a 3000W supply can't be on together, the second gets nothing instead of a grant the timer vetoes
+    std::vector<TestHeater> full = {{2000, 100, {}}, {2000, 100, {}}};
+    layout(budget, 3000, full);
+    CHECK(full[0].grant.burnTime == 100 && full[0].grant.phase == 0);
+    CHECK(full[1].grant.burnTime == 0);
+    CHECK(deliverable(full, 3000, 6000));
+
+    // they take turns in the window instead
+    std::vector<TestHeater> turns = {{2000, 60, {}}, {2000, 60, {}}};
+    layout(budget, 3000, turns);
+    CHECK(turns[0].grant.burnTime == 60 && turns[0].grant.phase == 0);
+    CHECK(turns[1].grant.burnTime == 40 && turns[1].grant.phase == 60);
+    CHECK(deliverable(turns, 3000, 6000));
+
+    // elements that fit together overlap freely
+    std::vector<TestHeater> small = {{1000, 100, {}}, {1500, 100, {}}};
+    layout(budget, 3000, small);
+    CHECK(small[0].grant.burnTime == 100 && small[1].grant.burnTime == 100);
+    CHECK(deliverable(small, 3000, 6000));
+
+    // without a limit everything is granted, spread so the peak stays low
+    std::vector<TestHeater> unlimited = {{2000, 60, {}}, {2000, 60, {}}};
+    layout(budget, 0, unlimited);
+    CHECK(unlimited[0].grant.burnTime == 60 && unlimited[1].grant.burnTime == 60);
+    CHECK(unlimited[1].grant.phase >= 40 && unlimited[1].grant.phase <= 60); // 20% overlap is the least there is
+
+    // a running window stays where it is when that is as good as the best spot
+    budget.reset(0);
+    budget.place(2000, 62, -1);
+    PowerGrant sticky = budget.place(2000, 60, 60);
+    CHECK(sticky.burnTime == 60 && sticky.phase == 60);
+
+    // unknown wattage can't be budgeted and takes no room
+    budget.reset(3000);
+    PowerGrant unknown = budget.place(0, 80, -1);
+    CHECK(unknown.burnTime == 80);
+    CHECK(budget.place(3000, 100, -1).burnTime == 100);
+
+    // any mix of heaters, requests and limits is delivered as granted
+    srand(1);
+    for (int run = 0; run < 2000; run++)
+    {
+        std::vector<TestHeater> heaters;
+        size_t count = 1 + rand() % 5;
+        for (size_t i = 0; i < count; i++)
+        {
+            heaters.push_back({(uint16_t)(500 + rand() % 3000), (uint8_t)(rand() % 101), {}});
+        }
+        uint32_t maxPower = (rand() % 4 == 0) ? 0 : 1000 + rand() % 6000;
+
+        layout(budget, maxPower, heaters);
+
+        bool ok = deliverable(heaters, maxPower, 6000) && deliverable(heaters, maxPower, POWER_SLOTS);
+        for (auto const &heater : heaters)
+        {
+            ok = ok && heater.grant.burnTime <= heater.requested;
+        }
+        CHECK(ok);
+    }
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,45 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include "check.hpp"
+#include "sample-buffer.hpp"
+
+static TemperatureSample sample(uint64_t sensorId, float temperature)
+{
+    TemperatureSample result{};
+    result.sensorId = sensorId;
+    result.temperature = temperature;
+    result.valid = true;
+    result.weight = 1;
+    return result;
+}
+
+int main()
+{
+    SampleBuffer<4> buffer;
+    TemperatureSample read{};
+
+    // empty slots are not in use
+    CHECK(!buffer.read(0, read));
+
+    buffer.publish(1, sample(42, 65.5));
+    CHECK(buffer.read(1, read));
+    CHECK(read.sensorId == 42);
+    CHECK_NEAR(read.temperature, 65.5, 0.001);
+
+    // the last write wins
+    buffer.publish(1, sample(42, 66));
+    CHECK(buffer.read(1, read));
+    CHECK_NEAR(read.temperature, 66, 0.001);
+
+    buffer.clear(1);
+    CHECK(!buffer.read(1, read));
+
+    // out of range is ignored
+    buffer.publish(4, sample(7, 1));
+    CHECK(!buffer.read(4, read));
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,57 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include "check.hpp"
+#include "schedule-edits.hpp"
+
+int main()
+{
+    ScheduleEditLog<3> log;
+    std::vector<ScheduleEdit> edits;
+
+    // nothing changed since the rebuild
+    log.reset(10);
+    CHECK(log.since(10, edits));
+    CHECK(edits.empty());
+
+    log.add(11, 2, 60);
+    log.add(12, 3, 30);
+
+    // a client at the base version gets every edit, oldest first
+    CHECK(log.since(10, edits));
+    CHECK(edits.size() == 2);
+    CHECK(edits[0].version == 11 && edits[0].fromStep == 2 && edits[0].shift == 60);
+    CHECK(edits[1].version == 12);
+
+    // a client in between only gets what it missed
+    CHECK(log.since(11, edits));
+    CHECK(edits.size() == 1 && edits[0].version == 12);
+
+    CHECK(log.since(12, edits));
+    CHECK(edits.empty());
+
+    // clients from before the rebuild need the full schedule
+    CHECK(!log.since(9, edits));
+
+    // when full the oldest edit falls out and its base version is no longer served
+    log.add(13, 3, 10);
+    log.add(14, 4, 10);
+    CHECK(!log.since(10, edits));
+    CHECK(log.since(11, edits));
+    CHECK(edits.size() == 3 && edits[0].version == 12 && edits[2].version == 14);
+
+    // versions wrap at 16 bit
+    log.reset(65534);
+    log.add(65535, 1, 5);
+    log.add(0, 1, 5);
+    log.add(1, 2, 5);
+    CHECK(log.since(65534, edits));
+    CHECK(edits.size() == 3 && edits[0].version == 65535 && edits[2].version == 1);
+    CHECK(log.since(0, edits));
+    CHECK(edits.size() == 1 && edits[0].version == 1);
+    CHECK(!log.since(65533, edits));
+
+    return CHECK_RESULT();
+}
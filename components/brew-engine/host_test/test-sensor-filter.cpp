@@ -0,0 +1,64 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include "check.hpp"
+#include "sensor-filter.hpp"
+
+int main()
+{
+    // without settings a reading goes through unchanged
+    SensorFilter none;
+    CHECK_NEAR(none.apply(20), 20, 1e-6);
+    CHECK_NEAR(none.apply(25), 25, 1e-6);
+
+    // the median throws out a single spike
+    SensorFilter median;
+    median.medianWindow = 3;
+    median.sanitize();
+    median.apply(60);
+    median.apply(60);
+    CHECK_NEAR(median.apply(85), 60, 1e-6);
+    CHECK_NEAR(median.apply(60.5), 60.5, 1e-6);
+
+    // ema moves by alpha of the difference
+    SensorFilter ema;
+    ema.type = FilterEma;
+    ema.alpha = 0.5;
+    ema.sanitize();
+    CHECK_NEAR(ema.apply(20), 20, 1e-6);
+    CHECK_NEAR(ema.apply(30), 25, 1e-6);
+    CHECK_NEAR(ema.apply(30), 27.5, 1e-6);
+
+    // kalman converges on a constant and is less noisy than the readings
+    SensorFilter kalman;
+    kalman.type = FilterKalman;
+    kalman.sanitize();
+    float estimate = 0;
+    for (int i = 0; i < 200; i++)
+    {
+        estimate = kalman.apply((i % 2 == 0) ? 64.5 : 65.5);
+    }
+    CHECK_NEAR(estimate, 65, 0.2);
+
+    // reset starts over from the next reading
+    kalman.reset();
+    CHECK_NEAR(kalman.apply(20), 20, 1e-6);
+
+    // bad settings are brought back in range
+    SensorFilter bad;
+    bad.medianWindow = 50;
+    bad.type = (SensorFilterType)9;
+    bad.alpha = 0;
+    bad.processNoise = -1;
+    bad.measurementNoise = NAN;
+    bad.sanitize();
+    CHECK(bad.medianWindow == SENSOR_FILTER_MAX_MEDIAN);
+    CHECK(bad.type == FilterNone);
+    CHECK_NEAR(bad.alpha, 0.3, 1e-6);
+    CHECK(bad.processNoise > 0);
+    CHECK(bad.measurementNoise > 0);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,126 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include <atomic>
+#include <thread>
+#include "check.hpp"
+#include "temp-log.hpp"
+
+int main()
+{
+    TempLog<4> log;
+    CHECK(log.size() == 0);
+    CHECK(log.findAfter(0) == 0);
+
+    // samples come back oldest first, rounded to tenths
+    log.add(1000, 20.04);
+    log.add(1010, 21.06);
+    log.add(1020, NAN);
+    CHECK(log.size() == 2);
+    CHECK(log.timeAt(0) == 1000);
+    CHECK_NEAR(log.temperatureAt(0), 20.0, 0.001);
+    CHECK(log.timeAt(1) == 1010);
+    CHECK_NEAR(log.temperatureAt(1), 21.1, 0.001);
+
+    // when full the oldest samples are overwritten
+    log.add(1020, 22);
+    log.add(1030, 23);
+    log.add(1040, 24);
+    CHECK(log.size() == 4);
+    CHECK(log.timeAt(0) == 1010);
+    CHECK(log.timeAt(3) == 1040);
+
+    CHECK(log.findAfter(1000) == 0);
+    CHECK(log.findAfter(1020) == 2);
+    CHECK(log.findAfter(1040) == 4);
+
+    // moving the base forward drops the samples from before it instead of keeping them at the base time
+    TempLog<8> rebased;
+    rebased.add(0, 20);
+    rebased.add(20000, 30);
+    rebased.add(40000, 40);
+    rebased.add(60001, 50); // base moves to 30001
+    CHECK(rebased.size() == 2);
+    CHECK(rebased.timeAt(0) == 40000);
+    CHECK_NEAR(rebased.temperatureAt(0), 40, 0.001);
+    CHECK(rebased.timeAt(1) == 60001);
+
+    // all samples too old
+    TempLog<8> stale;
+    stale.add(0, 20);
+    stale.add(70000, 30);
+    CHECK(stale.size() == 1);
+    CHECK(stale.timeAt(0) == 70000);
+
+    // rebase on a wrapped buffer
+    TempLog<4> wrapped;
+    for (time_t time = 0; time <= 60000; time += 10000)
+    {
+        wrapped.add(time, time / 1000);
+    }
+    wrapped.add(60010, 61); // base moves to 30010, only 40000 and later are kept
+    CHECK(wrapped.size() == 4);
+    CHECK(wrapped.timeAt(0) == 40000);
+    CHECK(wrapped.timeAt(3) == 60010);
+
+    // the first sntp sync jumps from 1970 to now, further than a rebase can follow
+    TempLog<8> synced;
+    synced.add(5, 20);
+    synced.add(10, 21);
+    synced.add(1700000000, 22);
+    CHECK(synced.size() == 1);
+    CHECK(synced.timeAt(0) == 1700000000);
+    CHECK_NEAR(synced.temperatureAt(0), 22, 0.001);
+
+    // a clock step back starts over, before and after the base
+    TempLog<8> stepped;
+    stepped.add(1000, 20);
+    stepped.add(1010, 21);
+    stepped.add(1005, 22);
+    CHECK(stepped.size() == 1);
+    CHECK(stepped.timeAt(0) == 1005);
+    stepped.add(500, 23);
+    CHECK(stepped.size() == 1);
+    CHECK(stepped.timeAt(0) == 500);
+
+    // clear is seen right away and carried out by the next add
+    log.clear();
+    CHECK(log.size() == 0);
+    time_t time;
+    float temperature;
+    CHECK(!log.read(0, time, temperature));
+    log.add(2000, 30);
+    CHECK(log.size() == 1);
+    CHECK(log.timeAt(0) == 2000);
+
+    // readers on other tasks never see a sample with a torn base while the writer rebases,
+    // the temperature tells what time the sample was written with
+    TempLog<16> shared;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::thread reader([&shared, &done, &torn]() {
+        while (!done.load())
+        {
+            for (size_t i = 0; i < shared.size(); i++)
+            {
+                time_t readTime;
+                float readTemperature;
+                if (shared.read(i, readTime, readTemperature) && lroundf(readTemperature * 10) != (long)(readTime % 1000))
+                {
+                    torn++;
+                }
+            }
+        }
+    });
+    for (time_t written = 0; written < 500000000; written += 997)
+    {
+        shared.add(written, (float)(written % 1000) / 10);
+    }
+    done = true;
+    reader.join();
+    CHECK(torn.load() == 0);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,79 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#include <limits>
+#include "check.hpp"
+#include "thermal-model.hpp"
+
+// feed the model a first order kettle with known parameters, one sample per second
+static double simulate(ThermalModel &model, double temperature, double seconds, double gain, double loss)
+{
+    for (int i = 0; i < seconds; i++)
+    {
+        // alternate the power so both parameters can be told apart
+        double power = ((i / 120) % 2 == 0) ? 2.0 : 0.5;
+        model.update(power, temperature, 1);
+        temperature += gain * power - loss * (temperature - model.ambient);
+    }
+    return temperature;
+}
+
+int main()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    // learns the parameters of the kettle
+    ThermalModel model;
+    CHECK(!model.isValid());
+    simulate(model, 20, 3600, 0.02, 0.0005);
+    CHECK(model.isValid());
+    CHECK_NEAR(model.gain, 0.02, 0.002);
+    CHECK_NEAR(model.loss, 0.0005, 0.0002);
+
+    // nan input is skipped and doesn't poison what was learned
+    uint32_t samples = model.samples;
+    model.update(nan, 60, 1);
+    model.update(1, nan, 1);
+    model.update(1, 60, nan);
+    simulate(model, 60, 60, 0.02, 0.0005);
+    CHECK(std::isfinite(model.gain) && std::isfinite(model.loss));
+    CHECK(model.samples >= samples);
+    CHECK(std::isfinite(model.requiredPower(0.01, 65)));
+
+    // reset forgets everything but ambient
+    model.ambient = 18;
+    model.reset();
+    CHECK(!model.isValid());
+    CHECK(model.samples == 0);
+    CHECK(model.ambient == 18);
+
+    // round trip through json
+    ThermalModel learned;
+    simulate(learned, 20, 3600, 0.02, 0.0005);
+    ThermalModel restored;
+    restored.from_json(learned.to_json());
+    CHECK(restored.samples == learned.samples);
+    CHECK_NEAR(restored.gain, learned.gain, 1e-12);
+    CHECK_NEAR(restored.loss, learned.loss, 1e-12);
+
+    // a stored model with missing or wrong fields is ignored
+    json stored = learned.to_json();
+    stored["loss"] = "0.1";
+    ThermalModel wrongType;
+    wrongType.from_json(stored);
+    CHECK(wrongType.samples == 0 && wrongType.gain == 0);
+
+    stored = learned.to_json();
+    stored.erase("p22");
+    ThermalModel missing;
+    missing.from_json(stored);
+    CHECK(missing.samples == 0 && missing.gain == 0);
+
+    ThermalModel notObject;
+    notObject.from_json(json::array());
+    CHECK(notObject.samples == 0);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,94 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_INLINESTRING_HPP_
+#define INCLUDE_INLINESTRING_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include "nlohmann_json.hpp"
+
+#define MAX_NAME_LENGTH 32
+#define MAX_COLOR_LENGTH 9 // #rrggbbaa
+
+// Fixed capacity string stored in the object itself, for names and colors of pooled objects.
+// Longer values are cut at Capacity characters (on a utf-8 character boundary), so it never allocates.
+template <size_t Capacity>
+class InlineString
+{
+
+private:
+    char data[Capacity + 1] = {};
+    uint8_t length = 0;
+
+    static_assert(Capacity <= 255, "length is stored in a byte");
+
+public:
+    InlineString() = default;
+    InlineString(const char *value) { assign(value, strlen(value)); }
+    InlineString(const std::string &value) { assign(value.data(), value.size()); }
+
+    InlineString &operator=(const char *value)
+    {
+        assign(value, strlen(value));
+        return *this;
+    }
+
+    InlineString &operator=(const std::string &value)
+    {
+        assign(value.data(), value.size());
+        return *this;
+    }
+
+    void assign(const char *value, size_t size)
+    {
+        if (size > Capacity)
+        {
+            size = Capacity;
+            // don't leave half a multibyte character
+            while (size > 0 && ((uint8_t)value[size] & 0xC0) == 0x80)
+            {
+                size--;
+            }
+        }
+
+        memcpy(data, value, size);
+        data[size] = '\0';
+        length = size;
+    }
+
+    const char *c_str() const { return data; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    std::string str() const { return std::string(data, length); }
+    operator std::string() const { return str(); }
+
+    bool operator==(const InlineString &other) const { return length == other.length && memcmp(data, other.data, length) == 0; }
+    bool operator!=(const InlineString &other) const { return !(*this == other); }
+    bool operator==(const std::string &other) const { return length == other.size() && memcmp(data, other.data(), length) == 0; }
+    bool operator!=(const std::string &other) const { return !(*this == other); }
+    bool operator==(const char *other) const { return strcmp(data, other) == 0; }
+    bool operator!=(const char *other) const { return !(*this == other); }
+
+    friend std::string operator+(const std::string &left, const InlineString &right) { return left + right.c_str(); }
+    friend std::string operator+(const char *left, const InlineString &right) { return std::string(left) + right.c_str(); }
+    friend std::string operator+(const InlineString &left, const std::string &right) { return left.str() + right; }
+    friend std::string operator+(const InlineString &left, const char *right) { return left.str() + right; }
+};
+
+template <size_t Capacity>
+void to_json(nlohmann::json &j, const InlineString<Capacity> &value)
+{
+    j = value.str();
+}
+
+template <size_t Capacity>
+void from_json(const nlohmann::json &j, InlineString<Capacity> &value)
+{
+    value = j.get_ref<const std::string &>();
+}
+
+#endif /* INCLUDE_INLINESTRING_HPP_ */
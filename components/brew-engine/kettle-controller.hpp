@@ -0,0 +1,105 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_KETTLECONTROLLER_HPP_
+#define INCLUDE_KETTLECONTROLLER_HPP_
+
+#include <algorithm>
+#include "pidController.hpp"
+#include "thermal-model.hpp"
+
+// One cycle of the kettle control: learn the thermal model from what was applied, feed-forward from the model and the pid
+// corrects on top. The clock, sensors and heaters stay with the caller (dt and temperature in, output % out), so the pid task
+// and the host simulation benchmark run the same code.
+class KettleController
+{
+
+private:
+    PIDController pid;
+    ThermalModel &model;
+    double totalWattage;
+    bool boil;
+    bool pidInControl = true;
+    int appliedPercent = 0;
+    int computedPercent = 0;
+    double lastTemperature = 0;
+    double lastTarget = 0;
+
+public:
+    // gains are tuned per pid loop (loopTime in seconds), totalWattage of the heaters that are enabled for this run
+    KettleController(double kP, double kI, double kD, double loopTime, double totalWattage, bool boil, ThermalModel &model)
+        : pid(kP, kI, kD), model(model), totalWattage(totalWattage), boil(boil)
+    {
+        pid.setMin(0);
+        pid.setMax(100);
+        pid.setTimeBase(loopTime);
+        pid.setDerivativeFilter(loopTime / 10.0); // ds18b20 steps of 0.0625° would otherwise give spikes
+        pid.debug = false;
+
+        // we calculate much faster than the output window, the first window starts with the first cycle
+        model.resetWindow();
+    }
+
+    // false while the output was overridden (manual output, boost), the next compute then takes over bumpless
+    bool inControl() const
+    {
+        return pidInControl;
+    }
+
+    // pid output in %, overridden tells that the caller applies something else, dt in seconds since the previous cycle
+    int compute(double temperature, double target, double targetSlope, double dt, bool overridden)
+    {
+        // learn the kettle from what we applied since the last run, not during boil, evaporation takes that power
+        if (!boil)
+        {
+            double appliedPower = (totalWattage * appliedPercent / 100) / 1000; // kW
+            model.update(appliedPower, temperature, dt);
+        }
+
+        // feed-forward, the power the model needs to follow the ramp and cover the losses, the pid only corrects
+        double feedForward = 0;
+        if (!boil && totalWattage > 0)
+        {
+            double requiredPower = model.requiredPower(targetSlope, target);
+            feedForward = std::clamp((requiredPower * 1000 / totalWattage) * 100, 0.0, 100.0);
+        }
+        pid.setFeedForward(feedForward);
+
+        // bumpless transfer, when control comes back we continue from the output that was applied
+        if (!overridden && !pidInControl)
+        {
+            pid.setOutput(appliedPercent, temperature, target);
+        }
+        pidInControl = !overridden;
+
+        lastTemperature = temperature;
+        lastTarget = target;
+        computedPercent = (int)pid.getOutput(temperature, target, dt);
+        return computedPercent;
+    }
+
+    // the heaters were off without the pid (no temperature), it takes over bumpless on the next compute
+    // and the model restarts its window as it didn't follow the kettle in between
+    void pause()
+    {
+        pidInControl = false;
+        model.resetWindow();
+    }
+
+    // the output that actually went to the heaters, the model learns from it on the next compute,
+    // when the power budget granted less than the pid asked the pid continues from that so its integral doesn't wind up
+    void applied(int outputPercent)
+    {
+        appliedPercent = outputPercent;
+
+        if (pidInControl && outputPercent < computedPercent)
+        {
+            pid.setOutput(outputPercent, lastTemperature, lastTarget);
+            computedPercent = outputPercent;
+        }
+    }
+};
+
+#endif /* INCLUDE_KETTLECONTROLLER_HPP_ */
@@ -0,0 +1,150 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_KETTLESIMULATOR_HPP_
+#define INCLUDE_KETTLESIMULATOR_HPP_
+
+#include "nlohmann_json.hpp"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+using json = nlohmann::json;
+
+// Simulated kettle to try control changes without water: a lumped heat capacity with losses to ambient,
+// a boil limit and a first order sensor lag. Also keeps the control quality figures of the run.
+// It has no hardware or rtos dependencies, so it can be stepped at any speed.
+class KettleSimulator
+{
+
+private:
+    double simTime = 0; // seconds since start
+
+    // control quality
+    double lastTarget = NAN;
+    bool rising = false;
+    double segmentStart = 0;
+    bool settled = false;
+    double absErrorTime = 0; // ° * s
+    double lagTime = 0;      // ° * s while the target is above us
+    double trackedTime = 0;
+
+public:
+    // plant
+    double volume = 20;      // liters, 1 liter is taken as 1 kg
+    double lossPerK = 8;     // W per ° above ambient
+    double ambient = 20;
+    double sensorLag = 10;   // seconds, time constant of the probe
+    double boilPoint = 100;
+
+    double waterTemperature = 20;
+    double sensorTemperature = 20;
+
+    // results
+    double maxOvershoot = 0;
+    double settlingTime = 0;    // of the last target change
+    double maxSettlingTime = 0;
+    double settleMargin = 0.5;
+
+    void reset(double startTemperature)
+    {
+        simTime = 0;
+        waterTemperature = startTemperature;
+        sensorTemperature = startTemperature;
+        lastTarget = NAN;
+        rising = false;
+        segmentStart = 0;
+        settled = false;
+        absErrorTime = 0;
+        lagTime = 0;
+        trackedTime = 0;
+        maxOvershoot = 0;
+        settlingTime = 0;
+        maxSettlingTime = 0;
+    }
+
+    // power in W, dt in seconds
+    void step(double power, double dt)
+    {
+        double heatCapacity = volume * 4186; // J per °
+        double losses = lossPerK * (waterTemperature - ambient);
+
+        waterTemperature += (power - losses) / heatCapacity * dt;
+
+        // at the boil the extra power goes into evaporation
+        waterTemperature = std::min(waterTemperature, boilPoint);
+
+        double alpha = (sensorLag > 0) ? std::min(1.0, dt / sensorLag) : 1.0;
+        sensorTemperature += (waterTemperature - sensorTemperature) * alpha;
+
+        simTime += dt;
+    }
+
+    // call after step with the target the controller was following
+    void track(double target, double dt)
+    {
+        if (std::isnan(lastTarget) || fabs(target - lastTarget) > 0.1)
+        {
+            rising = std::isnan(lastTarget) || target > lastTarget;
+            segmentStart = simTime;
+            settled = false;
+            lastTarget = target;
+        }
+
+        double error = waterTemperature - target;
+
+        if (rising && error > maxOvershoot)
+        {
+            maxOvershoot = error;
+        }
+
+        // settled once we stay within the margin, leaving it again restarts the count
+        if (fabs(error) <= settleMargin)
+        {
+            if (!settled)
+            {
+                settled = true;
+                settlingTime = simTime - segmentStart;
+                maxSettlingTime = std::max(maxSettlingTime, settlingTime);
+            }
+        }
+        else
+        {
+            settled = false;
+        }
+
+        absErrorTime += fabs(error) * dt;
+        if (error < 0)
+        {
+            lagTime += -error * dt;
+        }
+        trackedTime += dt;
+    }
+
+    json to_json()
+    {
+        json jSim;
+        jSim["timeS"] = (uint32_t)simTime;
+        jSim["water"] = waterTemperature;
+        jSim["sensor"] = sensorTemperature;
+        jSim["maxOvershoot"] = maxOvershoot;
+        jSim["settlingTimeS"] = settlingTime;
+        jSim["maxSettlingTimeS"] = maxSettlingTime;
+        jSim["meanAbsError"] = (trackedTime > 0) ? absErrorTime / trackedTime : 0;
+        jSim["meanLag"] = (trackedTime > 0) ? lagTime / trackedTime : 0;
+        return jSim;
+    }
+
+    void from_json(const json &jsonData)
+    {
+        this->volume = jsonData.value("volume", this->volume);
+        this->lossPerK = jsonData.value("lossPerK", this->lossPerK);
+        this->ambient = jsonData.value("ambient", this->ambient);
+        this->sensorLag = jsonData.value("sensorLag", this->sensorLag);
+        this->boilPoint = jsonData.value("boilPoint", this->boilPoint);
+    }
+};
+
+#endif /* INCLUDE_KETTLESIMULATOR_HPP_ */
@@ -5,6 +5,16 @@
 #include "nlohmann_json.hpp"
 #include "mash-step.h"
 #include "notification.h"
+#include "object-pool.hpp"
+
+#define MAX_MASH_SCHEDULES 10 // same as the web ui
+#define MAX_MASH_STEPS 128    // over all schedules
+#define MAX_NOTIFICATIONS 128 // over all schedules
+#define MAX_SCHEDULE_NOTIFICATIONS 32 // per schedule, the running program copies them into a pool of this size
+
+using MashStepPool = ObjectPool<MashStep, MAX_MASH_STEPS>;
+using NotificationPool = ObjectPool<Notification, MAX_NOTIFICATIONS>;
+using RunningNotificationPool = ObjectPool<Notification, MAX_SCHEDULE_NOTIFICATIONS>;
 
 using namespace std;
 using json = nlohmann::json;
@@ -50,8 +60,11 @@ public:
         return jSchedule;
     };
 
-    void from_json(const json &jsonData)
+    // false when the pools ran out, the steps and notifications that fit are kept
+    bool from_json(const json &jsonData, MashStepPool &stepPool, NotificationPool &notificationPool)
     {
+        bool complete = true;
+
         this->name = jsonData["name"];
 
         if (!jsonData["boil"].is_null() && jsonData["boil"].is_boolean())
@@ -78,7 +91,12 @@ public:
         {
             auto jStep = el.value();
 
-            auto step = new MashStep();
+            auto step = stepPool.create();
+            if (step == nullptr)
+            {
+                complete = false;
+                break;
+            }
             step->from_json(jStep);
             this->steps.push_back(step);
         }
@@ -91,13 +109,36 @@ public:
             {
                 auto jNotification = el.value();
 
-                auto notification = new Notification();
+                auto notification = (this->notifications.size() < MAX_SCHEDULE_NOTIFICATIONS) ? notificationPool.create() : nullptr;
+                if (notification == nullptr)
+                {
+                    complete = false;
+                    break;
+                }
                 notification->from_json(jNotification);
                 this->notifications.push_back(notification);
             }
         }
+
+        return complete;
     };
 
+    // gives the steps and notifications back to their pools
+    void clear(MashStepPool &stepPool, NotificationPool &notificationPool)
+    {
+        for (auto const &step : this->steps)
+        {
+            stepPool.destroy(step);
+        }
+        this->steps.clear();
+
+        for (auto const &notification : this->notifications)
+        {
+            notificationPool.destroy(notification);
+        }
+        this->notifications.clear();
+    }
+
     void sort_steps()
     {
         // sort our steps by index
@@ -2,6 +2,7 @@
 #define _MashStep_H_
 
 #include "nlohmann_json.hpp"
+#include "inline-string.hpp"
 using namespace std;
 using json = nlohmann::json;
 
@@ -9,7 +10,7 @@ class MashStep
 {
 public:
     uint index;
-    string name;
+    InlineString<MAX_NAME_LENGTH> name;
     int temperature;
     int stepTime;
     int time;
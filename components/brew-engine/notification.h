@@ -3,6 +3,7 @@
 
 #include <chrono>
 #include "nlohmann_json.hpp"
+#include "inline-string.hpp"
 
 using namespace std;
 using namespace std::chrono;
@@ -11,8 +12,8 @@ using json = nlohmann::json;
 class Notification
 {
 public:
-    string name;
-    string message;
+    InlineString<MAX_NAME_LENGTH> name;
+    string message; // free text, can be longer than a name
     int timeFromStart;
     system_clock::time_point timePoint;
     bool buzzer;
@@ -0,0 +1,146 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_NTCTABLE_HPP_
+#define INCLUDE_NTCTABLE_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+#define NTC_ADC_MAX 4095    // 12 bit oneshot
+#define NTC_TABLE_SHIFT 5   // one point every 32 adc codes
+#define NTC_TABLE_SIZE ((NTC_ADC_MAX >> NTC_TABLE_SHIFT) + 2)
+#define NTC_SUPPLY_MV 3300.0f
+#define NTC_BETA 3950.0f
+#define NTC_MIN_TEMP -40.0f
+#define NTC_MAX_TEMP 150.0f
+
+enum NtcResult : uint8_t
+{
+    NtcOk,
+    NtcShort,      // voltage too low
+    NtcOpen,       // voltage too high, disconnected
+    NtcOutOfRange, // outside NTC_MIN_TEMP - NTC_MAX_TEMP
+};
+
+// Temperature per adc code of one NTC, built once from the calibration, divider and Beta equation,
+// so a reading is a lookup and a linear interpolation instead of a calibration call and a logf.
+class NtcTable
+{
+
+private:
+    float temperatures[NTC_TABLE_SIZE];
+    float shortBelow = 0; // adc codes at or below this are a short
+    float openAbove = 0;  // adc codes at or above this are an open circuit
+
+    float ntcResistance = 0;
+    float dividerResistor = 0;
+    bool calibrated = false;
+
+public:
+    bool valid = false;
+    float maxError = 0; // largest interpolation error found between the points, °C
+
+    // Voltage divider: 3.3V -> NTC -> analogPin -> dividerResistor -> GND, Beta equation with T0 = 25°C
+    static float temperatureFromMillivolts(float millivolts, float ntcResistance, float dividerResistor)
+    {
+        float resistance = ((NTC_SUPPLY_MV - millivolts) * dividerResistor) / millivolts;
+        if (!(resistance > 0))
+        {
+            return NAN;
+        }
+
+        float kelvin = 1.0f / ((1.0f / 298.15f) + (1.0f / NTC_BETA) * logf(resistance / ntcResistance));
+        return kelvin - 273.15f;
+    }
+
+    bool matches(float ntcResistance, float dividerResistor, bool calibrated) const
+    {
+        return valid && this->ntcResistance == ntcResistance && this->dividerResistor == dividerResistor && this->calibrated == calibrated;
+    }
+
+    // toMillivolts converts a raw adc code, the adc calibration when we have one
+    template <typename ToMillivolts>
+    void build(float ntcResistance, float dividerResistor, bool calibrated, ToMillivolts toMillivolts)
+    {
+        this->ntcResistance = ntcResistance;
+        this->dividerResistor = dividerResistor;
+        this->calibrated = calibrated;
+
+        shortBelow = -1;
+        openAbove = NTC_ADC_MAX + 1;
+
+        // the calibration is monotonic, so the fault limits are a single adc code each
+        for (int raw = 0; raw <= NTC_ADC_MAX; raw++)
+        {
+            float millivolts = toMillivolts(raw);
+            if (millivolts <= 10.0f)
+            {
+                shortBelow = raw;
+            }
+            if (millivolts >= NTC_SUPPLY_MV * 0.95f)
+            {
+                openAbove = raw;
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < NTC_TABLE_SIZE; i++)
+        {
+            int raw = std::min((int)(i << NTC_TABLE_SHIFT), NTC_ADC_MAX);
+            temperatures[i] = temperatureFromMillivolts(toMillivolts(raw), ntcResistance, dividerResistor);
+        }
+
+        // compare halfway between the points, where linear interpolation is off the most
+        maxError = 0;
+        for (size_t i = 0; i + 1 < NTC_TABLE_SIZE; i++)
+        {
+            int raw = (i << NTC_TABLE_SHIFT) + (1 << (NTC_TABLE_SHIFT - 1));
+            if (raw <= shortBelow || raw >= openAbove || raw > NTC_ADC_MAX)
+            {
+                continue;
+            }
+
+            float exact = temperatureFromMillivolts(toMillivolts(raw), ntcResistance, dividerResistor);
+            float interpolated = (temperatures[i] + temperatures[i + 1]) / 2;
+            if (exact >= NTC_MIN_TEMP && exact <= NTC_MAX_TEMP && !std::isnan(interpolated))
+            {
+                maxError = std::max(maxError, fabsf(exact - interpolated));
+            }
+        }
+
+        valid = true;
+    }
+
+    // raw is the (averaged) adc code
+    NtcResult lookup(float raw, float &temperature) const
+    {
+        if (raw <= shortBelow)
+        {
+            return NtcShort;
+        }
+        if (raw >= openAbove)
+        {
+            return NtcOpen;
+        }
+
+        float position = raw / (1 << NTC_TABLE_SHIFT);
+        size_t index = std::min((size_t)position, (size_t)NTC_TABLE_SIZE - 2);
+        float fraction = position - index;
+
+        temperature = temperatures[index] + (temperatures[index + 1] - temperatures[index]) * fraction;
+
+        if (std::isnan(temperature) || temperature < NTC_MIN_TEMP || temperature > NTC_MAX_TEMP)
+        {
+            return NtcOutOfRange;
+        }
+
+        return NtcOk;
+    }
+};
+
+#endif /* INCLUDE_NTCTABLE_HPP_ */
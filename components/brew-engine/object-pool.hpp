@@ -0,0 +1,87 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_OBJECTPOOL_HPP_
+#define INCLUDE_OBJECTPOOL_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Fixed storage for up to N objects of T, allocated once with its owner. Objects that are rebuilt on every settings
+// save come from here instead of the heap, so editing settings can't fragment it. Slots are claimed with an atomic flag,
+// so the bus tasks and the http handler can create and destroy at the same time without a lock.
+template <typename T, size_t N>
+class ObjectPool
+{
+
+private:
+    alignas(T) uint8_t storage[N][sizeof(T)];
+    std::atomic<bool> used[N] = {};
+
+public:
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    // nullptr when the pool is full, the caller decides how to report that
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            bool expected = false;
+            if (used[i].compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                return new (storage[i]) T(std::forward<Args>(args)...);
+            }
+        }
+
+        return nullptr;
+    }
+
+    // returns false for a pointer that isn't ours, it is then left alone
+    bool destroy(T *object)
+    {
+        if (!owns(object))
+        {
+            return false;
+        }
+
+        size_t index = ((uint8_t *)object - storage[0]) / sizeof(T);
+        object->~T();
+        used[index].store(false, std::memory_order_release);
+
+        return true;
+    }
+
+    bool owns(const T *object) const
+    {
+        const uint8_t *address = (const uint8_t *)object;
+        return object != nullptr && address >= storage[0] && address < storage[0] + sizeof(storage) && (address - storage[0]) % sizeof(T) == 0;
+    }
+
+    size_t inUse() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            if (used[i].load(std::memory_order_relaxed))
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+};
+
+#endif /* INCLUDE_OBJECTPOOL_HPP_ */
@@ -0,0 +1,143 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_PERFSTATS_HPP_
+#define INCLUDE_PERFSTATS_HPP_
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "nlohmann_json.hpp"
+#include <cstdint>
+#include <cstring>
+
+using json = nlohmann::json;
+
+enum PerfProbe : uint8_t
+{
+    PerfOnewireRead,  // scratchpad read of one DS18B20
+    PerfRtdRead,      // one MAX31865 measurement
+    PerfNtcRead,      // one adc oneshot read
+    PerfPidCompute,   // one pid iteration including the heater split
+    PerfPidLate,      // how much later than planned the pid iteration started
+    PerfOutputUpdate, // output timer callback, gpio updates included
+    PerfOutputLate,   // deviation of the output tick from its period
+    PerfHttpRequest,  // one /api request
+    PerfNvsWrite,     // settings write including the nvs commit
+    PerfFirebaseSend, // one Firebase PATCH
+    PerfMqttSend,     // one telemetry publish cycle
+    PerfProbeCount,
+};
+
+static const char *const PerfProbeNames[PerfProbeCount] = {
+    "onewireRead", "rtdRead", "ntcRead", "pidCompute", "pidLate", "outputUpdate",
+    "outputLate", "httpRequest", "nvsWrite", "firebaseSend", "mqttSend",
+};
+
+#define PERF_BUCKETS 12
+
+// Fixed bucket histograms in microseconds, one per probe point, cheap enough for the output timer.
+// Buckets: <50us <100us <200us <500us <1ms <2ms <5ms <10ms <20ms <50ms <100ms and the rest.
+class PerfStats
+{
+
+private:
+    struct Histogram
+    {
+        uint32_t buckets[PERF_BUCKETS];
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t totalUs;
+    };
+
+    static constexpr uint32_t upperBounds[PERF_BUCKETS - 1] = {50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000};
+
+    Histogram histograms[PerfProbeCount] = {};
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+public:
+    void record(PerfProbe probe, int64_t durationUs)
+    {
+        uint32_t us = (durationUs < 0) ? 0 : (durationUs > UINT32_MAX) ? UINT32_MAX : (uint32_t)durationUs;
+
+        size_t bucket = 0;
+        while (bucket < PERF_BUCKETS - 1 && us >= upperBounds[bucket])
+        {
+            bucket++;
+        }
+
+        // the output timer records from the esp_timer task, so a spinlock instead of a mutex
+        portENTER_CRITICAL(&lock);
+        Histogram &histogram = histograms[probe];
+        histogram.buckets[bucket]++;
+        histogram.count++;
+        histogram.totalUs += us;
+        if (us > histogram.maxUs)
+        {
+            histogram.maxUs = us;
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+
+    void reset()
+    {
+        portENTER_CRITICAL(&lock);
+        memset(histograms, 0, sizeof(histograms));
+        portEXIT_CRITICAL(&lock);
+    }
+
+    json to_json()
+    {
+        Histogram copy[PerfProbeCount];
+
+        portENTER_CRITICAL(&lock);
+        memcpy(copy, histograms, sizeof(copy));
+        portEXIT_CRITICAL(&lock);
+
+        json jProbes = json::object();
+        for (size_t i = 0; i < PerfProbeCount; i++)
+        {
+            if (copy[i].count == 0)
+            {
+                continue;
+            }
+
+            jProbes[PerfProbeNames[i]] = {
+                {"count", copy[i].count},
+                {"avgUs", (uint32_t)(copy[i].totalUs / copy[i].count)},
+                {"maxUs", copy[i].maxUs},
+                {"buckets", copy[i].buckets},
+            };
+        }
+
+        return jProbes;
+    }
+
+    static json bucketBounds()
+    {
+        return upperBounds;
+    }
+};
+
+// Records the time from construction to destruction
+class PerfTimer
+{
+
+private:
+    PerfStats &stats;
+    PerfProbe probe;
+    int64_t startedAt;
+
+public:
+    PerfTimer(PerfStats &stats, PerfProbe probe) : stats(stats), probe(probe), startedAt(esp_timer_get_time())
+    {
+    }
+
+    ~PerfTimer()
+    {
+        stats.record(probe, esp_timer_get_time() - startedAt);
+    }
+};
+
+#endif /* INCLUDE_PERFSTATS_HPP_ */
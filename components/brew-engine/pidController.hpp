@@ -27,6 +27,14 @@ private:
 
     bool firstRun = true;
 
+    // state of the dt aware variant, terms are kept in output units
+    double integralTerm = 0;
+    double derivativeTerm = 0;
+    double timeBase = 1;     // seconds the gains are expressed in, the original loop time
+    double filterTime = 0;   // first order derivative filter, seconds
+    double trackingTime = 0; // back-calculation time constant, seconds, 0 means timeBase
+    double feedForward = 0;  // added before clamping, so anti-windup sees the total output
+
     void addToIntegral(double i)
     {
         double newIntegral = integral + i;
@@ -67,6 +75,87 @@ public:
         this->min = min;
     }
 
+    // Gains are tuned per pid loop, setting the loop time here keeps them valid when running at a higher rate
+    void setTimeBase(double seconds)
+    {
+        if (seconds > 0)
+        {
+            this->timeBase = seconds;
+        }
+    }
+
+    void setDerivativeFilter(double seconds)
+    {
+        this->filterTime = seconds;
+    }
+
+    void setTrackingTime(double seconds)
+    {
+        this->trackingTime = seconds;
+    }
+
+    void setFeedForward(double output)
+    {
+        this->feedForward = output;
+    }
+
+    // Bumpless transfer, continue from the output that was applied while we were not in control
+    void setOutput(double output, double actual, double setpoint)
+    {
+        double error = setpoint - actual;
+
+        integralTerm = clamp(output - feedForward - kp * error, min, max);
+        derivativeTerm = 0;
+        previousActual = actual;
+        previousError = error;
+
+        this->firstRun = false;
+    }
+
+    // dt aware variant: derivative on measurement with a first order filter and back-calculation anti-windup, dt in seconds
+    double getOutput(double actual, double setpoint, double dt)
+    {
+        double error = setpoint - actual;
+
+        if (dt < 0)
+        {
+            dt = 0;
+        }
+
+        // Proportional
+        double p = kp * error;
+
+        // Derivative on measurement, a setpoint change doesn't kick
+        if (this->firstRun || filterTime + dt <= 0)
+        {
+            derivativeTerm = 0;
+        }
+        else
+        {
+            double kdPerSecond = kd * timeBase;
+            derivativeTerm = (filterTime * derivativeTerm - kdPerSecond * (actual - previousActual)) / (filterTime + dt);
+        }
+        previousActual = actual;
+        previousError = error;
+
+        double unclamped = feedForward + p + integralTerm + derivativeTerm;
+        double output = clamp(unclamped, min, max);
+
+        // Integral, the /2 keeps it in line with the tunings of the original variant
+        double tracking = (trackingTime > 0) ? trackingTime : timeBase;
+        integralTerm += (ki / 2) * error * (dt / timeBase) + (output - unclamped) * (dt / tracking);
+        integralTerm = clamp(integralTerm, min, max);
+
+        if (debug)
+        {
+            cout << "p:" + to_string(p) + " i:" + to_string(integralTerm) + " d:" + to_string(derivativeTerm) + " output:" + to_string(output) + "\n";
+        }
+
+        this->firstRun = false;
+
+        return output;
+    }
+
     double getOutput(double actual, double setpoint)
     {
         previousActual = actual;
@@ -0,0 +1,127 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_POWERBUDGET_HPP_
+#define INCLUDE_POWERBUDGET_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#define POWER_SLOTS 100 // the output window is budgeted in slots of 1%, the unit of burnTime
+
+struct PowerGrant
+{
+    uint8_t burnTime; // % of the window, one contiguous on window
+    uint8_t phase;    // % of the window where it starts, it wraps around the end
+};
+
+// Lays the on windows of the heaters out over the slots of the output window, with the same rule the output timer enforces:
+// in every slot the heaters that are on together stay within maxPower. A grant can therefore always be switched on,
+// what doesn't fit is not granted instead of being cut off by the timer later. Heaters are placed in preference order.
+class PowerBudget
+{
+
+private:
+    uint32_t maxPower = 0; // W, 0 is no limit
+    uint32_t load[POWER_SLOTS];
+
+    bool fits(size_t slot, uint16_t watt) const
+    {
+        return maxPower == 0 || load[slot] + watt <= maxPower;
+    }
+
+public:
+    void reset(uint32_t maxPower)
+    {
+        this->maxPower = maxPower;
+        std::fill(load, load + POWER_SLOTS, 0);
+    }
+
+    // currentPhase is where the heater burns now (-1 when it is off), it stays there when that is as good as the best spot,
+    // so the windows don't move every pid cycle
+    PowerGrant place(uint16_t watt, uint8_t requested, int currentPhase)
+    {
+        requested = std::min(requested, (uint8_t)POWER_SLOTS);
+
+        if (requested == 0)
+        {
+            return {0, 0};
+        }
+
+        if (watt == 0)
+        {
+            // unknown wattage, we can't budget it
+            return {requested, 0};
+        }
+
+        // free run length and overlapping load from every start, twice around so runs can wrap
+        uint8_t run[2 * POWER_SLOTS + 1];
+        run[2 * POWER_SLOTS] = 0;
+        for (size_t i = 2 * POWER_SLOTS; i-- > 0;)
+        {
+            run[i] = fits(i % POWER_SLOTS, watt) ? (uint8_t)std::min(run[i + 1] + 1, POWER_SLOTS) : 0;
+        }
+
+        uint32_t overlap[2 * POWER_SLOTS + 1];
+        overlap[0] = 0;
+        for (size_t i = 0; i < 2 * POWER_SLOTS; i++)
+        {
+            overlap[i + 1] = overlap[i] + load[i % POWER_SLOTS];
+        }
+
+        // longest window first, then staying put, then the least overlap so heaters take turns when there is no limit
+        int best = -1;
+        uint8_t bestLength = 0;
+        uint32_t bestOverlap = 0;
+        for (size_t start = 0; start < POWER_SLOTS; start++)
+        {
+            uint8_t length = std::min(run[start], requested);
+            if (length == 0)
+            {
+                continue;
+            }
+
+            uint32_t used = overlap[start + length] - overlap[start];
+            if (best < 0 || length > bestLength || (length == bestLength && used < bestOverlap))
+            {
+                best = start;
+                bestLength = length;
+                bestOverlap = used;
+            }
+        }
+
+        if (best < 0)
+        {
+            return {0, 0};
+        }
+
+        if (currentPhase >= 0 && currentPhase < POWER_SLOTS && std::min(run[currentPhase], requested) == bestLength)
+        {
+            best = currentPhase;
+        }
+
+        for (size_t i = 0; i < bestLength; i++)
+        {
+            load[(best + i) % POWER_SLOTS] += watt;
+        }
+
+        return {bestLength, (uint8_t)best};
+    }
+
+    // the timer side of the same rule, slot of a tick in a window of windowTicks
+    static bool burns(uint32_t tick, uint32_t windowTicks, uint8_t phase, uint8_t burnTime)
+    {
+        if (windowTicks == 0)
+        {
+            return false;
+        }
+
+        uint32_t slot = (uint64_t)tick * POWER_SLOTS / windowTicks;
+        return ((slot + POWER_SLOTS - phase) % POWER_SLOTS) < burnTime;
+    }
+};
+
+#endif /* INCLUDE_POWERBUDGET_HPP_ */
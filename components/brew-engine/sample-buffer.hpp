@@ -0,0 +1,109 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_SAMPLEBUFFER_HPP_
+#define INCLUDE_SAMPLEBUFFER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+struct TemperatureSample
+{
+    uint64_t sensorId;  // 0 means the slot is not in use
+    float temperature;
+    int64_t timestamp;  // esp_timer time (us) of the reading
+    bool valid;         // false when the read failed, temperature is then -999
+    bool show;
+    bool useForControl;
+    float weight;       // share in the control temperature
+    uint8_t vessel;     // the vessel the sensor measures, 0 is the main kettle
+};
+
+// Fixed array of samples, every slot has a single writer (the task of its bus) and is protected by a seqlock,
+// so readers never block the acquisition tasks and always get a consistent copy.
+template <size_t N>
+class SampleBuffer
+{
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence{0};
+        TemperatureSample sample{};
+    };
+
+    Slot slots[N];
+
+public:
+    size_t size() const
+    {
+        return N;
+    }
+
+    void publish(size_t index, const TemperatureSample &sample)
+    {
+        if (index >= N)
+        {
+            return;
+        }
+
+        Slot &slot = slots[index];
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+
+        // odd sequence marks a write in progress
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.sample = sample;
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void clear(size_t index)
+    {
+        if (index >= N)
+        {
+            return;
+        }
+
+        // avoid bumping the sequence for slots that are already empty
+        TemperatureSample current;
+        if (!read(index, current))
+        {
+            return;
+        }
+
+        TemperatureSample empty{};
+        publish(index, empty);
+    }
+
+    // returns false when the slot is not in use
+    bool read(size_t index, TemperatureSample &sample) const
+    {
+        if (index >= N)
+        {
+            return false;
+        }
+
+        const Slot &slot = slots[index];
+        uint32_t before;
+        uint32_t after;
+
+        do
+        {
+            before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue; // writer busy, try again
+            }
+            sample = slot.sample;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        return sample.sensorId != 0;
+    }
+};
+
+#endif /* INCLUDE_SAMPLEBUFFER_HPP_ */
@@ -0,0 +1,84 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_SCHEDULEEDITS_HPP_
+#define INCLUDE_SCHEDULEEDITS_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct ScheduleEdit
+{
+    uint16_t version;  // running version after the edit
+    uint16_t fromStep; // the edit applies to this step and all after it
+    int32_t shift;     // seconds the steps and notifications moved
+};
+
+// The last N edits of the running schedule, so a client that knows an earlier version only needs the difference.
+// A full rebuild (loadSchedule) clears the log, clients that are older than the oldest edit get the full schedule.
+template <size_t N>
+class ScheduleEditLog
+{
+
+private:
+    ScheduleEdit edits[N];
+    size_t head = 0;  // next write position
+    size_t count = 0; // number of valid edits
+    uint16_t baseVersion = 0; // version of the schedule before the oldest edit we have
+
+public:
+    void reset(uint16_t version)
+    {
+        head = 0;
+        count = 0;
+        baseVersion = version;
+    }
+
+    void add(uint16_t version, uint16_t fromStep, int32_t shift)
+    {
+        if (count == N)
+        {
+            // the oldest edit falls out, clients at its base version now need a full schedule
+            baseVersion = edits[head].version;
+        }
+        else
+        {
+            count++;
+        }
+
+        edits[head] = {version, fromStep, shift};
+        head = (head + 1) % N;
+    }
+
+    // collects the edits after sinceVersion, false when they are no longer all available
+    bool since(uint16_t sinceVersion, std::vector<ScheduleEdit> &out) const
+    {
+        out.clear();
+
+        // versions are 16 bit and wrap, we compare the distance to the base
+        uint16_t newest = (count > 0) ? edits[(head + N - 1) % N].version : baseVersion;
+        uint16_t available = newest - baseVersion;
+        uint16_t behind = newest - sinceVersion;
+
+        if (behind > available)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const ScheduleEdit &edit = edits[(head + N - count + i) % N];
+            if ((uint16_t)(newest - edit.version) < behind)
+            {
+                out.push_back(edit);
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif /* INCLUDE_SCHEDULEEDITS_HPP_ */
@@ -0,0 +1,137 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_SENSORFILTER_HPP_
+#define INCLUDE_SENSORFILTER_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#define SENSOR_FILTER_MAX_MEDIAN 7
+
+enum SensorFilterType : uint8_t
+{
+    FilterNone = 0,
+    FilterEma = 1,
+    FilterKalman = 2,
+};
+
+// Per sensor smoothing: a median over the last N readings throws out single spikes, then an EMA or a 1D Kalman
+// (random walk model) takes out the noise. Runs in the task of the bus, so it has its own state per sensor.
+class SensorFilter
+{
+
+private:
+    float window[SENSOR_FILTER_MAX_MEDIAN];
+    uint8_t windowCount = 0;
+    uint8_t windowHead = 0;
+
+    bool initialized = false;
+    float estimate = 0;
+    float errorCovariance = 1;
+
+public:
+    uint8_t medianWindow = 1; // 1 disables, odd values up to SENSOR_FILTER_MAX_MEDIAN
+    SensorFilterType type = FilterNone;
+    float alpha = 0.3;        // ema weight of a new reading
+    float processNoise = 0.01;     // kalman, how fast the real temperature can move per reading (°²)
+    float measurementNoise = 0.25; // kalman, variance of a reading (°²)
+
+    void reset()
+    {
+        windowCount = 0;
+        windowHead = 0;
+        initialized = false;
+        errorCovariance = 1;
+    }
+
+    float apply(float value)
+    {
+        value = median(value);
+
+        if (!initialized)
+        {
+            initialized = true;
+            estimate = value;
+            errorCovariance = measurementNoise;
+            return value;
+        }
+
+        switch (type)
+        {
+        case FilterEma:
+            estimate += alpha * (value - estimate);
+            break;
+        case FilterKalman:
+        {
+            errorCovariance += processNoise;
+            float gain = errorCovariance / (errorCovariance + measurementNoise);
+            estimate += gain * (value - estimate);
+            errorCovariance *= (1 - gain);
+            break;
+        }
+        default:
+            estimate = value;
+            break;
+        }
+
+        return estimate;
+    }
+
+    // keeps the parameters in range, so a bad setting can't stop the sensor
+    void sanitize()
+    {
+        if (medianWindow < 1)
+        {
+            medianWindow = 1;
+        }
+        if (medianWindow > SENSOR_FILTER_MAX_MEDIAN)
+        {
+            medianWindow = SENSOR_FILTER_MAX_MEDIAN;
+        }
+        if (type > FilterKalman)
+        {
+            type = FilterNone;
+        }
+        if (!(alpha > 0 && alpha <= 1))
+        {
+            alpha = 0.3;
+        }
+        if (!(processNoise > 0))
+        {
+            processNoise = 0.01;
+        }
+        if (!(measurementNoise > 0))
+        {
+            measurementNoise = 0.25;
+        }
+        reset();
+    }
+
+private:
+    float median(float value)
+    {
+        if (medianWindow <= 1)
+        {
+            return value;
+        }
+
+        window[windowHead] = value;
+        windowHead = (windowHead + 1) % medianWindow;
+        if (windowCount < medianWindow)
+        {
+            windowCount++;
+        }
+
+        float sorted[SENSOR_FILTER_MAX_MEDIAN];
+        std::copy(window, window + windowCount, sorted);
+        std::nth_element(sorted, sorted + windowCount / 2, sorted + windowCount);
+
+        return sorted[windowCount / 2];
+    }
+};
+
+#endif /* INCLUDE_SENSORFILTER_HPP_ */
@@ -0,0 +1,204 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_TEMPLOG_HPP_
+#define INCLUDE_TEMPLOG_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+#include <cmath>
+
+// Fixed capacity ring buffer with the running temperature history, the oldest samples are overwritten.
+// Samples are packed as an offset in seconds to a base time and the temperature in tenths, 4 bytes per point.
+// There is one writer (the read loop), clear() may come from any task and is carried out by the next add.
+// Writes are published with a seqlock like SampleBuffer, so readers never see a rebase half done.
+template <size_t N>
+class TempLog
+{
+
+private:
+    struct PackedSample
+    {
+        uint16_t offset; // seconds since base
+        int16_t tenths;  // temperature * 10
+    };
+
+    PackedSample buffer[N];
+    time_t base = 0;
+    size_t head = 0;              // next write position
+    std::atomic<size_t> count{0}; // number of valid samples
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<bool> clearRequested{false};
+
+    size_t physical(size_t logical, size_t currentHead, size_t currentCount) const
+    {
+        return (currentHead + N - currentCount + logical) % N;
+    }
+
+    // offsets are 16 bit (18h), when we get close we move the base forward,
+    // samples from before the new base can't be stored anymore so the tail moves past them
+    void rebase(time_t newBase)
+    {
+        time_t shift = newBase - base;
+        size_t currentCount = count.load(std::memory_order_relaxed);
+
+        // samples are in time order, so the ones to drop are at the start
+        size_t dropped = 0;
+        while (dropped < currentCount && buffer[physical(dropped, head, currentCount)].offset < shift)
+        {
+            dropped++;
+        }
+
+        size_t remaining = currentCount - dropped;
+        for (size_t i = 0; i < remaining; i++)
+        {
+            buffer[physical(i, head, remaining)].offset -= (uint16_t)shift;
+        }
+
+        count.store(remaining, std::memory_order_relaxed);
+        base = newBase;
+    }
+
+public:
+    void clear()
+    {
+        clearRequested.store(true, std::memory_order_release);
+    }
+
+    size_t size() const
+    {
+        if (clearRequested.load(std::memory_order_acquire))
+        {
+            return 0;
+        }
+        return count.load(std::memory_order_acquire);
+    }
+
+    void add(time_t time, float temperature)
+    {
+        if (std::isnan(temperature))
+        {
+            return;
+        }
+
+        // odd sequence marks a write in progress
+        uint32_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        size_t currentCount = count.load(std::memory_order_relaxed);
+
+        // the clock stepped back (or jumped further than a rebase can follow, e.g. the first sntp sync),
+        // the history is in time order so it can't continue
+        if (currentCount > 0)
+        {
+            time_t newest = base + buffer[(head + N - 1) % N].offset;
+            if (time < newest || time - base > 30000 + UINT16_MAX)
+            {
+                currentCount = 0;
+            }
+        }
+
+        if (clearRequested.exchange(false, std::memory_order_acq_rel))
+        {
+            currentCount = 0;
+        }
+
+        if (currentCount == 0)
+        {
+            head = 0;
+            count.store(0, std::memory_order_relaxed);
+            base = time;
+        }
+        else if (time - base > 60000)
+        {
+            rebase(time - 30000);
+            currentCount = count.load(std::memory_order_relaxed);
+        }
+
+        buffer[head].offset = (uint16_t)(time - base);
+        buffer[head].tenths = (int16_t)lroundf(temperature * 10);
+
+        head = (head + 1) % N;
+        if (currentCount < N)
+        {
+            count.store(currentCount + 1, std::memory_order_relaxed);
+        }
+
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    // consistent copy of one sample, false when the index is past the end
+    bool read(size_t index, time_t &time, float &temperature) const
+    {
+        uint32_t before;
+        uint32_t after;
+        bool found;
+
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue; // writer busy, try again
+            }
+
+            size_t currentCount = size();
+            found = index < currentCount;
+            if (found)
+            {
+                PackedSample sample = buffer[physical(index, head, currentCount)];
+                time = base + sample.offset;
+                temperature = (float)sample.tenths / 10;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        return found;
+    }
+
+    time_t timeAt(size_t index) const
+    {
+        time_t time = 0;
+        float temperature;
+        read(index, time, temperature);
+        return time;
+    }
+
+    float temperatureAt(size_t index) const
+    {
+        time_t time;
+        float temperature = NAN;
+        read(index, time, temperature);
+        return temperature;
+    }
+
+    // first index with a time after the given time, size() when there is nothing newer
+    size_t findAfter(time_t time) const
+    {
+        size_t low = 0;
+        size_t high = size();
+
+        while (low < high)
+        {
+            size_t middle = low + (high - low) / 2;
+            if (timeAt(middle) <= time)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        return low;
+    }
+};
+
+#endif // INCLUDE_TEMPLOG_HPP_
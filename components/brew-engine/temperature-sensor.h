@@ -4,6 +4,8 @@
 #include "nlohmann_json.hpp"
 #include "ds18b20.h"
 #include "max31865_driver.h"
+#include "sensor-filter.hpp"
+#include "inline-string.hpp"
 #include <cstring>
 
 using namespace std;
@@ -20,8 +22,8 @@ class TemperatureSensor
 {
 public:
     uint64_t id;
-    string name;
-    string color;
+    InlineString<MAX_NAME_LENGTH> name;
+    InlineString<MAX_COLOR_LENGTH> color;
     bool show;
     bool useForControl;
     bool connected;
@@ -32,12 +34,20 @@ public:
     
     // Sensor-specific handles
     ds18b20_device_handle_t ds18b20Handle;
+    uint8_t resolution;     // DS18B20 resolution in bits (9-12), lower is faster but coarser
     max31865_t max31865Handle;
     
     // NTC sensor configuration
     int analogPin;          // GPIO pin for analog reading
     float ntcResistance;    // NTC resistance at 25°C (in ohms)
     float dividerResistor;  // Voltage divider resistor value (in ohms)
+    uint8_t oversample = 1; // adc reads averaged per NTC reading
+    
+    // filtering and fusion
+    SensorFilter filter;
+    float weight = 1;       // share in the control temperature compared to the other sensors
+    uint8_t vessel = 0;     // runtime, the vessel this sensor measures, 0 is the main kettle
+    int64_t lastValidAt = 0; // esp_timer time of the last valid reading, a longer gap restarts the filter
     
     // RTD sensor recovery tracking
     int consecutiveFailures;
@@ -55,6 +65,16 @@ public:
         jSensor["compensateRelative"] = this->compensateRelative;
         jSensor["lastTemp"] = (double)((int)(this->lastTemp * 10)) / 10; // round float to 0.1 for display
         jSensor["sensorType"] = this->sensorType;
+        jSensor["median"] = this->filter.medianWindow;
+        jSensor["filter"] = this->filter.type;
+        jSensor["filterAlpha"] = this->filter.alpha;
+        jSensor["kalmanQ"] = this->filter.processNoise;
+        jSensor["kalmanR"] = this->filter.measurementNoise;
+        jSensor["weight"] = this->weight;
+
+        if (this->sensorType == SENSOR_DS18B20) {
+            jSensor["resolution"] = this->resolution;
+        }
         
         // Include CS pin for RTD sensors
         if (this->sensorType == SENSOR_PT100 || this->sensorType == SENSOR_PT1000) {
@@ -72,6 +92,7 @@ public:
             }
             jSensor["ntcResistance"] = this->ntcResistance;
             jSensor["dividerResistor"] = this->dividerResistor;
+            jSensor["oversample"] = this->oversample;
         }
 
         return jSensor;
@@ -131,6 +152,19 @@ public:
             this->sensorType = SENSOR_DS18B20; // default to DS18B20 for backward compatibility
         }
 
+        if (jsonData.contains("resolution") && jsonData["resolution"].is_number_integer() &&
+            jsonData["resolution"] >= 9 && jsonData["resolution"] <= 12)
+        {
+            this->resolution = (uint8_t)jsonData["resolution"];
+        }
+        else
+        {
+            this->resolution = 12; // default to full resolution as before
+        }
+
+        this->filtersFromJson(jsonData);
+        this->lastValidAt = 0;
+
         // will be set by detection
         this->connected = false;
         this->consecutiveFailures = 0;
@@ -163,6 +197,16 @@ public:
             {
                 this->dividerResistor = 10000.0f; // 10k voltage divider default
             }
+
+            if (jsonData.contains("oversample") && jsonData["oversample"].is_number_integer() &&
+                jsonData["oversample"] >= 1 && jsonData["oversample"] <= 64)
+            {
+                this->oversample = (uint8_t)jsonData["oversample"];
+            }
+            else
+            {
+                this->oversample = 8; // a burst of 8 oneshot reads takes well under a ms
+            }
         }
         else
         {
@@ -170,9 +214,57 @@ public:
             this->analogPin = 0;
             this->ntcResistance = 10000.0f;
             this->dividerResistor = 10000.0f;
+            this->oversample = 1;
         }
     };
 
+    // filter and fusion settings of a new sensor
+    void filtersFromJson(const json &jsonData)
+    {
+        this->filter = filterFromJson(jsonData);
+        this->weight = weightFromJson(jsonData);
+    };
+
+    // the filter is built on the side, so a running sensor can swap it in at once while its bus task is not filtering
+    static SensorFilter filterFromJson(const json &jsonData)
+    {
+        // filters are optional, without them a reading goes through as before
+        SensorFilter filter;
+        if (jsonData.contains("median") && jsonData["median"].is_number_integer())
+        {
+            filter.medianWindow = (uint8_t)std::clamp((int)jsonData["median"], 1, SENSOR_FILTER_MAX_MEDIAN);
+        }
+        if (jsonData.contains("filter") && jsonData["filter"].is_number_integer())
+        {
+            filter.type = (SensorFilterType)(int)jsonData["filter"];
+        }
+        if (jsonData.contains("filterAlpha") && jsonData["filterAlpha"].is_number())
+        {
+            filter.alpha = (float)jsonData["filterAlpha"];
+        }
+        if (jsonData.contains("kalmanQ") && jsonData["kalmanQ"].is_number())
+        {
+            filter.processNoise = (float)jsonData["kalmanQ"];
+        }
+        if (jsonData.contains("kalmanR") && jsonData["kalmanR"].is_number())
+        {
+            filter.measurementNoise = (float)jsonData["kalmanR"];
+        }
+        filter.sanitize();
+
+        return filter;
+    };
+
+    static float weightFromJson(const json &jsonData)
+    {
+        if (jsonData.contains("weight") && jsonData["weight"].is_number() && (float)jsonData["weight"] > 0)
+        {
+            return (float)jsonData["weight"];
+        }
+
+        return 1;
+    };
+
 protected:
 private:
 };
@@ -0,0 +1,191 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_THERMALMODEL_HPP_
+#define INCLUDE_THERMALMODEL_HPP_
+
+#include <cmath>
+#include "nlohmann_json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+// First order model of the kettle: dT/dt = gain * power - loss * (T - ambient)
+// gain is 1/heat capacity (°/s per kW) and loss the loss coefficient over heat capacity (1/s),
+// both are fitted online with recursive least squares from the applied power and the measured slope.
+// ambient is not fitted, it is a fixed room temperature, at mash temperatures an error there mostly ends up in loss.
+class ThermalModel
+{
+
+private:
+    // covariance of the estimate, large means we don't trust it yet
+    double p11 = 1000;
+    double p12 = 0;
+    double p22 = 1000;
+
+    double forgetting = 0.995; // slowly forget old data, volume changes between brews
+
+    // accumulation of the current window
+    double windowTime = 0;
+    double windowEnergy = 0;      // kW * s
+    double windowTemperature = 0; // ° * s
+    double windowStartTemperature = 0;
+    bool windowStarted = false;
+
+    void fit(double power, double delta, double slope)
+    {
+        // phi = [power, -delta], y = slope
+        double phi1 = power;
+        double phi2 = -delta;
+
+        double pPhi1 = p11 * phi1 + p12 * phi2;
+        double pPhi2 = p12 * phi1 + p22 * phi2;
+        double denominator = forgetting + phi1 * pPhi1 + phi2 * pPhi2;
+
+        double k1 = pPhi1 / denominator;
+        double k2 = pPhi2 / denominator;
+
+        double error = slope - (gain * phi1 + loss * phi2);
+        gain += k1 * error;
+        loss += k2 * error;
+
+        p11 = (p11 - k1 * pPhi1) / forgetting;
+        p12 = (p12 - k1 * pPhi2) / forgetting;
+        p22 = (p22 - k2 * pPhi2) / forgetting;
+
+        // a diverged fit can't recover, start learning over instead of driving the heaters from it
+        if (!isfinite(gain) || !isfinite(loss) || !isfinite(p11) || !isfinite(p12) || !isfinite(p22))
+        {
+            this->reset();
+            return;
+        }
+
+        samples++;
+    }
+
+public:
+    double gain = 0;
+    double loss = 0;
+    double ambient = 20;
+    uint32_t samples = 0;
+    double window = 30; // seconds per fit, shorter windows are mostly sensor noise
+
+    // a model is only used when it has seen enough data and makes physical sense
+    bool isValid()
+    {
+        return samples >= 10 && gain > 0 && loss >= 0;
+    }
+
+    // forget everything learned, ambient is kept as it comes from settings
+    void reset()
+    {
+        gain = 0;
+        loss = 0;
+        samples = 0;
+        p11 = 1000;
+        p12 = 0;
+        p22 = 1000;
+        windowStarted = false;
+    }
+
+    // power in kW, dt in seconds
+    void update(double power, double temperature, double dt)
+    {
+        // a sensor error or nan power would poison the fit for good, skip the window instead
+        if (!isfinite(power) || !isfinite(temperature) || !isfinite(dt) || dt < 0)
+        {
+            windowStarted = false;
+            return;
+        }
+
+        if (!windowStarted)
+        {
+            windowStarted = true;
+            windowStartTemperature = temperature;
+            windowTime = 0;
+            windowEnergy = 0;
+            windowTemperature = 0;
+            return;
+        }
+
+        windowTime += dt;
+        windowEnergy += power * dt;
+        windowTemperature += temperature * dt;
+
+        if (windowTime >= window)
+        {
+            double slope = (temperature - windowStartTemperature) / windowTime;
+            this->fit(windowEnergy / windowTime, (windowTemperature / windowTime) - ambient, slope);
+
+            windowStartTemperature = temperature;
+            windowTime = 0;
+            windowEnergy = 0;
+            windowTemperature = 0;
+        }
+    }
+
+    // restart the window, e.g. after a pause where we didn't follow the power
+    void resetWindow()
+    {
+        windowStarted = false;
+    }
+
+    // power in kW needed to follow slope (°/s) at the given temperature
+    double requiredPower(double slope, double temperature)
+    {
+        if (!isValid())
+        {
+            return 0;
+        }
+
+        return (slope + loss * (temperature - ambient)) / gain;
+    }
+
+    json to_json()
+    {
+        json jModel;
+        jModel["gain"] = this->gain;
+        jModel["loss"] = this->loss;
+        jModel["ambient"] = this->ambient;
+        jModel["samples"] = this->samples;
+        jModel["p11"] = this->p11;
+        jModel["p12"] = this->p12;
+        jModel["p22"] = this->p22;
+
+        return jModel;
+    }
+
+    // a stored model that is incomplete or not a number is ignored, we then learn from scratch
+    void from_json(const json &jsonData)
+    {
+        if (!jsonData.is_object())
+        {
+            return;
+        }
+
+        for (const char *key : {"gain", "loss", "ambient", "p11", "p12", "p22"})
+        {
+            if (!jsonData.contains(key) || !jsonData[key].is_number() || !isfinite(jsonData[key].get<double>()))
+            {
+                return;
+            }
+        }
+
+        if (!jsonData.contains("samples") || !jsonData["samples"].is_number_unsigned())
+        {
+            return;
+        }
+
+        this->gain = jsonData["gain"].get<double>();
+        this->loss = jsonData["loss"].get<double>();
+        this->ambient = jsonData["ambient"].get<double>();
+        this->samples = jsonData["samples"].get<uint32_t>();
+        this->p11 = jsonData["p11"].get<double>();
+        this->p12 = jsonData["p12"].get<double>();
+        this->p22 = jsonData["p22"].get<double>();
+    }
+};
+
+#endif // INCLUDE_THERMALMODEL_HPP_
@@ -0,0 +1,134 @@
+#ifndef _Vessel_H_
+#define _Vessel_H_
+
+#include "nlohmann_json.hpp"
+#include "pidController.hpp"
+#include <optional>
+#include <vector>
+#include <cmath>
+
+using namespace std;
+using json = nlohmann::json;
+
+// An extra vessel (e.g. the HLT) that holds its own setpoint next to the running schedule, with its own sensors and heaters.
+// Vessel 0 is the main kettle, it is not stored here and gets every sensor and heater that no other vessel claims.
+class Vessel
+{
+public:
+    uint8_t id; // 1 and up
+    string name;
+    vector<uint64_t> sensors;
+    vector<uint8_t> heaters;
+    float setpoint;
+    double kP;
+    double kI;
+    double kD;
+
+    // runtime
+    bool running = false;
+    float targetTemperature = 0;
+    float temperature = NAN;
+    uint8_t output = 0;
+    uint8_t grantedOutput = 0; // what the shared power budget let through of output, lower when other heaters have preference
+    uint totalWattage = 0;
+    std::optional<PIDController> pid;
+
+    json to_json()
+    {
+        json jVessel;
+        jVessel["id"] = this->id;
+        jVessel["name"] = this->name;
+
+        // js doesn't support uint64_t, so we convert to string
+        json jSensors = json::array({});
+        for (auto const &sensorId : this->sensors)
+        {
+            jSensors.push_back(to_string(sensorId));
+        }
+        jVessel["sensors"] = jSensors;
+        jVessel["heaters"] = this->heaters;
+        jVessel["setpoint"] = this->setpoint;
+        jVessel["kP"] = this->kP;
+        jVessel["kI"] = this->kI;
+        jVessel["kD"] = this->kD;
+
+        return jVessel;
+    };
+
+    json status_json()
+    {
+        json jStatus;
+        jStatus["id"] = this->id;
+        jStatus["name"] = this->name;
+        jStatus["running"] = this->running;
+        jStatus["temp"] = std::isnan(this->temperature) ? json(nullptr) : json((double)((int)(this->temperature * 10)) / 10);
+        jStatus["targetTemp"] = this->targetTemperature;
+        jStatus["output"] = this->output;
+        jStatus["grantedOutput"] = this->grantedOutput;
+
+        return jStatus;
+    };
+
+    void from_json(const json &jsonData)
+    {
+        this->id = jsonData["id"].get<uint>();
+        this->name = jsonData["name"].get<string>();
+
+        this->sensors.clear();
+        if (jsonData["sensors"].is_array())
+        {
+            for (auto const &jSensor : jsonData["sensors"])
+            {
+                if (jSensor.is_string())
+                {
+                    this->sensors.push_back(std::stoull(jSensor.get<string>()));
+                }
+            }
+        }
+
+        this->heaters.clear();
+        if (jsonData["heaters"].is_array())
+        {
+            for (auto const &jHeater : jsonData["heaters"])
+            {
+                if (jHeater.is_number_integer())
+                {
+                    this->heaters.push_back((uint8_t)jHeater);
+                }
+            }
+        }
+
+        if (!jsonData["setpoint"].is_null() && jsonData["setpoint"].is_number())
+        {
+            this->setpoint = (float)jsonData["setpoint"];
+        }
+        else
+        {
+            this->setpoint = 78; // sparge water
+        }
+
+        // the pid needs all three gains, defaults are the mash defaults
+        this->kP = 10;
+        this->kI = 1;
+        this->kD = 10;
+        if (jsonData["kP"].is_number() && (double)jsonData["kP"] > 0)
+        {
+            this->kP = (double)jsonData["kP"];
+        }
+        if (jsonData["kI"].is_number() && (double)jsonData["kI"] > 0)
+        {
+            this->kI = (double)jsonData["kI"];
+        }
+        if (jsonData["kD"].is_number() && (double)jsonData["kD"] > 0)
+        {
+            this->kD = (double)jsonData["kD"];
+        }
+
+        this->running = false;
+    };
+
+protected:
+private:
+};
+
+#endif /* _Vessel_H_ */
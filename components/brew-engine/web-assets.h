@@ -0,0 +1,9 @@
+#ifndef WEB_ASSETS_H_IN
+#define WEB_ASSETS_H_IN
+
+// Generated by CMake, firmware version plus part of the md5 of the embedded file
+#define INDEX_HTML_ETAG "\"1.6.0-225cd0b740433241\""
+#define LOGO_SVG_ETAG "\"1.6.0-5cb1285c5f7776f1\""
+#define MANIFEST_JSON_ETAG "\"1.6.0-f3e1ef4b4787bbde\""
+
+#endif // WEB_ASSETS_H_IN
@@ -11,6 +11,8 @@ static const char *TAG = "SettingsManager";
 SettingsManager::SettingsManager()
 {
     ESP_LOGI(TAG, "SettingsManager Construct");
+    this->nvsHandle = new nvs_handle_t();
+    this->mutex = xSemaphoreCreateRecursiveMutex();
 }
 
 void SettingsManager::Init()
@@ -53,9 +55,220 @@ void SettingsManager::FactoryReset()
     ESP_ERROR_CHECK(nvs_flash_erase());
     ESP_ERROR_CHECK(nvs_flash_init());
 
+    xSemaphoreTakeRecursive(this->mutex, portMAX_DELAY);
+    this->cache.clear();
+    this->pending.clear();
+    xSemaphoreGiveRecursive(this->mutex);
+
     ESP_LOGI(TAG, "FactoryReset: Done");
 }
 
+void SettingsManager::Begin()
+{
+    // other tasks wait with their writes until we commit
+    xSemaphoreTakeRecursive(this->mutex, portMAX_DELAY);
+    this->transactionDepth++;
+}
+
+void SettingsManager::Commit()
+{
+    if (this->transactionDepth == 0)
+    {
+        ESP_LOGW(TAG, "Commit without Begin");
+        return;
+    }
+
+    this->transactionDepth--;
+
+    if (this->transactionDepth == 0)
+    {
+        int64_t startedAt = esp_timer_get_time();
+        int written = 0;
+        for (auto const &[name, value] : this->pending)
+        {
+            if (!this->isUnchanged(name, value) && this->flush(name, value))
+            {
+                written++;
+            }
+        }
+
+        if (written > 0)
+        {
+            nvs_commit(*this->nvsHandle);
+
+            if (this->OnFlashWrite)
+            {
+                this->OnFlashWrite(esp_timer_get_time() - startedAt);
+            }
+        }
+
+        ESP_LOGI(TAG, "Commit: %d of %d settings changed", written, this->pending.size());
+        this->pending.clear();
+    }
+
+    xSemaphoreGiveRecursive(this->mutex);
+}
+
+// pending writes of the transaction first, then what we know is in nvs
+bool SettingsManager::lookup(const string &name, SettingType type, vector<uint8_t> &data)
+{
+    bool found = false;
+
+    xSemaphoreTakeRecursive(this->mutex, portMAX_DELAY);
+
+    auto pos = this->pending.find(name);
+    if (pos == this->pending.end())
+    {
+        pos = this->cache.find(name);
+        if (pos == this->cache.end())
+        {
+            pos = this->pending.end();
+        }
+    }
+
+    if (pos != this->pending.end() && pos->second.type == type)
+    {
+        data = pos->second.data;
+        found = true;
+    }
+
+    xSemaphoreGiveRecursive(this->mutex);
+
+    return found;
+}
+
+void SettingsManager::remember(const string &name, SettingType type, const vector<uint8_t> &data)
+{
+    xSemaphoreTakeRecursive(this->mutex, portMAX_DELAY);
+
+    if (data.size() <= SETTINGS_CACHE_MAX_SIZE)
+    {
+        this->cache[name] = {type, data};
+    }
+    else
+    {
+        this->cache.erase(name);
+    }
+
+    xSemaphoreGiveRecursive(this->mutex);
+}
+
+bool SettingsManager::isUnchanged(const string &name, const SettingValue &value)
+{
+    auto pos = this->cache.find(name);
+    if (pos != this->cache.end())
+    {
+        return pos->second.type == value.type && pos->second.data == value.data;
+    }
+
+    // not cached (large blob), compare with what is in nvs, a read is much cheaper than a flash write
+    if (value.type == SettingBlob)
+    {
+        size_t size = 0;
+        if (nvs_get_blob(*this->nvsHandle, name.c_str(), NULL, &size) != ESP_OK || size != value.data.size())
+        {
+            return false;
+        }
+
+        vector<uint8_t> current(size);
+        return nvs_get_blob(*this->nvsHandle, name.c_str(), current.data(), &size) == ESP_OK && current == value.data;
+    }
+
+    return false;
+}
+
+// writes the value to nvs, without commit
+bool SettingsManager::flush(const string &name, const SettingValue &value)
+{
+    esp_err_t err = ESP_OK;
+
+    switch (value.type)
+    {
+    case SettingString:
+    {
+        string text(value.data.begin(), value.data.end());
+        err = nvs_set_str(*this->nvsHandle, name.c_str(), text.c_str());
+
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Error writing Setting: %s - %s (len: %d)", name.c_str(), esp_err_to_name(err), text.length());
+
+            // If string is too large for nvs_set_str, try blob storage for very long values
+            if (err == ESP_ERR_NVS_VALUE_TOO_LONG && text.length() > 4000)
+            {
+                ESP_LOGI(TAG, "String too long for NVS str, trying blob storage for: %s", name.c_str());
+
+                // Store as blob for very long strings
+                err = nvs_set_blob(*this->nvsHandle, name.c_str(), text.c_str(), text.length() + 1);
+
+                if (err == ESP_OK)
+                {
+                    ESP_LOGI(TAG, "Successfully stored long string as blob: %s", name.c_str());
+                }
+                else
+                {
+                    ESP_LOGE(TAG, "Failed to store long string as blob: %s - %s", name.c_str(), esp_err_to_name(err));
+                }
+            }
+            // a string stored as blob can't be cached as string
+            this->cache.erase(name);
+            return err == ESP_OK;
+        }
+        break;
+    }
+    case SettingBlob:
+        err = nvs_set_blob(*this->nvsHandle, name.c_str(), value.data.data(), value.data.size());
+        break;
+    case SettingU8:
+        err = nvs_set_u8(*this->nvsHandle, name.c_str(), value.data[0]);
+        break;
+    case SettingI8:
+        err = nvs_set_i8(*this->nvsHandle, name.c_str(), (int8_t)value.data[0]);
+        break;
+    case SettingU16:
+        err = nvs_set_u16(*this->nvsHandle, name.c_str(), (uint16_t)(value.data[0] | (value.data[1] << 8)));
+        break;
+    }
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error writing Setting: %s", name.c_str());
+        this->cache.erase(name);
+        return false;
+    }
+
+    this->remember(name, value.type, value.data);
+    return true;
+}
+
+void SettingsManager::store(const string &name, SettingType type, const vector<uint8_t> &data)
+{
+    xSemaphoreTakeRecursive(this->mutex, portMAX_DELAY);
+
+    SettingValue value = {type, data};
+
+    if (this->transactionDepth > 0)
+    {
+        this->pending[name] = value;
+    }
+    else
+    {
+        int64_t startedAt = esp_timer_get_time();
+
+        if (!this->isUnchanged(name, value) && this->flush(name, value))
+        {
+            nvs_commit(*this->nvsHandle);
+
+            if (this->OnFlashWrite)
+            {
+                this->OnFlashWrite(esp_timer_get_time() - startedAt);
+            }
+        }
+    }
+
+    xSemaphoreGiveRecursive(this->mutex);
+}
+
 // maby an option for the future, atm it just seems to make it more complex
 // template <typename T>
 // T *SettingsManager::Read(string name, T *defaultValue)
@@ -76,6 +289,12 @@ void SettingsManager::FactoryReset()
 
 string SettingsManager::Read(string name, string defaultValue)
 {
+    vector<uint8_t> cached;
+    if (this->lookup(name, SettingString, cached))
+    {
+        return string(cached.begin(), cached.end());
+    }
+
     size_t size = 0;
     esp_err_t err = nvs_get_str(*this->nvsHandle, name.c_str(), NULL, &size);
 
@@ -135,6 +354,8 @@ string SettingsManager::Read(string name, string defaultValue)
 
     string result(chars);
     free(chars);
+
+    this->remember(name, SettingString, vector<uint8_t>(result.begin(), result.end()));
     
     // Debug logging for specific Firebase URL reading
     if (name == "fbUrl" && !result.empty()) {
@@ -147,6 +368,11 @@ string SettingsManager::Read(string name, string defaultValue)
 
 vector<uint8_t> SettingsManager::Read(string name, vector<uint8_t> defaultValue)
 {
+    vector<uint8_t> cached;
+    if (this->lookup(name, SettingBlob, cached))
+    {
+        return cached;
+    }
 
     size_t size = 0;
     esp_err_t err = nvs_get_blob(*this->nvsHandle, name.c_str(), NULL, &size);
@@ -165,22 +391,30 @@ vector<uint8_t> SettingsManager::Read(string name, vector<uint8_t> defaultValue)
 
     ESP_LOGD(TAG, "Size: %d", size);
 
-    uint8_t blob[size];
+    vector<uint8_t> v_blob(size);
 
-    err = nvs_get_blob(*this->nvsHandle, name.c_str(), blob, &size);
+    err = nvs_get_blob(*this->nvsHandle, name.c_str(), v_blob.data(), &size);
 
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "Error reading Setting: %s", name.c_str());
     }
-
-    vector<uint8_t> v_blob = vector(blob, *(&blob + 1));
+    else
+    {
+        this->remember(name, SettingBlob, v_blob);
+    }
 
     return v_blob;
 }
 
 bool SettingsManager::Read(string name, bool defaultValue)
 {
+    vector<uint8_t> cached;
+    if (this->lookup(name, SettingU8, cached))
+    {
+        return (bool)cached[0];
+    }
+
     uint8_t value = 0;
     esp_err_t err = nvs_get_u8(*this->nvsHandle, name.c_str(), &value);
 
@@ -196,11 +430,19 @@ bool SettingsManager::Read(string name, bool defaultValue)
         return defaultValue;
     }
 
+    this->remember(name, SettingU8, {(uint8_t)value});
+
     return (bool)value;
 }
 
 uint8_t SettingsManager::Read(string name, uint8_t defaultValue)
 {
+    vector<uint8_t> cached;
+    if (this->lookup(name, SettingU8, cached))
+    {
+        return cached[0];
+    }
+
     uint8_t value = 0;
     esp_err_t err = nvs_get_u8(*this->nvsHandle, name.c_str(), &value);
 
@@ -216,11 +458,19 @@ uint8_t SettingsManager::Read(string name, uint8_t defaultValue)
         return defaultValue;
     }
 
+    this->remember(name, SettingU8, {(uint8_t)value});
+
     return value;
 }
 
 int8_t SettingsManager::Read(string name, int8_t defaultValue)
 {
+    vector<uint8_t> cached;
+    if (this->lookup(name, SettingI8, cached))
+    {
+        return (int8_t)cached[0];
+    }
+
     int8_t value = 0;
     esp_err_t err = nvs_get_i8(*this->nvsHandle, name.c_str(), &value);
 
@@ -236,11 +486,19 @@ int8_t SettingsManager::Read(string name, int8_t defaultValue)
         return defaultValue;
     }
 
+    this->remember(name, SettingI8, {(uint8_t)value});
+
     return value;
 }
 
 uint16_t SettingsManager::Read(string name, uint16_t defaultValue)
 {
+    vector<uint8_t> cached;
+    if (this->lookup(name, SettingU16, cached))
+    {
+        return (uint16_t)(cached[0] | (cached[1] << 8));
+    }
+
     uint16_t value = 0;
     esp_err_t err = nvs_get_u16(*this->nvsHandle, name.c_str(), &value);
 
@@ -256,87 +514,67 @@ uint16_t SettingsManager::Read(string name, uint16_t defaultValue)
         return defaultValue;
     }
 
+    this->remember(name, SettingU16, {(uint8_t)(value & 0xFF), (uint8_t)(value >> 8)});
+
     return value;
 }
 
 void SettingsManager::Write(string name, string value)
 {
-    esp_err_t err = nvs_set_str(*this->nvsHandle, name.c_str(), value.c_str());
-
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error writing Setting: %s - %s (len: %d)", name.c_str(), esp_err_to_name(err), value.length());
-        
-        // If string is too large for nvs_set_str, try blob storage for very long values
-        if (err == ESP_ERR_NVS_VALUE_TOO_LONG && value.length() > 4000)
-        {
-            ESP_LOGI(TAG, "String too long for NVS str, trying blob storage for: %s", name.c_str());
-            
-            // Store as blob for very long strings
-            err = nvs_set_blob(*this->nvsHandle, name.c_str(), value.c_str(), value.length() + 1);
-            
-            if (err == ESP_OK)
-            {
-                ESP_LOGI(TAG, "Successfully stored long string as blob: %s", name.c_str());
-            }
-            else
-            {
-                ESP_LOGE(TAG, "Failed to store long string as blob: %s - %s", name.c_str(), esp_err_to_name(err));
-            }
-        }
-    }
+    this->store(name, SettingString, vector<uint8_t>(value.begin(), value.end()));
 }
 
 void SettingsManager::Write(string name, vector<uint8_t> value)
 {
-    int size = value.size();
-    uint8_t arr[size];
-    copy(value.begin(), value.end(), arr);
-
-    esp_err_t err = nvs_set_blob(*this->nvsHandle, name.c_str(), arr, size);
-
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error writing Setting: %s", name.c_str());
-    }
+    this->store(name, SettingBlob, value);
 }
 
 void SettingsManager::Write(string name, bool value)
 {
-    esp_err_t err = nvs_set_u8(*this->nvsHandle, name.c_str(), (uint8_t)value);
-
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error writing Setting: %s", name.c_str());
-    }
+    this->store(name, SettingU8, {(uint8_t)value});
 }
 
 void SettingsManager::Write(string name, uint8_t value)
 {
-    esp_err_t err = nvs_set_u8(*this->nvsHandle, name.c_str(), value);
-
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error writing Setting: %s", name.c_str());
-    }
+    this->store(name, SettingU8, {value});
 }
 
 void SettingsManager::Write(string name, int8_t value)
 {
-    esp_err_t err = nvs_set_i8(*this->nvsHandle, name.c_str(), value);
-
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error writing Setting: %s", name.c_str());
-    }
+    this->store(name, SettingI8, {(uint8_t)value});
 }
 
 void SettingsManager::Write(string name, uint16_t value)
 {
-    esp_err_t err = nvs_set_u16(*this->nvsHandle, name.c_str(), value);
+    this->store(name, SettingU16, {(uint8_t)(value & 0xFF), (uint8_t)(value >> 8)});
+}
 
-    if (err != ESP_OK)
+bool SettingsManager::IsText(string name)
+{
+    nvs_type_t type;
+    esp_err_t err = nvs_find_key(*this->nvsHandle, name.c_str(), &type);
+
+    return err == ESP_OK && type == NVS_TYPE_STR;
+}
+
+void SettingsManager::Erase(string name)
+{
+    xSemaphoreTakeRecursive(this->mutex, portMAX_DELAY);
+
+    this->pending.erase(name);
+    this->cache.erase(name);
+
+    esp_err_t err = nvs_erase_key(*this->nvsHandle, name.c_str());
+
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND)
     {
-        ESP_LOGE(TAG, "Error writing Setting: %s", name.c_str());
+        ESP_LOGE(TAG, "Error erasing Setting: %s", name.c_str());
     }
-}
\ No newline at end of file
+    else if (err == ESP_OK && this->transactionDepth == 0)
+    {
+        nvs_commit(*this->nvsHandle);
+    }
+
+    xSemaphoreGiveRecursive(this->mutex);
+}
+
@@ -11,8 +11,14 @@
 #include "freertos/event_groups.h"
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include <vector>
+#include <map>
+#include <string>
+#include <functional>
+
+#include "freertos/semphr.h"
 
 #include "nvs_flash.h"
 #include "nvs.h"
@@ -20,16 +26,49 @@
 
 using namespace std;
 
+enum SettingType : uint8_t
+{
+    SettingString,
+    SettingBlob,
+    SettingU8,
+    SettingI8,
+    SettingU16,
+};
+
+struct SettingValue
+{
+    SettingType type;
+    vector<uint8_t> data; // raw value, strings without terminator
+};
+
+#define SETTINGS_CACHE_MAX_SIZE 256 // larger values (schedules) are compared against nvs instead of kept in ram
+
 class SettingsManager
 {
 private:
     nvs_handle_t *nvsHandle;
 
+    map<string, SettingValue> cache;   // last known nvs content, so unchanged writes can be skipped
+    map<string, SettingValue> pending; // writes of the open transaction
+    uint8_t transactionDepth = 0;
+    SemaphoreHandle_t mutex;
+
+    bool lookup(const string &name, SettingType type, vector<uint8_t> &data);
+    void remember(const string &name, SettingType type, const vector<uint8_t> &data);
+    bool isUnchanged(const string &name, const SettingValue &value);
+    bool flush(const string &name, const SettingValue &value);
+    void store(const string &name, SettingType type, const vector<uint8_t> &data);
+
 public:
     SettingsManager(); // constructor
     void Init();
     void FactoryReset();
 
+    // Writes between Begin and Commit are kept in ram and written with a single nvs commit,
+    // values that didn't change are not written at all. Transactions can be nested.
+    void Begin();
+    void Commit();
+
     // maby an option for the future, atm it just seems to make it more complex
     // template <typename T>
     // T *Read(string name, T *defaultValue);
@@ -49,7 +88,15 @@ public:
     void Write(string name, int8_t value);
     void Write(string name, uint16_t value);
 
+    void Erase(string name);
+
+    // true when the setting is stored as a nvs string, used to migrate settings that changed type
+    bool IsText(string name);
+
     string Namespace = "Settings";
+
+    // called with the duration in us of every write that reached flash, used for diagnostics
+    std::function<void(int64_t)> OnFlashWrite;
 };
 
 #endif /* INCLUDE_SETTINGSMANAGER_H */
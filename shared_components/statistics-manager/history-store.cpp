@@ -0,0 +1,181 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ */
+#include "history-store.h"
+#include "statistics-manager.h"
+#include "esp_littlefs.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+static const char *TAG = "HistoryStore";
+static const char *BASE_PATH = "/storage";
+static const char *PARTITION_LABEL = "storage";
+static const char *INDEX_FILE = "/storage/index.bin";
+static const char *INDEX_TMP_FILE = "/storage/index.tmp";
+static const uint32_t INDEX_MAGIC = 0x31495342; // "BSI1"
+
+struct IndexHeader {
+    uint32_t magic;
+    uint32_t recordSize; // lets a newer firmware grow BrewSession
+    uint32_t count;
+};
+
+bool HistoryStore::Mount()
+{
+    esp_vfs_littlefs_conf_t conf = {};
+    conf.base_path = BASE_PATH;
+    conf.partition_label = PARTITION_LABEL;
+    conf.format_if_mount_failed = true;
+    conf.dont_mount = false;
+
+    esp_err_t err = esp_vfs_littlefs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount history partition (%s)", esp_err_to_name(err));
+        return false;
+    }
+
+    this->mounted = true;
+
+    size_t total = 0, used = 0;
+    this->GetUsage(total, used);
+    ESP_LOGI(TAG, "History partition mounted, used %d of %d bytes", used, total);
+
+    return true;
+}
+
+string HistoryStore::sessionPath(uint32_t sessionId)
+{
+    return string(BASE_PATH) + "/s" + to_string(sessionId) + ".bin";
+}
+
+bool HistoryStore::LoadIndex(vector<BrewSession>& sessions)
+{
+    sessions.clear();
+
+    FILE *file = fopen(INDEX_FILE, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    IndexHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != INDEX_MAGIC || header.recordSize == 0) {
+        ESP_LOGW(TAG, "History index is invalid, starting empty");
+        fclose(file);
+        return false;
+    }
+
+    vector<uint8_t> record(header.recordSize);
+    for (uint32_t i = 0; i < header.count; i++) {
+        if (fread(record.data(), header.recordSize, 1, file) != 1) {
+            break;
+        }
+
+        BrewSession session = {};
+        memcpy(&session, record.data(), min((size_t)header.recordSize, sizeof(BrewSession)));
+        sessions.push_back(session);
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool HistoryStore::SaveIndex(const vector<BrewSession>& sessions)
+{
+    if (!this->mounted) {
+        return false;
+    }
+
+    // write a new file and swap it in, a power loss leaves either the old or the new index
+    FILE *file = fopen(INDEX_TMP_FILE, "wb");
+    if (file == NULL) {
+        ESP_LOGE(TAG, "Unable to write history index");
+        return false;
+    }
+
+    IndexHeader header = {INDEX_MAGIC, sizeof(BrewSession), (uint32_t)sessions.size()};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !sessions.empty()) {
+        ok = fwrite(sessions.data(), sizeof(BrewSession), sessions.size(), file) == sessions.size();
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(INDEX_TMP_FILE, INDEX_FILE) != 0) {
+        ESP_LOGE(TAG, "Unable to write history index");
+        remove(INDEX_TMP_FILE);
+        return false;
+    }
+
+    return true;
+}
+
+bool HistoryStore::AppendChunk(uint32_t sessionId, const vector<uint8_t>& chunk)
+{
+    if (!this->mounted || chunk.empty() || chunk.size() > UINT16_MAX) {
+        return false;
+    }
+
+    FILE *file = fopen(this->sessionPath(sessionId).c_str(), "ab");
+    if (file == NULL) {
+        ESP_LOGE(TAG, "Unable to open data of session %lu", (unsigned long)sessionId);
+        return false;
+    }
+
+    uint16_t length = chunk.size();
+    bool ok = fwrite(&length, sizeof(length), 1, file) == 1 && fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Unable to append data of session %lu", (unsigned long)sessionId);
+    }
+
+    return ok;
+}
+
+bool HistoryStore::ForEachChunk(uint32_t sessionId, const function<void(const vector<uint8_t>&)>& callback)
+{
+    if (!this->mounted) {
+        return false;
+    }
+
+    FILE *file = fopen(this->sessionPath(sessionId).c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    vector<uint8_t> chunk;
+    uint16_t length;
+    while (fread(&length, sizeof(length), 1, file) == 1) {
+        chunk.resize(length);
+        if (fread(chunk.data(), 1, length, file) != length) {
+            // the last append was interrupted, everything before it is fine
+            ESP_LOGW(TAG, "Data of session %lu ends with a partial chunk", (unsigned long)sessionId);
+            break;
+        }
+        callback(chunk);
+    }
+
+    fclose(file);
+    return true;
+}
+
+void HistoryStore::RemoveSession(uint32_t sessionId)
+{
+    if (!this->mounted) {
+        return;
+    }
+
+    remove(this->sessionPath(sessionId).c_str());
+}
+
+void HistoryStore::GetUsage(size_t& total, size_t& used)
+{
+    total = 0;
+    used = 0;
+
+    if (this->mounted) {
+        esp_littlefs_info(PARTITION_LABEL, &total, &used);
+    }
+}
@@ -0,0 +1,43 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_HISTORYSTORE_H
+#define INCLUDE_HISTORYSTORE_H
+
+#include "esp_log.h"
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+struct BrewSession;
+
+// File backed storage for the session history on the littlefs "storage" partition.
+// index.bin holds all session records and is replaced atomically, every session has an append only
+// file with its encoded data chunks, each prefixed with its length.
+class HistoryStore
+{
+private:
+    bool mounted = false;
+
+    string sessionPath(uint32_t sessionId);
+
+public:
+    bool Mount();
+    bool IsMounted() { return mounted; }
+
+    bool LoadIndex(vector<BrewSession>& sessions);
+    bool SaveIndex(const vector<BrewSession>& sessions);
+
+    bool AppendChunk(uint32_t sessionId, const vector<uint8_t>& chunk);
+    bool ForEachChunk(uint32_t sessionId, const function<void(const vector<uint8_t>&)>& callback);
+    void RemoveSession(uint32_t sessionId);
+
+    void GetUsage(size_t& total, size_t& used);
+};
+
+#endif /* INCLUDE_HISTORYSTORE_H */
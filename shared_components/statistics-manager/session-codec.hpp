@@ -0,0 +1,153 @@
+/*
+ * esp-brew-engine
+ * Copyright (C) Dekien Jeroen 2024
+ *
+ */
+#ifndef INCLUDE_SESSIONCODEC_HPP_
+#define INCLUDE_SESSIONCODEC_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <ctime>
+
+using namespace std;
+
+struct TempDataPoint {
+    time_t timestamp;
+    int8_t avgTemp;
+    int8_t targetTemp;
+    uint8_t pidOutput;
+};
+
+// Compact encoding of a chunk of session data points.
+// Layout: varint first timestamp, varint interval, varint count, then per point a flag byte telling which fields
+// differ from the previous point, followed by the zigzag varint deltas of those fields only.
+// Time is stored as the deviation from the interval, so a steady mash rest costs 1 or 2 bytes per point.
+class SessionCodec
+{
+private:
+    static const uint8_t FLAG_TIME = 0x01;
+    static const uint8_t FLAG_AVG = 0x02;
+    static const uint8_t FLAG_TARGET = 0x04;
+    static const uint8_t FLAG_OUTPUT = 0x08;
+
+    static void putVarint(vector<uint8_t> &out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    static bool getVarint(const vector<uint8_t> &in, size_t &pos, uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= in.size()) {
+                return false;
+            }
+            uint8_t byte = in[pos++];
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void putSigned(vector<uint8_t> &out, int64_t value)
+    {
+        putVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    static bool getSigned(const vector<uint8_t> &in, size_t &pos, int64_t &value)
+    {
+        uint64_t raw;
+        if (!getVarint(in, pos, raw)) {
+            return false;
+        }
+        value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+        return true;
+    }
+
+public:
+    static vector<uint8_t> Encode(const vector<TempDataPoint> &points)
+    {
+        vector<uint8_t> out;
+        if (points.empty()) {
+            return out;
+        }
+
+        int64_t interval = (points.size() > 1) ? points[1].timestamp - points[0].timestamp : 0;
+        if (interval < 0) {
+            interval = 0;
+        }
+
+        putVarint(out, (uint64_t)points[0].timestamp);
+        putVarint(out, (uint64_t)interval);
+        putVarint(out, points.size());
+
+        // the first point is encoded against an imaginary point one interval earlier with all values 0
+        TempDataPoint previous = {points[0].timestamp - interval, 0, 0, 0};
+
+        for (const auto &point : points) {
+            int64_t timeDelta = (int64_t)(point.timestamp - previous.timestamp) - interval;
+
+            uint8_t flags = 0;
+            if (timeDelta != 0) flags |= FLAG_TIME;
+            if (point.avgTemp != previous.avgTemp) flags |= FLAG_AVG;
+            if (point.targetTemp != previous.targetTemp) flags |= FLAG_TARGET;
+            if (point.pidOutput != previous.pidOutput) flags |= FLAG_OUTPUT;
+
+            out.push_back(flags);
+            if (flags & FLAG_TIME) putSigned(out, timeDelta);
+            if (flags & FLAG_AVG) putSigned(out, (int64_t)point.avgTemp - previous.avgTemp);
+            if (flags & FLAG_TARGET) putSigned(out, (int64_t)point.targetTemp - previous.targetTemp);
+            if (flags & FLAG_OUTPUT) putSigned(out, (int64_t)point.pidOutput - previous.pidOutput);
+
+            previous = point;
+        }
+
+        return out;
+    }
+
+    // appends the decoded points, returns false when the chunk is corrupt (the points up to there are kept)
+    static bool Decode(const vector<uint8_t> &in, vector<TempDataPoint> &points)
+    {
+        size_t pos = 0;
+        uint64_t first, interval, count;
+
+        if (!getVarint(in, pos, first) || !getVarint(in, pos, interval) || !getVarint(in, pos, count)) {
+            return false;
+        }
+
+        TempDataPoint previous = {(time_t)(first - interval), 0, 0, 0};
+
+        for (uint64_t i = 0; i < count; i++) {
+            if (pos >= in.size()) {
+                return false;
+            }
+            uint8_t flags = in[pos++];
+
+            int64_t timeDelta = 0, avgDelta = 0, targetDelta = 0, outputDelta = 0;
+            if ((flags & FLAG_TIME) && !getSigned(in, pos, timeDelta)) return false;
+            if ((flags & FLAG_AVG) && !getSigned(in, pos, avgDelta)) return false;
+            if ((flags & FLAG_TARGET) && !getSigned(in, pos, targetDelta)) return false;
+            if ((flags & FLAG_OUTPUT) && !getSigned(in, pos, outputDelta)) return false;
+
+            TempDataPoint point;
+            point.timestamp = previous.timestamp + (time_t)interval + (time_t)timeDelta;
+            point.avgTemp = (int8_t)(previous.avgTemp + avgDelta);
+            point.targetTemp = (int8_t)(previous.targetTemp + targetDelta);
+            point.pidOutput = (uint8_t)(previous.pidOutput + outputDelta);
+
+            points.push_back(point);
+            previous = point;
+        }
+
+        return true;
+    }
+};
+
+#endif /* INCLUDE_SESSIONCODEC_HPP_ */
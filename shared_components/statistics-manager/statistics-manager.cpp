@@ -4,8 +4,8 @@
  */
 #include "statistics-manager.h"
 #include <algorithm>
-#include <sstream>
-#include <iomanip>
+#include <cstdarg>
+#include <cstdio>
 
 using namespace std;
 
@@ -21,8 +21,11 @@ StatisticsManager::StatisticsManager(SettingsManager* settings)
     this->settingsManager = settings;
     this->sessionActive = false;
     this->currentSessionId = 0;
-    this->currentSessionData.clear();
+    this->currentChunk.clear();
     this->currentScheduleName = "";
+    this->currentSession = {};
+    this->currentSessionSum = 0;
+    this->sessionMutex = xSemaphoreCreateRecursiveMutex(); // recursive, starting a session can end the previous one
 }
 
 void StatisticsManager::Init()
@@ -37,6 +40,18 @@ void StatisticsManager::Init()
     }
     
     ESP_LOGI(TAG, "Max sessions: %d", maxSessions);
+    
+    this->sessionsMutex = xSemaphoreCreateMutex();
+    
+    if (!this->historyStore.Mount()) {
+        ESP_LOGE(TAG, "No history partition, sessions will not be stored");
+        return;
+    }
+    
+    this->historyStore.LoadIndex(this->sessions);
+    ESP_LOGI(TAG, "Loaded %d sessions from history", this->sessions.size());
+    
+    this->migrateNvsSessions();
 }
 
 uint32_t StatisticsManager::getNextSessionId()
@@ -48,6 +63,8 @@ uint32_t StatisticsManager::getNextSessionId()
 
 void StatisticsManager::StartSession(const string& scheduleName)
 {
+    xSemaphoreTakeRecursive(this->sessionMutex, portMAX_DELAY);
+    
     if (this->sessionActive) {
         ESP_LOGW(TAG, "Session already active, ending previous session");
         this->EndSession();
@@ -56,67 +73,98 @@ void StatisticsManager::StartSession(const string& scheduleName)
     this->currentSessionId = this->getNextSessionId();
     this->sessionActive = true;
     this->sessionStartTime = time(nullptr);
-    this->currentSessionData.clear();
+    this->currentChunk.clear();
+    this->currentChunk.reserve(SESSION_CHUNK_POINTS);
     this->currentScheduleName = scheduleName;
+    this->currentSessionSum = 0;
+    
+    // the session record exists from the start, so a reboot keeps everything up to the last stored chunk
+    this->currentSession = {};
+    this->currentSession.sessionId = this->currentSessionId;
+    this->currentSession.startTime = this->sessionStartTime;
+    this->currentSession.endTime = this->sessionStartTime;
+    this->currentSession.completed = false;
+    this->currentSession.dataFormat = 1;
+    strncpy(this->currentSession.scheduleName, scheduleName.c_str(), sizeof(this->currentSession.scheduleName) - 1);
+    this->currentSession.scheduleName[sizeof(this->currentSession.scheduleName) - 1] = '\0';
+    this->storeSession(this->currentSession);
+    
+    // Cleanup old sessions if needed
+    this->cleanupOldSessions();
     
     ESP_LOGI(TAG, "Started session %d with schedule: %s", this->currentSessionId, scheduleName.c_str());
+    
+    xSemaphoreGiveRecursive(this->sessionMutex);
 }
 
 void StatisticsManager::EndSession()
 {
+    xSemaphoreTakeRecursive(this->sessionMutex, portMAX_DELAY);
+    
     if (!this->sessionActive) {
         ESP_LOGW(TAG, "No active session to end");
+        xSemaphoreGiveRecursive(this->sessionMutex);
         return;
     }
     
-    time_t endTime = time(nullptr);
+    this->storeCurrentChunk();
     
-    // Create session record
-    BrewSession session;
-    session.sessionId = this->currentSessionId;
-    session.startTime = this->sessionStartTime;
-    session.endTime = endTime;
-    session.dataPoints = this->currentSessionData.size();
-    session.totalDuration = endTime - this->sessionStartTime;
-    session.completed = true;
-    
-    // Copy schedule name
-    strncpy(session.scheduleName, this->currentScheduleName.c_str(), sizeof(session.scheduleName) - 1);
-    session.scheduleName[sizeof(session.scheduleName) - 1] = '\0';
-    
-    // Calculate statistics
-    this->calculateSessionStats(session, this->currentSessionData);
-    
-    // Store session metadata
-    string sessionKey = "session_" + to_string(this->currentSessionId);
-    vector<uint8_t> sessionData(reinterpret_cast<uint8_t*>(&session), 
-                                reinterpret_cast<uint8_t*>(&session) + sizeof(BrewSession));
-    this->settingsManager->Write(sessionKey, sessionData);
-    
-    // Store temperature data
-    this->compressAndStoreSessionData(this->currentSessionId, this->currentSessionData);
-    
-    // Update session count
-    uint16_t sessionCount = this->settingsManager->Read(SESSION_COUNT_KEY, (uint16_t)0);
-    sessionCount++;
-    this->settingsManager->Write(SESSION_COUNT_KEY, sessionCount);
+    time_t endTime = time(nullptr);
+    this->currentSession.endTime = endTime;
+    this->currentSession.totalDuration = endTime - this->sessionStartTime;
+    this->currentSession.completed = true;
+    this->storeSession(this->currentSession);
     
     ESP_LOGI(TAG, "Ended session %d, duration: %d seconds, data points: %d", 
-             this->currentSessionId, session.totalDuration, session.dataPoints);
-    
-    // Cleanup old sessions if needed
-    this->cleanupOldSessions();
+             this->currentSessionId, this->currentSession.totalDuration, this->currentSession.dataPoints);
     
     // Reset current session
     this->sessionActive = false;
     this->currentSessionId = 0;
-    this->currentSessionData.clear();
+    this->currentChunk.clear();
     this->currentScheduleName = "";
+    this->currentSession = {};
+    
+    xSemaphoreGiveRecursive(this->sessionMutex);
+}
+
+bool StatisticsManager::ResumeSession(uint32_t sessionId)
+{
+    BrewSession session;
+    if (!this->readSession(sessionId, session) || session.completed || session.dataFormat != 1) {
+        ESP_LOGW(TAG, "Session %d can't be resumed", sessionId);
+        return false;
+    }
+    
+    xSemaphoreTakeRecursive(this->sessionMutex, portMAX_DELAY);
+    
+    if (this->sessionActive) {
+        this->EndSession();
+    }
+    
+    // the stored chunks stay as they are, new points are appended as the next chunks
+    this->currentSession = session;
+    this->currentSessionId = session.sessionId;
+    this->sessionActive = true;
+    this->sessionStartTime = session.startTime;
+    this->currentScheduleName = session.scheduleName;
+    this->currentSessionSum = session.avgTemperature * session.dataPoints;
+    this->currentChunk.clear();
+    this->currentChunk.reserve(SESSION_CHUNK_POINTS);
+    
+    ESP_LOGI(TAG, "Resumed session %d with %d data points", sessionId, session.dataPoints);
+    
+    xSemaphoreGiveRecursive(this->sessionMutex);
+    
+    return true;
 }
 
 void StatisticsManager::AddDataPoint(time_t timestamp, int8_t avgTemp, int8_t targetTemp, uint8_t pidOutput)
 {
+    xSemaphoreTakeRecursive(this->sessionMutex, portMAX_DELAY);
+    
     if (!this->sessionActive) {
+        xSemaphoreGiveRecursive(this->sessionMutex);
         return;
     }
     
@@ -126,159 +174,296 @@ void StatisticsManager::AddDataPoint(time_t timestamp, int8_t avgTemp, int8_t ta
     dataPoint.targetTemp = targetTemp;
     dataPoint.pidOutput = pidOutput;
     
-    this->currentSessionData.push_back(dataPoint);
+    this->currentChunk.push_back(dataPoint);
     
     ESP_LOGD(TAG, "Added data point: temp=%d, target=%d, output=%d", avgTemp, targetTemp, pidOutput);
+    
+    if (this->currentChunk.size() >= SESSION_CHUNK_POINTS) {
+        this->storeCurrentChunk();
+    }
+    
+    xSemaphoreGiveRecursive(this->sessionMutex);
 }
 
-void StatisticsManager::calculateSessionStats(BrewSession& session, const vector<TempDataPoint>& data)
+// Appends the pending points as the next chunk and updates the session record with the running statistics
+void StatisticsManager::storeCurrentChunk()
 {
-    if (data.empty()) {
-        session.avgTemperature = 0;
-        session.maxTemperature = 0;
-        session.minTemperature = 0;
+    xSemaphoreTakeRecursive(this->sessionMutex, portMAX_DELAY);
+    
+    if (this->currentChunk.empty()) {
+        xSemaphoreGiveRecursive(this->sessionMutex);
         return;
     }
     
-    float sum = 0;
-    int8_t minTemp = data[0].avgTemp;
-    int8_t maxTemp = data[0].avgTemp;
+    BrewSession& session = this->currentSession;
     
-    for (const auto& point : data) {
-        sum += point.avgTemp;
-        minTemp = min(minTemp, point.avgTemp);
-        maxTemp = max(maxTemp, point.avgTemp);
+    for (const auto& point : this->currentChunk) {
+        if (session.dataPoints == 0) {
+            session.minTemperature = point.avgTemp;
+            session.maxTemperature = point.avgTemp;
+        }
+        this->currentSessionSum += point.avgTemp;
+        session.minTemperature = min(session.minTemperature, (float)point.avgTemp);
+        session.maxTemperature = max(session.maxTemperature, (float)point.avgTemp);
+        session.dataPoints++;
     }
+    session.avgTemperature = this->currentSessionSum / session.dataPoints;
+    session.endTime = this->currentChunk.back().timestamp;
+    session.totalDuration = session.endTime - session.startTime;
+    
+    vector<uint8_t> encoded = SessionCodec::Encode(this->currentChunk);
+    this->historyStore.AppendChunk(session.sessionId, encoded);
+    this->storeSession(session);
+    
+    ESP_LOGD(TAG, "Stored chunk of session %d: %d points in %d bytes", session.sessionId, this->currentChunk.size(), encoded.size());
+    
+    this->currentChunk.clear();
     
-    session.avgTemperature = sum / data.size();
-    session.minTemperature = minTemp;
-    session.maxTemperature = maxTemp;
+    xSemaphoreGiveRecursive(this->sessionMutex);
 }
 
-void StatisticsManager::compressAndStoreSessionData(uint32_t sessionId, const vector<TempDataPoint>& data)
+// adds or replaces the record in the index
+void StatisticsManager::storeSession(const BrewSession& session)
 {
-    if (data.empty()) {
-        return;
-    }
+    xSemaphoreTake(this->sessionsMutex, portMAX_DELAY);
+    
+    auto pos = find_if(this->sessions.begin(), this->sessions.end(), [&session](const BrewSession& s) {
+        return s.sessionId == session.sessionId;
+    });
     
-    // Simple compression: store as binary blob
-    string dataKey = "data_" + to_string(sessionId);
-    vector<uint8_t> binaryData(reinterpret_cast<const uint8_t*>(data.data()),
-                               reinterpret_cast<const uint8_t*>(data.data()) + data.size() * sizeof(TempDataPoint));
+    if (pos == this->sessions.end()) {
+        this->sessions.push_back(session);
+    }
+    else {
+        *pos = session;
+    }
     
-    this->settingsManager->Write(dataKey, binaryData);
+    this->historyStore.SaveIndex(this->sessions);
     
-    ESP_LOGD(TAG, "Stored %d data points for session %d", data.size(), sessionId);
+    xSemaphoreGive(this->sessionsMutex);
 }
 
-vector<TempDataPoint> StatisticsManager::loadAndDecompressSessionData(uint32_t sessionId)
+bool StatisticsManager::readSession(uint32_t sessionId, BrewSession& session)
 {
-    string dataKey = "data_" + to_string(sessionId);
-    vector<uint8_t> defaultData;
-    vector<uint8_t> binaryData = this->settingsManager->Read(dataKey, defaultData);
+    session = {};
+    
+    xSemaphoreTake(this->sessionsMutex, portMAX_DELAY);
     
-    if (binaryData.empty()) {
-        return vector<TempDataPoint>();
+    for (const auto& s : this->sessions) {
+        if (s.sessionId == sessionId) {
+            session = s;
+            break;
+        }
     }
     
-    size_t dataPointCount = binaryData.size() / sizeof(TempDataPoint);
-    vector<TempDataPoint> data(dataPointCount);
+    xSemaphoreGive(this->sessionsMutex);
+    
+    return session.sessionId != 0;
+}
+
+// Decodes the session one chunk at a time, so only one chunk is in memory
+bool StatisticsManager::forEachDataPoint(uint32_t sessionId, const function<void(const TempDataPoint&)>& callback)
+{
+    BrewSession session;
+    if (!this->readSession(sessionId, session)) {
+        return false;
+    }
     
-    memcpy(data.data(), binaryData.data(), binaryData.size());
+    vector<TempDataPoint> points;
+    points.reserve(SESSION_CHUNK_POINTS);
     
-    ESP_LOGD(TAG, "Loaded %d data points for session %d", dataPointCount, sessionId);
+    this->historyStore.ForEachChunk(sessionId, [&](const vector<uint8_t>& encoded) {
+        points.clear();
+        if (!SessionCodec::Decode(encoded, points)) {
+            ESP_LOGW(TAG, "Corrupt chunk in session %d", sessionId);
+        }
+        
+        for (const auto& point : points) {
+            callback(point);
+        }
+    });
     
-    return data;
+    return true;
+}
+
+void StatisticsManager::eraseSession(uint32_t sessionId)
+{
+    this->historyStore.RemoveSession(sessionId);
+    
+    xSemaphoreTake(this->sessionsMutex, portMAX_DELAY);
+    
+    this->sessions.erase(remove_if(this->sessions.begin(), this->sessions.end(), [sessionId](const BrewSession& s) {
+        return s.sessionId == sessionId;
+    }), this->sessions.end());
+    
+    this->historyStore.SaveIndex(this->sessions);
+    
+    xSemaphoreGive(this->sessionsMutex);
 }
 
 void StatisticsManager::cleanupOldSessions()
 {
     uint8_t maxSessions = this->GetMaxSessions();
-    uint16_t sessionCount = this->settingsManager->Read(SESSION_COUNT_KEY, (uint16_t)0);
+    vector<BrewSession> sessions = this->GetSessionList();
     
-    if (sessionCount <= maxSessions) {
+    if (sessions.size() <= maxSessions) {
         return;
     }
     
-    ESP_LOGI(TAG, "Cleaning up old sessions, current count: %d, max: %d", sessionCount, maxSessions);
+    ESP_LOGI(TAG, "Cleaning up old sessions, current count: %d, max: %d", sessions.size(), maxSessions);
     
-    // Get all sessions and sort by start time
-    vector<BrewSession> sessions = this->GetSessionList();
+    // Oldest first
     sort(sessions.begin(), sessions.end(), [](const BrewSession& a, const BrewSession& b) {
         return a.startTime < b.startTime;
     });
     
-    // Remove oldest sessions
-    size_t sessionsToRemove = sessionCount - maxSessions;
+    // Remove oldest sessions, never the one that is running
+    size_t sessionsToRemove = sessions.size() - maxSessions;
     for (size_t i = 0; i < sessionsToRemove && i < sessions.size(); i++) {
         uint32_t sessionId = sessions[i].sessionId;
         
-        // Remove session metadata
-        string sessionKey = "session_" + to_string(sessionId);
-        // Note: NVS doesn't have a direct delete function, so we'll overwrite with empty data
-        vector<uint8_t> emptyData;
-        this->settingsManager->Write(sessionKey, emptyData);
+        if (this->sessionActive && sessionId == this->currentSessionId) {
+            continue;
+        }
         
-        // Remove session data
-        string dataKey = "data_" + to_string(sessionId);
-        this->settingsManager->Write(dataKey, emptyData);
+        this->eraseSession(sessionId);
         
         ESP_LOGD(TAG, "Removed session %d", sessionId);
     }
-    
-    // Update session count
-    this->settingsManager->Write(SESSION_COUNT_KEY, (uint16_t)maxSessions);
 }
 
 vector<BrewSession> StatisticsManager::GetSessionList()
 {
-    vector<BrewSession> sessions;
-    uint16_t sessionCount = this->settingsManager->Read(SESSION_COUNT_KEY, (uint16_t)0);
+    xSemaphoreTake(this->sessionsMutex, portMAX_DELAY);
+    vector<BrewSession> sessions = this->sessions;
+    xSemaphoreGive(this->sessionsMutex);
+    
+    // Sort by start time (newest first)
+    sort(sessions.begin(), sessions.end(), [](const BrewSession& a, const BrewSession& b) {
+        return a.startTime > b.startTime;
+    });
+    
+    return sessions;
+}
+
+BrewSession StatisticsManager::GetSessionById(uint32_t sessionId)
+{
+    BrewSession session;
+    this->readSession(sessionId, session);
     
+    return session;
+}
+
+vector<TempDataPoint> StatisticsManager::GetSessionData(uint32_t sessionId)
+{
+    vector<TempDataPoint> data;
+    this->forEachDataPoint(sessionId, [&data](const TempDataPoint& point) { data.push_back(point); });
+    
+    return data;
+}
+
+void StatisticsManager::migrateNvsSessions()
+{
+    uint16_t sessionCount = this->settingsManager->Read(SESSION_COUNT_KEY, (uint16_t)0);
     if (sessionCount == 0) {
-        return sessions;
+        return;
     }
     
-    // Try to load all possible sessions (inefficient but works with NVS limitations)
+    ESP_LOGI(TAG, "Moving %d sessions from nvs to the history partition", sessionCount);
+    
     uint32_t maxSessionId = this->settingsManager->Read(SESSION_ID_KEY, (uint16_t)1);
     
     for (uint32_t id = 1; id < maxSessionId; id++) {
-        string sessionKey = "session_" + to_string(id);
-        vector<uint8_t> defaultData;
-        vector<uint8_t> sessionData = this->settingsManager->Read(sessionKey, defaultData);
+        BrewSession session;
+        if (!this->readNvsSession(id, session)) {
+            continue;
+        }
+        
+        vector<TempDataPoint> chunk;
+        chunk.reserve(SESSION_CHUNK_POINTS);
         
-        if (!sessionData.empty() && sessionData.size() >= sizeof(BrewSession)) {
-            BrewSession session;
-            memcpy(&session, sessionData.data(), sizeof(BrewSession));
-            sessions.push_back(session);
+        this->forEachNvsDataPoint(session, [&](const TempDataPoint& point) {
+            chunk.push_back(point);
+            if (chunk.size() >= SESSION_CHUNK_POINTS) {
+                this->historyStore.AppendChunk(id, SessionCodec::Encode(chunk));
+                chunk.clear();
+            }
+        });
+        
+        if (!chunk.empty()) {
+            this->historyStore.AppendChunk(id, SessionCodec::Encode(chunk));
         }
+        
+        this->eraseNvsSession(session);
+        
+        session.dataFormat = 1;
+        this->storeSession(session);
     }
     
-    // Sort by start time (newest first)
-    sort(sessions.begin(), sessions.end(), [](const BrewSession& a, const BrewSession& b) {
-        return a.startTime > b.startTime;
-    });
-    
-    return sessions;
+    this->settingsManager->Write(SESSION_COUNT_KEY, (uint16_t)0);
 }
 
-BrewSession StatisticsManager::GetSessionById(uint32_t sessionId)
+// records of older firmware are shorter (no dataFormat), the missing fields stay 0
+bool StatisticsManager::readNvsSession(uint32_t sessionId, BrewSession& session)
 {
     string sessionKey = "session_" + to_string(sessionId);
     vector<uint8_t> defaultData;
     vector<uint8_t> sessionData = this->settingsManager->Read(sessionKey, defaultData);
     
-    BrewSession session = {};
-    if (!sessionData.empty() && sessionData.size() >= sizeof(BrewSession)) {
-        memcpy(&session, sessionData.data(), sizeof(BrewSession));
+    session = {};
+    if (sessionData.size() < offsetof(BrewSession, dataFormat)) {
+        this->settingsManager->Erase(sessionKey);
+        return false;
     }
     
-    return session;
+    memcpy(&session, sessionData.data(), min(sessionData.size(), sizeof(BrewSession)));
+    session.sessionId = sessionId;
+    return true;
 }
 
-vector<TempDataPoint> StatisticsManager::GetSessionData(uint32_t sessionId)
+void StatisticsManager::forEachNvsDataPoint(const BrewSession& session, const function<void(const TempDataPoint&)>& callback)
 {
-    return this->loadAndDecompressSessionData(sessionId);
+    vector<uint8_t> defaultData;
+    
+    if (session.dataFormat == 0) {
+        // raw TempDataPoint array
+        vector<uint8_t> binaryData = this->settingsManager->Read("data_" + to_string(session.sessionId), defaultData);
+        size_t dataPointCount = binaryData.size() / sizeof(TempDataPoint);
+        for (size_t i = 0; i < dataPointCount; i++) {
+            TempDataPoint point;
+            memcpy(&point, binaryData.data() + i * sizeof(TempDataPoint), sizeof(TempDataPoint));
+            callback(point);
+        }
+        return;
+    }
+    
+    uint16_t chunkCount = (session.dataPoints + SESSION_CHUNK_POINTS - 1) / SESSION_CHUNK_POINTS;
+    vector<TempDataPoint> points;
+    
+    for (uint16_t chunk = 0; chunk < chunkCount; chunk++) {
+        vector<uint8_t> encoded = this->settingsManager->Read("data_" + to_string(session.sessionId) + "_" + to_string(chunk), defaultData);
+        
+        points.clear();
+        SessionCodec::Decode(encoded, points);
+        for (const auto& point : points) {
+            callback(point);
+        }
+    }
+}
+
+void StatisticsManager::eraseNvsSession(const BrewSession& session)
+{
+    if (session.dataFormat == 0) {
+        this->settingsManager->Erase("data_" + to_string(session.sessionId));
+    }
+    else {
+        uint16_t chunkCount = (session.dataPoints + SESSION_CHUNK_POINTS - 1) / SESSION_CHUNK_POINTS;
+        for (uint16_t chunk = 0; chunk < chunkCount; chunk++) {
+            this->settingsManager->Erase("data_" + to_string(session.sessionId) + "_" + to_string(chunk));
+        }
+    }
+    
+    this->settingsManager->Erase("session_" + to_string(session.sessionId));
 }
 
 map<string, uint32_t> StatisticsManager::GetSessionStats()
@@ -307,6 +492,9 @@ void StatisticsManager::SetMaxSessions(uint8_t maxSessions)
     if (maxSessions == 0) {
         maxSessions = DEFAULT_MAX_SESSIONS;
     }
+    if (maxSessions > SESSION_MAX_SESSIONS) {
+        maxSessions = SESSION_MAX_SESSIONS;
+    }
     
     this->settingsManager->Write(MAX_SESSIONS_KEY, maxSessions);
     ESP_LOGI(TAG, "Set max sessions to: %d", maxSessions);
@@ -320,93 +508,148 @@ uint8_t StatisticsManager::GetMaxSessions()
     return this->settingsManager->Read(MAX_SESSIONS_KEY, DEFAULT_MAX_SESSIONS);
 }
 
+// Formats export rows straight into a fixed buffer and passes it on to the writer when it is full, so an export doesn't
+// need a heap string per row
+class ExportBuffer
+{
+private:
+    const ExportWriter &write;
+    char data[EXPORT_CHUNK_SIZE];
+    size_t used = 0;
+
+public:
+    ExportBuffer(const ExportWriter &write) : write(write) {}
+    ~ExportBuffer() { this->flush(); }
+
+    void flush()
+    {
+        if (used > 0) {
+            write(data, used);
+            used = 0;
+        }
+    }
+
+    __attribute__((format(printf, 2, 3))) void append(const char *format, ...)
+    {
+        for (int attempt = 0; attempt < 2; attempt++) {
+            va_list args;
+            va_start(args, format);
+            int length = vsnprintf(data + used, sizeof(data) - used, format, args);
+            va_end(args);
+
+            if (length < 0) {
+                return;
+            }
+            if ((size_t)length < sizeof(data) - used) {
+                used += length;
+                return;
+            }
+
+            // didn't fit, send what we have and format again into the empty buffer, rows are far smaller than the buffer
+            this->flush();
+        }
+    }
+};
+
 string StatisticsManager::ExportSessionToJson(uint32_t sessionId)
+{
+    string result;
+    if (!this->ExportSessionToJson(sessionId, [&result](const char *data, size_t length) { result.append(data, length); })) {
+        return "{}";
+    }
+    
+    return result;
+}
+
+bool StatisticsManager::ExportSessionToJson(uint32_t sessionId, const ExportWriter &write, uint16_t step)
 {
     BrewSession session = this->GetSessionById(sessionId);
-    vector<TempDataPoint> data = this->GetSessionData(sessionId);
     
     if (session.sessionId == 0) {
-        return "{}";
+        return false;
     }
     
-    stringstream json;
-    json << "{";
-    json << "\"sessionId\":" << session.sessionId << ",";
-    json << "\"scheduleName\":\"" << session.scheduleName << "\",";
-    json << "\"startTime\":" << session.startTime << ",";
-    json << "\"endTime\":" << session.endTime << ",";
-    json << "\"duration\":" << session.totalDuration << ",";
-    json << "\"dataPoints\":" << session.dataPoints << ",";
-    json << "\"avgTemperature\":" << fixed << setprecision(1) << session.avgTemperature << ",";
-    json << "\"minTemperature\":" << (int)session.minTemperature << ",";
-    json << "\"maxTemperature\":" << (int)session.maxTemperature << ",";
-    json << "\"completed\":" << (session.completed ? "true" : "false") << ",";
-    json << "\"data\":[";
-    
-    for (size_t i = 0; i < data.size(); i++) {
-        if (i > 0) json << ",";
-        json << "{";
-        json << "\"timestamp\":" << data[i].timestamp << ",";
-        json << "\"avgTemp\":" << (int)data[i].avgTemp << ",";
-        json << "\"targetTemp\":" << (int)data[i].targetTemp << ",";
-        json << "\"pidOutput\":" << (int)data[i].pidOutput;
-        json << "}";
-    }
-    
-    json << "]}";
-    
-    return json.str();
+    ExportBuffer buffer(write);
+    buffer.append("{\"sessionId\":%lu,\"scheduleName\":\"%.32s\",\"startTime\":%lld,\"endTime\":%lld,\"duration\":%lu,\"dataPoints\":%u,",
+                  (unsigned long)session.sessionId, session.scheduleName, (long long)session.startTime, (long long)session.endTime,
+                  (unsigned long)session.totalDuration, (unsigned)session.dataPoints);
+    buffer.append("\"avgTemperature\":%.1f,\"minTemperature\":%d,\"maxTemperature\":%d,\"completed\":%s,\"data\":[",
+                  session.avgTemperature, (int)session.minTemperature, (int)session.maxTemperature, session.completed ? "true" : "false");
+    
+    bool first = true;
+    uint32_t index = 0;
+    this->forEachDataPoint(sessionId, [&](const TempDataPoint& point) {
+        if (step > 1 && (index++ % step) != 0) {
+            return;
+        }
+        buffer.append("%s{\"timestamp\":%lld,\"avgTemp\":%d,\"targetTemp\":%d,\"pidOutput\":%d}",
+                      first ? "" : ",", (long long)point.timestamp, (int)point.avgTemp, (int)point.targetTemp, (int)point.pidOutput);
+        first = false;
+    });
+    
+    buffer.append("]}");
+    
+    return true;
 }
 
 string StatisticsManager::ExportSessionToCsv(uint32_t sessionId)
+{
+    string result;
+    this->ExportSessionToCsv(sessionId, [&result](const char *data, size_t length) { result.append(data, length); });
+    
+    return result;
+}
+
+bool StatisticsManager::ExportSessionToCsv(uint32_t sessionId, const ExportWriter &write, uint16_t step)
 {
     BrewSession session = this->GetSessionById(sessionId);
-    vector<TempDataPoint> data = this->GetSessionData(sessionId);
     
-    if (session.sessionId == 0 || data.empty()) {
-        return "";
+    if (session.sessionId == 0) {
+        return false;
     }
     
-    stringstream csv;
-    csv << "Session ID,Schedule Name,Timestamp,Average Temp,Target Temp,PID Output\n";
-    
-    for (const auto& point : data) {
-        csv << session.sessionId << ",";
-        csv << "\"" << session.scheduleName << "\",";
-        csv << point.timestamp << ",";
-        csv << (int)point.avgTemp << ",";
-        csv << (int)point.targetTemp << ",";
-        csv << (int)point.pidOutput << "\n";
+    if (session.dataPoints == 0) {
+        return false;
     }
     
-    return csv.str();
+    ExportBuffer buffer(write);
+    buffer.append("Session ID,Schedule Name,Timestamp,Average Temp,Target Temp,PID Output\n");
+    
+    uint32_t index = 0;
+    this->forEachDataPoint(sessionId, [&](const TempDataPoint& point) {
+        if (step > 1 && (index++ % step) != 0) {
+            return;
+        }
+        buffer.append("%lu,\"%.32s\",%lld,%d,%d,%d\n", (unsigned long)session.sessionId, session.scheduleName,
+                      (long long)point.timestamp, (int)point.avgTemp, (int)point.targetTemp, (int)point.pidOutput);
+    });
+    
+    return true;
 }
 
 string StatisticsManager::ExportAllSessionsToJson()
+{
+    string result;
+    this->ExportAllSessionsToJson([&result](const char *data, size_t length) { result.append(data, length); });
+    
+    return result;
+}
+
+void StatisticsManager::ExportAllSessionsToJson(const ExportWriter &write)
 {
     vector<BrewSession> sessions = this->GetSessionList();
     
-    stringstream json;
-    json << "{\"sessions\":[";
+    ExportBuffer buffer(write);
+    buffer.append("{\"sessions\":[");
     
     for (size_t i = 0; i < sessions.size(); i++) {
-        if (i > 0) json << ",";
-        
-        json << "{";
-        json << "\"sessionId\":" << sessions[i].sessionId << ",";
-        json << "\"scheduleName\":\"" << sessions[i].scheduleName << "\",";
-        json << "\"startTime\":" << sessions[i].startTime << ",";
-        json << "\"endTime\":" << sessions[i].endTime << ",";
-        json << "\"duration\":" << sessions[i].totalDuration << ",";
-        json << "\"dataPoints\":" << sessions[i].dataPoints << ",";
-        json << "\"avgTemperature\":" << fixed << setprecision(1) << sessions[i].avgTemperature << ",";
-        json << "\"minTemperature\":" << (int)sessions[i].minTemperature << ",";
-        json << "\"maxTemperature\":" << (int)sessions[i].maxTemperature << ",";
-        json << "\"completed\":" << (sessions[i].completed ? "true" : "false");
-        json << "}";
-    }
-    
-    json << "]}";
-    
-    return json.str();
-}
\ No newline at end of file
+        const BrewSession &session = sessions[i];
+        buffer.append("%s{\"sessionId\":%lu,\"scheduleName\":\"%.32s\",\"startTime\":%lld,\"endTime\":%lld,\"duration\":%lu,\"dataPoints\":%u,",
+                      (i > 0) ? "," : "", (unsigned long)session.sessionId, session.scheduleName, (long long)session.startTime,
+                      (long long)session.endTime, (unsigned long)session.totalDuration, (unsigned)session.dataPoints);
+        buffer.append("\"avgTemperature\":%.1f,\"minTemperature\":%d,\"maxTemperature\":%d,\"completed\":%s}",
+                      session.avgTemperature, (int)session.minTemperature, (int)session.maxTemperature, session.completed ? "true" : "false");
+    }
+    
+    buffer.append("]}");
+}
@@ -12,19 +12,19 @@
 #include <vector>
 #include <map>
 #include <ctime>
+#include <functional>
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "nvs_handle.hpp"
 #include "settings-manager.h"
+#include "session-codec.hpp"
+#include "history-store.h"
+#include "freertos/semphr.h"
 
 using namespace std;
 
-struct TempDataPoint {
-    time_t timestamp;
-    int8_t avgTemp;
-    int8_t targetTemp;
-    uint8_t pidOutput;
-};
+// receives the export piece by piece, so callers can stream it without holding the full export
+typedef function<void(const char *data, size_t length)> ExportWriter;
 
 struct BrewSession {
     uint32_t sessionId;
@@ -37,8 +37,13 @@ struct BrewSession {
     float minTemperature;
     uint32_t totalDuration;
     bool completed;
+    uint32_t dataFormat; // 0: one raw nvs blob (older firmware), 1: SessionCodec chunks
 };
 
+#define SESSION_CHUNK_POINTS 100 // points per stored chunk, at one point per 3s a reboot loses at most 5 minutes
+#define SESSION_MAX_SESSIONS 100 // the history partition has room for far more, the index is kept in ram
+#define EXPORT_CHUNK_SIZE 512    // exports are formatted into a stack buffer of this size and handed to the writer when full
+
 class StatisticsManager
 {
 private:
@@ -46,14 +51,29 @@ private:
     uint32_t currentSessionId;
     bool sessionActive;
     time_t sessionStartTime;
-    vector<TempDataPoint> currentSessionData;
+    vector<TempDataPoint> currentChunk; // points not yet stored
     string currentScheduleName;
+    BrewSession currentSession;
+    float currentSessionSum;
+    
+    HistoryStore historyStore;
+    vector<BrewSession> sessions; // in memory copy of the history index
+    SemaphoreHandle_t sessionsMutex;
+    SemaphoreHandle_t sessionMutex; // the running session, points come from the read loop and start/end from the web server
     
     uint32_t getNextSessionId();
-    void compressAndStoreSessionData(uint32_t sessionId, const vector<TempDataPoint>& data);
-    vector<TempDataPoint> loadAndDecompressSessionData(uint32_t sessionId);
+    void storeCurrentChunk();
+    void storeSession(const BrewSession& session);
+    bool readSession(uint32_t sessionId, BrewSession& session);
+    bool forEachDataPoint(uint32_t sessionId, const function<void(const TempDataPoint&)>& callback);
+    void eraseSession(uint32_t sessionId);
     void cleanupOldSessions();
-    void calculateSessionStats(BrewSession& session, const vector<TempDataPoint>& data);
+    
+    // sessions of older firmware are kept in nvs, they are moved to the history partition once
+    void migrateNvsSessions();
+    bool readNvsSession(uint32_t sessionId, BrewSession& session);
+    void forEachNvsDataPoint(const BrewSession& session, const function<void(const TempDataPoint&)>& callback);
+    void eraseNvsSession(const BrewSession& session);
 
 public:
     StatisticsManager(SettingsManager* settings);
@@ -62,6 +82,7 @@ public:
     // Session management
     void StartSession(const string& scheduleName = "");
     void EndSession();
+    bool ResumeSession(uint32_t sessionId); // continues an unfinished session after a reset
     void AddDataPoint(time_t timestamp, int8_t avgTemp, int8_t targetTemp, uint8_t pidOutput);
     
     // Data retrieval
@@ -77,12 +98,15 @@ public:
     // Export functionality
     string ExportSessionToJson(uint32_t sessionId);
     string ExportSessionToCsv(uint32_t sessionId);
+    bool ExportSessionToJson(uint32_t sessionId, const ExportWriter &write, uint16_t step = 1); // step: only every n-th point
+    bool ExportSessionToCsv(uint32_t sessionId, const ExportWriter &write, uint16_t step = 1);
     string ExportAllSessionsToJson();
+    void ExportAllSessionsToJson(const ExportWriter &write);
     
     // Current session info
     bool IsSessionActive() { return sessionActive; }
     uint32_t GetCurrentSessionId() { return currentSessionId; }
-    uint16_t GetCurrentSessionDataPoints() { return currentSessionData.size(); }
+    uint16_t GetCurrentSessionDataPoints() { return currentSession.dataPoints; }
 };
 
 #endif /* INCLUDE_STATISTICSMANAGER_H */
\ No newline at end of file
@@ -8,6 +8,47 @@ export default class WebConn {
     this.rootUrl = rootUrl;
   }
 
+  // Opens the websocket push channel, onData gets the full Data fields first and after that only the changed ones.
+  // Reconnects until the returned function is called.
+  subscribe(onData: (data: any, snapshot: boolean) => void, onConnected: (connected: boolean) => void): () => void {
+    let socket: WebSocket | null = null;
+    let reconnectId: number | undefined;
+    let stopped = false;
+
+    const connect = () => {
+      const url = `${this.rootUrl}ws`.replace(/^http/, "ws");
+      socket = new WebSocket(url);
+
+      socket.onopen = () => {
+        onConnected(true);
+      };
+
+      socket.onmessage = (event) => {
+        try {
+          const message = JSON.parse(event.data);
+          onData(message.data, message.snapshot === true);
+        } catch (error) {
+          console.warn("Invalid push message:", error);
+        }
+      };
+
+      socket.onclose = () => {
+        onConnected(false);
+        if (!stopped) {
+          reconnectId = window.setTimeout(connect, 3000);
+        }
+      };
+    };
+
+    connect();
+
+    return () => {
+      stopped = true;
+      window.clearTimeout(reconnectId);
+      socket?.close();
+    };
+  }
+
   doPostRequest(data: any): Promise<IApiResult> {
     return new Promise((resolve, reject) => {
       const url = `${this.rootUrl}api`;
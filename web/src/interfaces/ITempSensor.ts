@@ -13,4 +13,11 @@ export interface ITempSensor {
   analogPin?: number; // Analog pin for NTC sensors (optional, only for NTC sensors)
   ntcResistance?: number; // NTC resistance at 25°C in ohms (optional, only for NTC sensors)
   dividerResistor?: number; // Voltage divider resistor value in ohms (optional, only for NTC sensors)
+  oversample?: number; // adc reads averaged per reading (optional, only for NTC sensors)
+  median: number; // median window for spike rejection, 1 = off
+  filter: number; // 0 = none, 1 = EMA, 2 = Kalman
+  filterAlpha: number; // EMA weight of a new reading
+  kalmanQ: number; // Kalman process noise
+  kalmanR: number; // Kalman measurement noise
+  weight: number; // share in the control temperature
 }